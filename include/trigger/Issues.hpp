@@ -36,6 +36,21 @@ ERS_DECLARE_ISSUE(trigger, TriggerEndOfRun, "End of run " << runno, ((int64_t)ru
 
 ERS_DECLARE_ISSUE(trigger, UnknownGeoID, "Unknown GeoID: " << geo_id, ((daqdataformats::GeoID)geo_id))
 ERS_DECLARE_ISSUE(trigger, InvalidSystemType, "Unknown system type " << type, ((std::string)type))
+ERS_DECLARE_ISSUE(trigger,
+                  LocalConnectionTypeMismatch,
+                  "Local connection " << uid << " already exists with a different data type",
+                  ((std::string)uid))
+ERS_DECLARE_ISSUE(trigger, BadTPSetWireData, "Can't decode TPSet wire data: " << reason, ((std::string)reason))
+ERS_DECLARE_ISSUE(trigger,
+                  BadTPBinaryFile,
+                  "Problem with TP binary file " << filename << ": " << reason,
+                  ((std::string)filename)((std::string)reason))
+ERS_DECLARE_ISSUE(trigger, BadReadoutMap, "Bad readout map: " << reason, ((std::string)reason))
+ERS_DECLARE_ISSUE(trigger,
+                  TriggerDecisionDropped,
+                  "Dropped trigger decision " << trigger_number << " in run " << runno
+                                              << ", as it couldn't be sent to the DFO in time",
+                  ((uint64_t)trigger_number)((int64_t)runno)) // NOLINT(build/unsigned)
 
 ERS_DECLARE_ISSUE_BASE(trigger,
                        SignalTypeError,
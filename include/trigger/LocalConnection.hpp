@@ -0,0 +1,341 @@
+/**
+ * @file LocalConnection.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_LOCALCONNECTION_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_LOCALCONNECTION_HPP_
+
+#include "trigger/Issues.hpp"
+#include "trigger/SPSCRingBuffer.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "iomanager/Receiver.hpp"
+#include "iomanager/Sender.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * Connections whose name starts with this don't go through iomanager: the
+ * modules at either end, which must be in the same application, are joined
+ * by SPSCRingBuffers instead
+ */
+constexpr const char* s_local_connection_prefix = "spsc:";
+
+// How many objects each sender to a local connection can have in flight
+constexpr size_t s_local_connection_capacity = 1024;
+
+inline bool
+is_local_connection(const std::string& uid)
+{
+  return uid.rfind(s_local_connection_prefix, 0) == 0;
+}
+
+/**
+ * @brief The receiving end of a connection between trigger modules
+ *
+ * Unlike iomanager's receivers, a timeout isn't an error, so an empty poll
+ * doesn't throw
+ */
+template<class T>
+class InputConnection
+{
+public:
+  virtual ~InputConnection() = default;
+
+  // Wait up to @a timeout for an object. Returns an empty optional if none arrived
+  virtual std::optional<T> try_receive(std::chrono::milliseconds timeout) = 0;
+};
+
+/**
+ * @brief The sending end of a connection between trigger modules
+ */
+template<class T>
+class OutputConnection
+{
+public:
+  virtual ~OutputConnection() = default;
+
+  // Wait up to @a timeout for room to send @a obj. Returns false, dropping @a obj, if there wasn't any
+  virtual bool try_send(T&& obj, std::chrono::milliseconds timeout) = 0;
+};
+
+/**
+ * @brief A connection between modules in one application, made of one
+ * SPSCRingBuffer per sender
+ *
+ * Each sender gets its own ring from add_sender(), so several modules can
+ * send to one connection, eg to a zipper, without the rings ever having more
+ * than one producer. There must be only one receiver, which takes from the
+ * rings in turn. When they are all empty, it waits on a condition variable
+ * that senders only notify if it is waiting, so a busy connection doesn't
+ * take any locks.
+ */
+template<class T>
+class LocalConnection
+{
+public:
+  explicit LocalConnection(size_t capacity)
+    : m_capacity(capacity)
+  {}
+
+  LocalConnection(const LocalConnection&) = delete;
+  LocalConnection& operator=(const LocalConnection&) = delete;
+  LocalConnection(LocalConnection&&) = delete;
+  LocalConnection& operator=(LocalConnection&&) = delete;
+
+  // Make a ring for a new sender. Any thread
+  std::shared_ptr<SPSCRingBuffer<T>> add_sender()
+  {
+    auto ring = std::make_shared<SPSCRingBuffer<T>>(m_capacity);
+    std::lock_guard<std::mutex> lk(m_rings_mutex);
+    m_rings.push_back(ring);
+    m_n_rings.store(m_rings.size(), std::memory_order_release);
+    return ring;
+  }
+
+  // Wake the receiver if it is waiting. Called by senders after each object they put in their ring
+  void notify()
+  {
+    // Pairs with the fence in try_receive(): either we see that the receiver
+    // is waiting, or it sees the object we've just sent
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_receiver_waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lk(m_wait_mutex);
+      m_wait_cv.notify_one();
+    }
+  }
+
+  // Receiver thread only
+  std::optional<T> try_receive(std::chrono::milliseconds timeout)
+  {
+    if (std::optional<T> obj = poll()) {
+      return obj;
+    }
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lk(m_wait_mutex);
+    while (true) {
+      m_receiver_waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      std::optional<T> obj = poll();
+      if (obj || m_wait_cv.wait_until(lk, deadline) == std::cv_status::timeout) {
+        m_receiver_waiting.store(false, std::memory_order_relaxed);
+        return obj ? std::move(obj) : poll();
+      }
+    }
+  }
+
+private:
+  // Take the next object from any ring, starting after the ring we last took from
+  std::optional<T> poll()
+  {
+    if (m_receiver_rings.size() != m_n_rings.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lk(m_rings_mutex);
+      m_receiver_rings = m_rings;
+    }
+    size_t const n_rings = m_receiver_rings.size();
+    for (size_t i = 0; i < n_rings; ++i) {
+      m_next_ring = (m_next_ring + 1) % n_rings;
+      if (std::optional<T> obj = m_receiver_rings[m_next_ring]->try_receive()) {
+        return obj;
+      }
+    }
+    return std::nullopt;
+  }
+
+  const size_t m_capacity;
+
+  std::mutex m_rings_mutex;
+  std::vector<std::shared_ptr<SPSCRingBuffer<T>>> m_rings;
+  std::atomic<size_t> m_n_rings{ 0 };
+
+  // The receiver's copy of m_rings, so that it only takes m_rings_mutex when a sender is added
+  std::vector<std::shared_ptr<SPSCRingBuffer<T>>> m_receiver_rings;
+  size_t m_next_ring{ 0 };
+
+  std::mutex m_wait_mutex;
+  std::condition_variable m_wait_cv;
+  std::atomic<bool> m_receiver_waiting{ false };
+};
+
+// The process-wide table of LocalConnections, keyed by connection name.
+// Non-template so that every data type shares one table
+class LocalConnectionRegistry
+{
+public:
+  static LocalConnectionRegistry& get()
+  {
+    static LocalConnectionRegistry registry;
+    return registry;
+  }
+
+  /**
+   * @brief Get the LocalConnection named @a uid, creating it if it doesn't exist yet
+   *
+   * This is how the sending and receiving modules find the same connection:
+   * both ask for it by name, from their init(), in whichever order. Asking
+   * for an existing name with a different data type throws LocalConnectionTypeMismatch
+   */
+  template<class T>
+  std::shared_ptr<LocalConnection<T>> get_connection(const std::string& uid)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    auto it = m_connections.find(uid);
+    if (it == m_connections.end()) {
+      auto connection = std::make_shared<LocalConnection<T>>(s_local_connection_capacity);
+      m_connections.emplace(uid, Entry{ std::type_index(typeid(T)), connection });
+      return connection;
+    }
+    if (it->second.type != std::type_index(typeid(T))) {
+      throw LocalConnectionTypeMismatch(ERS_HERE, uid);
+    }
+    return std::static_pointer_cast<LocalConnection<T>>(it->second.connection);
+  }
+
+private:
+  LocalConnectionRegistry() = default;
+
+  struct Entry
+  {
+    std::type_index type;
+    std::shared_ptr<void> connection;
+  };
+
+  std::mutex m_mutex;
+  std::map<std::string, Entry> m_connections;
+};
+
+template<class T>
+class LocalInputConnection : public InputConnection<T>
+{
+public:
+  explicit LocalInputConnection(std::shared_ptr<LocalConnection<T>> connection)
+    : m_connection(std::move(connection))
+  {}
+
+  std::optional<T> try_receive(std::chrono::milliseconds timeout) override
+  {
+    return m_connection->try_receive(timeout);
+  }
+
+private:
+  std::shared_ptr<LocalConnection<T>> m_connection;
+};
+
+template<class T>
+class LocalOutputConnection : public OutputConnection<T>
+{
+public:
+  explicit LocalOutputConnection(std::shared_ptr<LocalConnection<T>> connection)
+    : m_connection(std::move(connection))
+    , m_ring(m_connection->add_sender())
+  {}
+
+  bool try_send(T&& obj, std::chrono::milliseconds timeout) override
+  {
+    if (!m_ring->try_send(std::move(obj))) {
+      // Our ring only fills up when the receiver falls behind, so poll for room
+      auto const deadline = std::chrono::steady_clock::now() + timeout;
+      do {
+        if (std::chrono::steady_clock::now() >= deadline) {
+          return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+      } while (!m_ring->try_send(std::move(obj)));
+    }
+    m_connection->notify();
+    return true;
+  }
+
+private:
+  std::shared_ptr<LocalConnection<T>> m_connection;
+  std::shared_ptr<SPSCRingBuffer<T>> m_ring;
+};
+
+template<class T>
+class IOMInputConnection : public InputConnection<T>
+{
+public:
+  explicit IOMInputConnection(const std::string& uid)
+    : m_receiver(get_iom_receiver<T>(uid))
+  {}
+
+  std::optional<T> try_receive(std::chrono::milliseconds timeout) override { return m_receiver->try_receive(timeout); }
+
+private:
+  std::shared_ptr<iomanager::ReceiverConcept<T>> m_receiver;
+};
+
+template<class T>
+class IOMOutputConnection : public OutputConnection<T>
+{
+public:
+  explicit IOMOutputConnection(const std::string& uid)
+    : m_sender(get_iom_sender<T>(uid))
+  {}
+
+  bool try_send(T&& obj, std::chrono::milliseconds timeout) override
+  {
+    try {
+      m_sender->send(std::move(obj), timeout);
+    } catch (const iomanager::TimeoutExpired&) {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  std::shared_ptr<iomanager::SenderConcept<T>> m_sender;
+};
+
+/**
+ * @brief Get the receiving end of the connection named @a uid: a local
+ * connection if the name starts with s_local_connection_prefix, and an
+ * iomanager receiver otherwise
+ */
+template<class T>
+std::shared_ptr<InputConnection<T>>
+get_input_connection(const std::string& uid)
+{
+  if (is_local_connection(uid)) {
+    return std::make_shared<LocalInputConnection<T>>(LocalConnectionRegistry::get().get_connection<T>(uid));
+  }
+  return std::make_shared<IOMInputConnection<T>>(uid);
+}
+
+/**
+ * @brief Get a sending end of the connection named @a uid, as for get_input_connection()
+ *
+ * Each call to this for a local connection adds a sender to it, so call it
+ * once per sending module
+ */
+template<class T>
+std::shared_ptr<OutputConnection<T>>
+get_output_connection(const std::string& uid)
+{
+  if (is_local_connection(uid)) {
+    return std::make_shared<LocalOutputConnection<T>>(LocalConnectionRegistry::get().get_connection<T>(uid));
+  }
+  return std::make_shared<IOMOutputConnection<T>>(uid);
+}
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_LOCALCONNECTION_HPP_
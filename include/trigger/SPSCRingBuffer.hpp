@@ -0,0 +1,172 @@
+/**
+ * @file SPSCRingBuffer.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_SPSCRINGBUFFER_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_SPSCRINGBUFFER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief A bounded, lock-free single-producer/single-consumer ring buffer
+ *
+ * SPSCRingBuffer passes objects between two threads, eg the modules at
+ * either end of a LocalConnection, or PrefetchingTPSetSource's reader thread
+ * and the thread replaying its TPSets. Exactly one thread may call the
+ * try_send functions and exactly one thread may call the try_receive
+ * functions. None of the functions block or throw: an empty or full buffer
+ * is reported through the return value, so polling loops don't pay for
+ * exception unwinding.
+ *
+ * The capacity is rounded up to the next power of two.
+ */
+template<class T>
+class SPSCRingBuffer
+{
+public:
+  explicit SPSCRingBuffer(size_t capacity)
+    : m_slots(round_up_to_power_of_two(capacity))
+    , m_mask(m_slots.size() - 1)
+  {}
+
+  SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+  SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+  SPSCRingBuffer(SPSCRingBuffer&&) = delete;
+  SPSCRingBuffer& operator=(SPSCRingBuffer&&) = delete;
+
+  /**
+   * @brief Move @a item into the buffer. Producer thread only.
+   *
+   * Returns false, leaving @a item untouched, if the buffer is full
+   */
+  bool try_send(T&& item)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cached_head == m_slots.size()) {
+      m_cached_head = m_head.load(std::memory_order_acquire);
+      if (tail - m_cached_head == m_slots.size()) {
+        return false;
+      }
+    }
+    m_slots[tail & m_mask] = std::move(item);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Move as many items from [first, last) into the buffer as fit,
+   * publishing them all at once. Producer thread only.
+   *
+   * Returns the number of items moved. Items after those are left untouched
+   */
+  template<class InputIt>
+  size_t try_send_batch(InputIt first, InputIt last)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t wanted = static_cast<size_t>(std::distance(first, last));
+    if (m_slots.size() - (tail - m_cached_head) < wanted) {
+      m_cached_head = m_head.load(std::memory_order_acquire);
+    }
+    const size_t n = std::min(wanted, m_slots.size() - (tail - m_cached_head));
+    for (size_t i = 0; i < n; ++i, ++first) {
+      m_slots[(tail + i) & m_mask] = std::move(*first);
+    }
+    if (n != 0) {
+      m_tail.store(tail + n, std::memory_order_release);
+    }
+    return n;
+  }
+
+  /**
+   * @brief Take the oldest item from the buffer. Consumer thread only.
+   *
+   * Returns an empty optional if the buffer is empty
+   */
+  std::optional<T> try_receive()
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_cached_tail) {
+      m_cached_tail = m_tail.load(std::memory_order_acquire);
+      if (head == m_cached_tail) {
+        return std::nullopt;
+      }
+    }
+    std::optional<T> item(std::move(m_slots[head & m_mask]));
+    m_head.store(head + 1, std::memory_order_release);
+    return item;
+  }
+
+  /**
+   * @brief Move up to @a max_items of the oldest items to @a out, releasing
+   * their slots all at once. Consumer thread only.
+   *
+   * Returns the number of items received
+   */
+  template<class OutputIt>
+  size_t try_receive_batch(OutputIt out, size_t max_items)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (m_cached_tail - head < max_items) {
+      m_cached_tail = m_tail.load(std::memory_order_acquire);
+    }
+    const size_t n = std::min(max_items, m_cached_tail - head);
+    for (size_t i = 0; i < n; ++i) {
+      *out++ = std::move(m_slots[(head + i) & m_mask]);
+    }
+    if (n != 0) {
+      m_head.store(head + n, std::memory_order_release);
+    }
+    return n;
+  }
+
+  size_t capacity() const { return m_slots.size(); }
+
+  // Only a snapshot: the other thread may be changing the contents
+  size_t size_approx() const
+  {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+
+  bool empty_approx() const { return size_approx() == 0; }
+
+private:
+  static size_t round_up_to_power_of_two(size_t n)
+  {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  // Separate cache lines for the consumer-owned and producer-owned
+  // indices, so the two threads don't false-share
+  static constexpr size_t s_cache_line_size = 64;
+
+  std::vector<T> m_slots;
+  const size_t m_mask;
+
+  // Written by the consumer. m_cached_tail is the consumer's last view of m_tail
+  alignas(s_cache_line_size) std::atomic<size_t> m_head{ 0 };
+  size_t m_cached_tail{ 0 };
+
+  // Written by the producer. m_cached_head is the producer's last view of m_head
+  alignas(s_cache_line_size) std::atomic<size_t> m_tail{ 0 };
+  size_t m_cached_head{ 0 };
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_SPSCRINGBUFFER_HPP_
@@ -0,0 +1,105 @@
+/**
+ * @file SetBufferPool.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_SETBUFFERPOOL_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_SETBUFFERPOOL_HPP_
+
+#include "trigger/Set.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief A process-wide pool of the vectors that hold Set<T>::objects
+ *
+ * Deserializing a Set<T> takes a vector from the pool with acquire() and
+ * decodes into it, so a vector whose capacity is big enough needs no new
+ * allocation. Once the contents of a Set<T> have been consumed, release()
+ * (or recycle()) gives its vector back. Deserialization and consumption
+ * normally happen on different threads, so the pool is protected by a
+ * mutex, held only to move a vector in or out.
+ *
+ * Not every Set<T> is recycled: some are consumed by modules that just let
+ * them go, and some are released that didn't get their vector from the pool,
+ * eg those sent on in-process connections. So the pool doesn't try to match
+ * vectors to acquire() calls, and just keeps at most s_max_free of them.
+ */
+template<class T>
+class SetBufferPool
+{
+public:
+  // Enough for several time slices' worth of Sets from many links
+  static constexpr size_t s_max_free = 1024;
+
+  static SetBufferPool& get()
+  {
+    static SetBufferPool pool;
+    return pool;
+  }
+
+  // Return an empty vector, which has the capacity left by an earlier Set if one is available
+  std::vector<T> acquire()
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      if (!m_free.empty()) {
+        std::vector<T> buffer = std::move(m_free.back());
+        m_free.pop_back();
+        ++m_reused_count;
+        return buffer;
+      }
+    }
+    ++m_new_count;
+    return std::vector<T>();
+  }
+
+  // Give a vector back to the pool. Its contents are discarded
+  void release(std::vector<T>&& buffer)
+  {
+    buffer.clear();
+    // Vectors that never held anything aren't worth keeping
+    if (buffer.capacity() == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_free.size() < s_max_free) {
+      m_free.push_back(std::move(buffer));
+    }
+  }
+
+  void recycle(Set<T>& set) { release(std::move(set.objects)); }
+
+  // Called by the deserializer each time it had to allocate memory for a set's objects
+  void count_allocation() { ++m_allocation_count; }
+
+  // Number of acquire() calls that got a vector from the pool, or a new empty one
+  uint64_t get_reused_count() const { return m_reused_count.load(); } // NOLINT(build/unsigned)
+  uint64_t get_new_count() const { return m_new_count.load(); }       // NOLINT(build/unsigned)
+  // Number of times deserializing a set had to allocate
+  uint64_t get_allocation_count() const { return m_allocation_count.load(); } // NOLINT(build/unsigned)
+
+private:
+  SetBufferPool() { m_free.reserve(s_max_free); }
+
+  std::mutex m_mutex;
+  std::vector<std::vector<T>> m_free;
+
+  std::atomic<uint64_t> m_reused_count{ 0 };     // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_new_count{ 0 };        // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_allocation_count{ 0 }; // NOLINT(build/unsigned)
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_SETBUFFERPOOL_HPP_
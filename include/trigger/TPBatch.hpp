@@ -0,0 +1,102 @@
+/**
+ * @file TPBatch.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_TPBATCH_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_TPBATCH_HPP_
+
+#include "detdataformats/trigger/Types.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief A time slice of TriggerPrimitives, stored column by column
+ *
+ * Each field the window algorithms look at is held in its own contiguous
+ * array, so a loop over eg adc_integral reads only the bytes it needs and
+ * the compiler can vectorize it. Entry i of every column refers to the same
+ * TP, which is also available in full as tps()[i], for algorithms that need
+ * to copy whole TPs into their output.
+ *
+ * A TPBatch is meant to be kept and refilled with assign(): the columns keep
+ * their capacity between slices, so steady-state refills don't allocate.
+ */
+class TPBatch
+{
+public:
+  using TriggerPrimitive = triggeralgs::TriggerPrimitive;
+
+  std::vector<detdataformats::trigger::timestamp_t> time_start;
+  std::vector<detdataformats::trigger::timestamp_t> time_peak;
+  std::vector<detdataformats::trigger::timestamp_t> time_over_threshold;
+  std::vector<detdataformats::trigger::channel_t> channel;
+  std::vector<uint32_t> adc_integral; // NOLINT(build/unsigned)
+  std::vector<uint16_t> adc_peak;     // NOLINT(build/unsigned)
+  std::vector<detdataformats::trigger::detid_t> detid;
+
+  // Fill the columns from the time-ordered @a slice. The batch refers to
+  // @a slice through tps(), so @a slice must outlive any use of the batch
+  void assign(const std::vector<TriggerPrimitive>& slice)
+  {
+    const size_t n = slice.size();
+    time_start.resize(n);
+    time_peak.resize(n);
+    time_over_threshold.resize(n);
+    channel.resize(n);
+    adc_integral.resize(n);
+    adc_peak.resize(n);
+    detid.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      const TriggerPrimitive& tp = slice[i];
+      time_start[i] = tp.time_start;
+      time_peak[i] = tp.time_peak;
+      time_over_threshold[i] = tp.time_over_threshold;
+      channel[i] = tp.channel;
+      adc_integral[i] = tp.adc_integral;
+      adc_peak[i] = tp.adc_peak;
+      detid[i] = tp.detid;
+    }
+    m_tps = slice.data();
+  }
+
+  size_t size() const { return time_start.size(); }
+  bool empty() const { return time_start.empty(); }
+
+  // The TPs the columns were filled from, in the same order
+  const TriggerPrimitive* tps() const { return m_tps; }
+
+private:
+  const TriggerPrimitive* m_tps = nullptr;
+};
+
+/**
+ * @brief Optional interface for TriggerActivityMaker plugins that can process
+ * a whole TPBatch at once
+ *
+ * A plugin class that derives from both triggeralgs::TriggerActivityMaker and
+ * TPBatchProcessor<triggeralgs::TriggerActivity> gets each time slice as one
+ * call to process_batch() instead of one operator() call per TP. The result
+ * must be the same as calling operator() on each TP in order. Plugins that
+ * don't implement it are called per TP as before.
+ */
+template<class OUT>
+class TPBatchProcessor
+{
+public:
+  virtual ~TPBatchProcessor() = default;
+
+  virtual void process_batch(const TPBatch& batch, std::vector<OUT>& output) = 0;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_TPBATCH_HPP_
@@ -12,16 +12,108 @@
 #include "dfmessages/GeoID_serialization.hpp"
 #include "serialization/Serialization.hpp"
 #include "trigger/Set.hpp"
+#include "trigger/SetBufferPool.hpp"
+#include "trigger/TPSetWireFormat.hpp"
 #include "trigger/TriggerPrimitive_serialization.hpp"
 #include "detdataformats/trigger/TriggerPrimitive.hpp"
 
+#include <vector>
+
 namespace dunedaq::trigger {
 
 using TPSet = Set<detdataformats::trigger::TriggerPrimitive>;
 
+// JSON is always field by field
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(TPSet, seqno, run_number, origin, type, start_time, end_time, objects)
+
 } // namespace dunedaq::trigger
 
 MSGPACK_ADD_ENUM(dunedaq::trigger::TPSet::Type)
-DUNE_DAQ_SERIALIZE_NON_INTRUSIVE(dunedaq::trigger, TPSet, seqno, run_number, origin, type, start_time, end_time, objects)
+
+// The MsgPack serialization is written out by hand, rather than with
+// DUNE_DAQ_SERIALIZE_NON_INTRUSIVE, so that TPSets can be sent in one of the
+// other formats in TPSetWireFormat.hpp, chosen with set_tpset_wire_format().
+// The kMsgPack format is the same as DUNE_DAQ_SERIALIZE_NON_INTRUSIVE's. The
+// other formats are packed as a single MsgPack bin object, so the receiving
+// side can tell which format it got from the MsgPack type
+namespace msgpack {
+MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
+{
+  namespace adaptor {
+
+  template<>
+  struct pack<dunedaq::trigger::TPSet>
+  {
+    template<typename Stream>
+    packer<Stream>& operator()(msgpack::packer<Stream>& o, dunedaq::trigger::TPSet const& tpset) const
+    {
+      const dunedaq::trigger::TPSetWireFormat format = dunedaq::trigger::get_tpset_wire_format();
+      if (format != dunedaq::trigger::TPSetWireFormat::kMsgPack) {
+        // Reuse the encoding buffer between calls on the same thread
+        thread_local std::vector<uint8_t> buffer; // NOLINT(build/unsigned)
+        if (format == dunedaq::trigger::TPSetWireFormat::kCompressed) {
+          dunedaq::trigger::encode_tpset_compressed(tpset, buffer);
+        } else {
+          buffer.resize(dunedaq::trigger::tpset_binary_size(tpset));
+          dunedaq::trigger::encode_tpset_binary(tpset, buffer.data());
+        }
+        o.pack_bin(buffer.size());
+        o.pack_bin_body(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        return o;
+      }
+      o.pack_array(7);
+      o.pack(tpset.seqno);
+      o.pack(tpset.run_number);
+      o.pack(tpset.origin);
+      o.pack(tpset.type);
+      o.pack(tpset.start_time);
+      o.pack(tpset.end_time);
+      o.pack(tpset.objects);
+      return o;
+    }
+  };
+
+  template<>
+  struct convert<dunedaq::trigger::TPSet>
+  {
+    msgpack::object const& operator()(msgpack::object const& o, dunedaq::trigger::TPSet& tpset) const
+    {
+      // Decode into a vector from the pool, so that we only allocate when
+      // this set has more TPs than any set the vector held before
+      auto& pool = dunedaq::trigger::SetBufferPool<dunedaq::trigger::TPSet::element_t>::get();
+      if (tpset.objects.capacity() == 0) {
+        tpset.objects = pool.acquire();
+      }
+      const size_t capacity = tpset.objects.capacity();
+
+      if (o.type == msgpack::type::BIN) {
+        dunedaq::trigger::decode_tpset_wire(
+          reinterpret_cast<const uint8_t*>(o.via.bin.ptr), o.via.bin.size, tpset); // NOLINT(build/unsigned)
+      } else if (o.type == msgpack::type::ARRAY && o.via.array.size == 7) {
+        tpset.seqno = o.via.array.ptr[0].as<dunedaq::trigger::TPSet::seqno_t>();
+        tpset.run_number = o.via.array.ptr[1].as<dunedaq::daqdataformats::run_number_t>();
+        tpset.origin = o.via.array.ptr[2].as<dunedaq::trigger::TPSet::origin_t>();
+        tpset.type = o.via.array.ptr[3].as<dunedaq::trigger::TPSet::Type>();
+        tpset.start_time = o.via.array.ptr[4].as<dunedaq::trigger::TPSet::timestamp_t>();
+        tpset.end_time = o.via.array.ptr[5].as<dunedaq::trigger::TPSet::timestamp_t>();
+        o.via.array.ptr[6].convert(tpset.objects);
+      } else {
+        throw msgpack::type_error();
+      }
+
+      if (tpset.objects.capacity() != capacity) {
+        pool.count_allocation();
+      }
+      return o;
+    }
+  };
+
+  } // namespace adaptor
+} // MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS)
+} // namespace msgpack
+
+// DUNE_DAQ_SERIALIZE_NON_INTRUSIVE also declares this, and iomanager's
+// network connections only take types that have it
+DUNE_DAQ_SERIALIZABLE(dunedaq::trigger::TPSet);
 
 #endif // TRIGGER_INCLUDE_TRIGGER_TPSET_HPP_
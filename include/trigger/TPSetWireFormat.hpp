@@ -0,0 +1,474 @@
+/**
+ * @file TPSetWireFormat.hpp
+ *
+ * Encodings of TPSets for sending over the network, other than the default
+ * field-by-field MsgPack one
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_INCLUDE_TRIGGER_TPSETWIREFORMAT_HPP_
+#define TRIGGER_INCLUDE_TRIGGER_TPSETWIREFORMAT_HPP_
+
+#include "trigger/Issues.hpp"
+#include "trigger/Set.hpp"
+
+#include "daqdataformats/GeoID.hpp"
+#include "detdataformats/trigger/TriggerPrimitive.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+enum class TPSetWireFormat
+{
+  kMsgPack,   // One MsgPack field per TPSet and TP member, as for TASet and TCSet
+  kBinary,    // TPSetWireHeader followed by the TPs as raw structs
+  kCompressed // Delta and varint encoded, see encode_tpset_compressed()
+};
+
+/**
+ * @brief The header of a TPSet in TPSetWireFormat::kBinary
+ *
+ * The header is followed by n_objects TriggerPrimitives, copied as-is from
+ * memory. Both ends must therefore agree on the TriggerPrimitive layout,
+ * which tp_size checks, and on byte order: all DAQ hosts are little-endian.
+ * Bump s_version whenever the layout here changes.
+ */
+struct TPSetWireHeader
+{
+  static constexpr uint32_t s_magic = 0x42535054; // "TPSB" // NOLINT(build/unsigned)
+  static constexpr uint16_t s_version = 1;        // NOLINT(build/unsigned)
+
+  uint32_t magic;              // NOLINT(build/unsigned)
+  uint16_t version;            // NOLINT(build/unsigned)
+  uint16_t header_size;        // NOLINT(build/unsigned)
+  uint16_t tp_size;            // NOLINT(build/unsigned)
+  uint16_t set_type;           // NOLINT(build/unsigned)
+  uint16_t origin_system_type; // NOLINT(build/unsigned)
+  uint16_t origin_region_id;   // NOLINT(build/unsigned)
+  uint32_t origin_element_id;  // NOLINT(build/unsigned)
+  uint32_t run_number;         // NOLINT(build/unsigned)
+  uint64_t seqno;              // NOLINT(build/unsigned)
+  uint64_t start_time;         // NOLINT(build/unsigned)
+  uint64_t end_time;           // NOLINT(build/unsigned)
+  uint64_t n_objects;          // NOLINT(build/unsigned)
+};
+
+static_assert(sizeof(TPSetWireHeader) == 56, "TPSetWireHeader must not contain padding");
+static_assert(std::is_trivially_copyable_v<detdataformats::trigger::TriggerPrimitive>,
+              "TriggerPrimitive must be trivially copyable for the binary TPSet wire format");
+
+namespace tpsetwireformat_detail {
+
+// Per thread, so that one module's choice doesn't change what other
+// modules in the same process send
+inline TPSetWireFormat&
+format_storage()
+{
+  thread_local TPSetWireFormat format = TPSetWireFormat::kMsgPack;
+  return format;
+}
+
+// Unsigned LEB128: 7 bits per byte, low bits first, high bit set on all but the last byte
+constexpr size_t s_max_varint_size = 10;
+
+inline uint8_t* // NOLINT(build/unsigned)
+write_varint(uint8_t* out, uint64_t value) // NOLINT(build/unsigned)
+{
+  while (value >= 0x80) {
+    *out++ = static_cast<uint8_t>(value) | 0x80; // NOLINT(build/unsigned)
+    value >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(value); // NOLINT(build/unsigned)
+  return out;
+}
+
+inline uint64_t // NOLINT(build/unsigned)
+read_varint(const uint8_t*& in, const uint8_t* end) // NOLINT(build/unsigned)
+{
+  uint64_t value = 0; // NOLINT(build/unsigned)
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (in == end) {
+      throw BadTPSetWireData(ERS_HERE, "truncated varint");
+    }
+    uint8_t byte = *in++; // NOLINT(build/unsigned)
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift; // NOLINT(build/unsigned)
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw BadTPSetWireData(ERS_HERE, "varint too long");
+}
+
+// Map signed values near zero to small unsigned values: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+inline uint64_t // NOLINT(build/unsigned)
+zigzag_encode(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); // NOLINT(build/unsigned)
+}
+
+inline int64_t
+zigzag_decode(uint64_t value) // NOLINT(build/unsigned)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Bits in the per-TP byte that says which of the rarely-changing fields
+// differ from the previous TP, and are therefore written out
+enum RareField : uint8_t // NOLINT(build/unsigned)
+{
+  kDetID = 1 << 0,
+  kType = 1 << 1,
+  kAlgorithm = 1 << 2,
+  kVersion = 1 << 3,
+  kFlag = 1 << 4
+};
+
+} // namespace tpsetwireformat_detail
+
+/**
+ * @brief Set the format that TPSets are serialized with by the calling thread
+ *
+ * iomanager serializes in the thread that calls send(), so each module that
+ * sends TPSets sets this, from the tpset_wire_format field of its
+ * configuration, in the threads that send them. Other threads keep
+ * kMsgPack. Deserialization recognizes every format whatever this is set
+ * to, so the receiving side of a connection needs no configuration
+ */
+inline void
+set_tpset_wire_format(TPSetWireFormat format)
+{
+  tpsetwireformat_detail::format_storage() = format;
+}
+
+inline TPSetWireFormat
+get_tpset_wire_format()
+{
+  return tpsetwireformat_detail::format_storage();
+}
+
+/**
+ * @brief Sets the calling thread's format for as long as it exists, for
+ * code that sends TPSets from a thread that isn't its own
+ */
+class TPSetWireFormatScope
+{
+public:
+  explicit TPSetWireFormatScope(TPSetWireFormat format)
+    : m_previous(get_tpset_wire_format())
+  {
+    set_tpset_wire_format(format);
+  }
+  ~TPSetWireFormatScope() { set_tpset_wire_format(m_previous); }
+
+  TPSetWireFormatScope(const TPSetWireFormatScope&) = delete;
+  TPSetWireFormatScope& operator=(const TPSetWireFormatScope&) = delete;
+  TPSetWireFormatScope(TPSetWireFormatScope&&) = delete;
+  TPSetWireFormatScope& operator=(TPSetWireFormatScope&&) = delete;
+
+private:
+  TPSetWireFormat m_previous;
+};
+
+/**
+ * @brief Convert the WireFormat enum of a module's configuration schema,
+ * which has the same kMsgPack, kBinary and kCompressed values
+ */
+template<class WireFormat>
+TPSetWireFormat
+to_tpset_wire_format(WireFormat format)
+{
+  switch (format) {
+    case WireFormat::kBinary:
+      return TPSetWireFormat::kBinary;
+    case WireFormat::kCompressed:
+      return TPSetWireFormat::kCompressed;
+    default:
+      return TPSetWireFormat::kMsgPack;
+  }
+}
+
+// The number of bytes tpset takes in TPSetWireFormat::kBinary
+inline size_t
+tpset_binary_size(const Set<detdataformats::trigger::TriggerPrimitive>& tpset)
+{
+  return sizeof(TPSetWireHeader) + tpset.objects.size() * sizeof(detdataformats::trigger::TriggerPrimitive);
+}
+
+/**
+ * @brief Write tpset in TPSetWireFormat::kBinary to out, which must have
+ * room for tpset_binary_size(tpset) bytes
+ */
+inline void
+encode_tpset_binary(const Set<detdataformats::trigger::TriggerPrimitive>& tpset, uint8_t* out) // NOLINT(build/unsigned)
+{
+  TPSetWireHeader header;
+  header.magic = TPSetWireHeader::s_magic;
+  header.version = TPSetWireHeader::s_version;
+  header.header_size = sizeof(TPSetWireHeader);
+  header.tp_size = sizeof(detdataformats::trigger::TriggerPrimitive);
+  header.set_type = static_cast<uint16_t>(tpset.type); // NOLINT(build/unsigned)
+  header.origin_system_type = static_cast<uint16_t>(tpset.origin.system_type); // NOLINT(build/unsigned)
+  header.origin_region_id = tpset.origin.region_id;
+  header.origin_element_id = tpset.origin.element_id;
+  header.run_number = tpset.run_number;
+  header.seqno = tpset.seqno;
+  header.start_time = tpset.start_time;
+  header.end_time = tpset.end_time;
+  header.n_objects = tpset.objects.size();
+
+  std::memcpy(out, &header, sizeof(header));
+  if (!tpset.objects.empty()) {
+    std::memcpy(out + sizeof(header),
+                tpset.objects.data(),
+                tpset.objects.size() * sizeof(detdataformats::trigger::TriggerPrimitive));
+  }
+}
+
+/**
+ * @brief Fill tpset from size bytes of TPSetWireFormat::kBinary data.
+ *
+ * Throws BadTPSetWireData if the data is truncated or was written with an
+ * incompatible layout
+ */
+inline void
+decode_tpset_binary(const uint8_t* data, size_t size, Set<detdataformats::trigger::TriggerPrimitive>& tpset) // NOLINT
+{
+  using TriggerPrimitive = detdataformats::trigger::TriggerPrimitive;
+
+  TPSetWireHeader header;
+  if (size < sizeof(header)) {
+    throw BadTPSetWireData(ERS_HERE, "data is shorter than the header");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic != TPSetWireHeader::s_magic) {
+    throw BadTPSetWireData(ERS_HERE, "bad magic number");
+  }
+  if (header.version != TPSetWireHeader::s_version || header.header_size != sizeof(header)) {
+    throw BadTPSetWireData(ERS_HERE, "unsupported version " + std::to_string(header.version));
+  }
+  if (header.tp_size != sizeof(TriggerPrimitive)) {
+    throw BadTPSetWireData(ERS_HERE, "TriggerPrimitive size mismatch: " + std::to_string(header.tp_size));
+  }
+  if (header.n_objects > (size - sizeof(header)) / sizeof(TriggerPrimitive)) {
+    throw BadTPSetWireData(ERS_HERE, "data is shorter than " + std::to_string(header.n_objects) + " TPs");
+  }
+
+  tpset.seqno = header.seqno;
+  tpset.run_number = header.run_number;
+  tpset.origin = daqdataformats::GeoID(static_cast<daqdataformats::GeoID::SystemType>(header.origin_system_type),
+                                       header.origin_region_id,
+                                       header.origin_element_id);
+  tpset.type = static_cast<Set<TriggerPrimitive>::Type>(header.set_type);
+  tpset.start_time = header.start_time;
+  tpset.end_time = header.end_time;
+  tpset.objects.resize(header.n_objects);
+  if (header.n_objects != 0) {
+    std::memcpy(tpset.objects.data(), data + sizeof(header), header.n_objects * sizeof(TriggerPrimitive));
+  }
+}
+
+constexpr uint32_t s_compressed_magic = 0x43535054; // "TPSC" // NOLINT(build/unsigned)
+constexpr uint16_t s_compressed_version = 1;        // NOLINT(build/unsigned)
+
+/**
+ * @brief Write tpset in TPSetWireFormat::kCompressed to out, replacing its contents
+ *
+ * The TPSet fields are written as varints after a 4-byte magic number and
+ * a varint version. Each TP is then written relative to what came before:
+ *
+ *  - a byte of RareField bits, saying which of detid, type, algorithm,
+ *    version and flag differ from the previous TP (or from a
+ *    default-constructed TP, for the first one), followed by those values
+ *  - time_start minus the previous TP's time_start (the set's start_time
+ *    for the first TP), zigzag encoded in case the TPs aren't sorted
+ *  - time_peak minus time_start, zigzag encoded
+ *  - time_over_threshold
+ *  - channel minus the smallest channel in the set, which is in the set header
+ *  - adc_integral and adc_peak
+ *
+ * all as varints. For typical TPSets this is several times smaller than
+ * the kBinary format
+ */
+inline void
+encode_tpset_compressed(const Set<detdataformats::trigger::TriggerPrimitive>& tpset,
+                        std::vector<uint8_t>& out) // NOLINT(build/unsigned)
+{
+  using namespace tpsetwireformat_detail;
+  using TriggerPrimitive = detdataformats::trigger::TriggerPrimitive;
+
+  detdataformats::trigger::channel_t min_channel = 0;
+  if (!tpset.objects.empty()) {
+    min_channel = std::min_element(tpset.objects.begin(),
+                                   tpset.objects.end(),
+                                   [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+                                     return a.channel < b.channel;
+                                   })
+                    ->channel;
+  }
+
+  // Size for the worst case, and trim at the end
+  constexpr size_t max_header_size = 4 + 12 * s_max_varint_size;
+  constexpr size_t max_tp_size = 1 + 11 * s_max_varint_size;
+  out.resize(max_header_size + tpset.objects.size() * max_tp_size);
+  uint8_t* p = out.data(); // NOLINT(build/unsigned)
+
+  std::memcpy(p, &s_compressed_magic, sizeof(s_compressed_magic));
+  p += sizeof(s_compressed_magic);
+  p = write_varint(p, s_compressed_version);
+  p = write_varint(p, tpset.seqno);
+  p = write_varint(p, tpset.run_number);
+  p = write_varint(p, static_cast<uint64_t>(tpset.origin.system_type)); // NOLINT(build/unsigned)
+  p = write_varint(p, tpset.origin.region_id);
+  p = write_varint(p, tpset.origin.element_id);
+  p = write_varint(p, static_cast<uint64_t>(tpset.type)); // NOLINT(build/unsigned)
+  p = write_varint(p, tpset.start_time);
+  p = write_varint(p, zigzag_encode(static_cast<int64_t>(tpset.end_time - tpset.start_time)));
+  p = write_varint(p, tpset.objects.size());
+  p = write_varint(p, min_channel);
+
+  TriggerPrimitive prev;
+  prev.time_start = tpset.start_time;
+  for (const TriggerPrimitive& tp : tpset.objects) {
+    uint8_t* rare_fields = p++; // NOLINT(build/unsigned)
+    *rare_fields = 0;
+    if (tp.detid != prev.detid) {
+      *rare_fields |= kDetID;
+      p = write_varint(p, tp.detid);
+    }
+    if (tp.type != prev.type) {
+      *rare_fields |= kType;
+      p = write_varint(p, static_cast<uint64_t>(tp.type)); // NOLINT(build/unsigned)
+    }
+    if (tp.algorithm != prev.algorithm) {
+      *rare_fields |= kAlgorithm;
+      p = write_varint(p, static_cast<uint64_t>(tp.algorithm)); // NOLINT(build/unsigned)
+    }
+    if (tp.version != prev.version) {
+      *rare_fields |= kVersion;
+      p = write_varint(p, tp.version);
+    }
+    if (tp.flag != prev.flag) {
+      *rare_fields |= kFlag;
+      p = write_varint(p, tp.flag);
+    }
+    p = write_varint(p, zigzag_encode(static_cast<int64_t>(tp.time_start - prev.time_start)));
+    p = write_varint(p, zigzag_encode(static_cast<int64_t>(tp.time_peak - tp.time_start)));
+    p = write_varint(p, tp.time_over_threshold);
+    p = write_varint(p, tp.channel - min_channel);
+    p = write_varint(p, tp.adc_integral);
+    p = write_varint(p, tp.adc_peak);
+    prev = tp;
+  }
+  out.resize(p - out.data());
+}
+
+/**
+ * @brief Fill tpset from size bytes of TPSetWireFormat::kCompressed data
+ *
+ * Throws BadTPSetWireData if the data is truncated or has an unknown version
+ */
+inline void
+decode_tpset_compressed(const uint8_t* data, // NOLINT(build/unsigned)
+                        size_t size,
+                        Set<detdataformats::trigger::TriggerPrimitive>& tpset)
+{
+  using namespace tpsetwireformat_detail;
+  using TriggerPrimitive = detdataformats::trigger::TriggerPrimitive;
+
+  const uint8_t* p = data; // NOLINT(build/unsigned)
+  const uint8_t* end = data + size; // NOLINT(build/unsigned)
+
+  uint32_t magic; // NOLINT(build/unsigned)
+  if (size < sizeof(magic)) {
+    throw BadTPSetWireData(ERS_HERE, "data is shorter than the header");
+  }
+  std::memcpy(&magic, p, sizeof(magic));
+  p += sizeof(magic);
+  if (magic != s_compressed_magic) {
+    throw BadTPSetWireData(ERS_HERE, "bad magic number");
+  }
+  uint64_t version = read_varint(p, end); // NOLINT(build/unsigned)
+  if (version != s_compressed_version) {
+    throw BadTPSetWireData(ERS_HERE, "unsupported version " + std::to_string(version));
+  }
+
+  tpset.seqno = read_varint(p, end);
+  tpset.run_number = read_varint(p, end);
+  auto system_type = static_cast<daqdataformats::GeoID::SystemType>(read_varint(p, end));
+  auto region_id = read_varint(p, end);
+  auto element_id = read_varint(p, end);
+  tpset.origin = daqdataformats::GeoID(system_type, region_id, element_id);
+  tpset.type = static_cast<Set<TriggerPrimitive>::Type>(read_varint(p, end));
+  tpset.start_time = read_varint(p, end);
+  tpset.end_time = tpset.start_time + zigzag_decode(read_varint(p, end));
+  uint64_t n_objects = read_varint(p, end); // NOLINT(build/unsigned)
+  // Every TP takes at least 7 bytes, so this catches corrupt counts before we allocate
+  if (n_objects > static_cast<size_t>(end - p) / 7) {
+    throw BadTPSetWireData(ERS_HERE, "data is shorter than " + std::to_string(n_objects) + " TPs");
+  }
+  auto min_channel = read_varint(p, end);
+
+  tpset.objects.resize(n_objects);
+  TriggerPrimitive prev;
+  prev.time_start = tpset.start_time;
+  for (TriggerPrimitive& tp : tpset.objects) {
+    if (p == end) {
+      throw BadTPSetWireData(ERS_HERE, "truncated TP");
+    }
+    uint8_t rare_fields = *p++; // NOLINT(build/unsigned)
+    tp = prev;
+    if (rare_fields & kDetID) {
+      tp.detid = read_varint(p, end);
+    }
+    if (rare_fields & kType) {
+      tp.type = static_cast<TriggerPrimitive::Type>(read_varint(p, end));
+    }
+    if (rare_fields & kAlgorithm) {
+      tp.algorithm = static_cast<TriggerPrimitive::Algorithm>(read_varint(p, end));
+    }
+    if (rare_fields & kVersion) {
+      tp.version = read_varint(p, end);
+    }
+    if (rare_fields & kFlag) {
+      tp.flag = read_varint(p, end);
+    }
+    tp.time_start = prev.time_start + zigzag_decode(read_varint(p, end));
+    tp.time_peak = tp.time_start + zigzag_decode(read_varint(p, end));
+    tp.time_over_threshold = read_varint(p, end);
+    tp.channel = min_channel + read_varint(p, end);
+    tp.adc_integral = read_varint(p, end);
+    tp.adc_peak = read_varint(p, end);
+    prev = tp;
+  }
+}
+
+/**
+ * @brief Fill tpset from data in any of the formats packed as a single
+ * block: kBinary or kCompressed. Which one is told by the magic number
+ */
+inline void
+decode_tpset_wire(const uint8_t* data, size_t size, Set<detdataformats::trigger::TriggerPrimitive>& tpset) // NOLINT
+{
+  uint32_t magic = 0; // NOLINT(build/unsigned)
+  if (size >= sizeof(magic)) {
+    std::memcpy(&magic, data, sizeof(magic));
+  }
+  if (magic == s_compressed_magic) {
+    decode_tpset_compressed(data, size, tpset);
+  } else {
+    decode_tpset_binary(data, size, tpset);
+  }
+}
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_INCLUDE_TRIGGER_TPSETWIREFORMAT_HPP_
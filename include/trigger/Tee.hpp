@@ -9,9 +9,10 @@
 #ifndef TRIGGER_PLUGINS_TEE_HPP_
 #define TRIGGER_PLUGINS_TEE_HPP_
 
+#include "trigger/LocalConnection.hpp"
+#include "trigger/TPSetWireFormat.hpp"
+
 #include "appfwk/DAQModule.hpp"
-#include "iomanager/Receiver.hpp"
-#include "iomanager/Sender.hpp"
 #include "utilities/WorkerThread.hpp"
 
 namespace dunedaq {
@@ -38,12 +39,15 @@ private:
 
   dunedaq::utilities::WorkerThread m_thread;
 
-  using source_t = dunedaq::iomanager::ReceiverConcept<T>;
+  using source_t = InputConnection<T>;
   std::shared_ptr<source_t> m_input_queue;
-  using sink_t = dunedaq::iomanager::SenderConcept<T>;
+  using sink_t = OutputConnection<T>;
   std::shared_ptr<sink_t> m_output_queue1;
   std::shared_ptr<sink_t> m_output_queue2;
 
+  // Only used if T is TPSet
+  TPSetWireFormat m_tpset_wire_format{ TPSetWireFormat::kMsgPack };
+
 };
 } // namespace trigger
 } // namespace dunedaq
@@ -11,7 +11,9 @@
 #include "iomanager/IOManager.hpp"
 #include "rcif/cmd/Nljs.hpp"
 #include "trigger/Issues.hpp"
+#include "trigger/tee/Nljs.hpp"
 
+#include <optional>
 #include <string>
 
 namespace dunedaq {
@@ -37,9 +39,9 @@ void
 Tee<T>::init(const nlohmann::json& iniobj)
 {
   try {
-    m_input_queue = get_iom_receiver<T>(appfwk::connection_inst(iniobj, "input"));
-    m_output_queue1 = get_iom_sender<T>(appfwk::connection_inst(iniobj, "output1"));
-    m_output_queue2 = get_iom_sender<T>(appfwk::connection_inst(iniobj, "output2"));
+    m_input_queue = get_input_connection<T>(appfwk::connection_inst(iniobj, "input").uid);
+    m_output_queue1 = get_output_connection<T>(appfwk::connection_inst(iniobj, "output1").uid);
+    m_output_queue2 = get_output_connection<T>(appfwk::connection_inst(iniobj, "output2").uid);
   } catch (const ers::Issue& excpt) {
     throw dunedaq::trigger::InvalidQueueFatalError(ERS_HERE, get_name(), "input/output", excpt);
   }
@@ -47,8 +49,9 @@ Tee<T>::init(const nlohmann::json& iniobj)
 
 template<class T>
 void
-Tee<T>::do_conf(const nlohmann::json&)
+Tee<T>::do_conf(const nlohmann::json& config)
 {
+  m_tpset_wire_format = to_tpset_wire_format(config.get<tee::ConfParams>().tpset_wire_format);
   TLOG_DEBUG(2) << get_name() + " configured.";
 }
 
@@ -77,14 +80,14 @@ template<class T>
 void
 Tee<T>::do_work(std::atomic<bool>& running_flag)
 {
+  // The format is per thread, and this thread does all the sending
+  set_tpset_wire_format(m_tpset_wire_format);
+
   size_t n_objects = 0;
   
   while (true) {
-    T object;
-    try {
-      object = m_input_queue->receive(std::chrono::milliseconds(100));
-      ++n_objects;
-    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+    std::optional<T> object = m_input_queue->try_receive(std::chrono::milliseconds(100));
+    if (!object.has_value()) {
       // The condition to exit the loop is that we've been stopped and
       // there's nothing left on the input queue
       if (!running_flag.load()) {
@@ -93,18 +96,15 @@ Tee<T>::do_work(std::atomic<bool>& running_flag)
         continue;
       }
     }
+    ++n_objects;
 
     size_t timeout_ms = 20;
-    try {
-      T object1(object);
-      m_output_queue1->send(std::move(object1), std::chrono::milliseconds(timeout_ms));
-    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+    T object1(*object);
+    if (!m_output_queue1->try_send(std::move(object1), std::chrono::milliseconds(timeout_ms))) {
       ers::warning(dunedaq::iomanager::TimeoutExpired(ERS_HERE, get_name(), "push to output queue 1", timeout_ms));
     }
-    try {
-      T object2(object);
-      m_output_queue2->send(std::move(object2), std::chrono::milliseconds(timeout_ms));
-    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+    // The second output can have the original
+    if (!m_output_queue2->try_send(std::move(*object), std::chrono::milliseconds(timeout_ms))) {
       ers::warning(dunedaq::iomanager::TimeoutExpired(ERS_HERE, get_name(), "push to output queue 2", timeout_ms));
     }
   }
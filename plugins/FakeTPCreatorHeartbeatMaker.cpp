@@ -11,7 +11,9 @@
 #include "appfwk/DAQModuleHelper.hpp"
 #include "iomanager/IOManager.hpp"
 #include "rcif/cmd/Nljs.hpp"
+#include "timinglibs/TimestampEstimatorSystem.hpp"
 
+#include <algorithm>
 #include <string>
 
 namespace dunedaq {
@@ -22,6 +24,7 @@ FakeTPCreatorHeartbeatMaker::FakeTPCreatorHeartbeatMaker(const std::string& name
   , m_input_queue(nullptr)
   , m_output_queue(nullptr)
   , m_queue_timeout(100)
+  , m_receive_timeout(100)
 {
 
   register_command("conf", &FakeTPCreatorHeartbeatMaker::do_conf);
@@ -49,6 +52,8 @@ FakeTPCreatorHeartbeatMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/
   i.tpset_received_count = m_tpset_received_count.load();
   i.tpset_sent_count = m_tpset_sent_count.load();
   i.heartbeats_sent = m_heartbeats_sent.load();
+  i.clock_heartbeats_sent = m_clock_heartbeats_sent.load();
+  i.late_tpset_count = m_late_tpset_count.load();
 
   ci.add(i);
 }
@@ -56,7 +61,21 @@ FakeTPCreatorHeartbeatMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/
 void
 FakeTPCreatorHeartbeatMaker::do_conf(const nlohmann::json& conf)
 {
-  m_heartbeat_interval = conf.get<dunedaq::trigger::faketpcreatorheartbeatmaker::Conf>().heartbeat_interval;
+  auto params = conf.get<dunedaq::trigger::faketpcreatorheartbeatmaker::Conf>();
+  m_heartbeat_interval = params.heartbeat_interval;
+  m_heartbeat_clock = params.heartbeat_clock;
+  m_time_sync_connection = params.time_sync_connection;
+  m_clock_frequency_hz = params.clock_frequency_hz;
+  m_clock_heartbeat_delay = params.clock_heartbeat_delay;
+  m_tpset_wire_format = to_tpset_wire_format(params.tpset_wire_format);
+  m_conf_geoid.region_id = params.region_id;
+  m_conf_geoid.element_id = params.element_id;
+
+  // Heartbeats from the clock are on multiples of the interval
+  if (m_heartbeat_clock != faketpcreatorheartbeatmaker::heartbeat_clock::kNone &&
+      (m_heartbeat_interval == 0 || m_clock_frequency_hz == 0)) {
+    throw InvalidConfiguration(ERS_HERE);
+  }
   TLOG_DEBUG(2) << get_name() + " configured.";
 }
 
@@ -65,6 +84,29 @@ FakeTPCreatorHeartbeatMaker::do_start(const nlohmann::json& args)
 {
   rcif::cmd::StartParams start_params = args.get<rcif::cmd::StartParams>();
   m_run_number = start_params.run;
+  // Don't carry the origin of the last run's TPSets over into this one
+  m_geoid = m_conf_geoid;
+
+  switch (m_heartbeat_clock) {
+    case faketpcreatorheartbeatmaker::heartbeat_clock::kTimeSync:
+      TLOG_DEBUG(2) << "Creating TimestampEstimator";
+      m_timestamp_estimator.reset(new timinglibs::TimestampEstimator(
+        get_iom_receiver<dfmessages::TimeSync>(m_time_sync_connection), m_clock_frequency_hz));
+      break;
+    case faketpcreatorheartbeatmaker::heartbeat_clock::kSystemClock:
+      TLOG_DEBUG(2) << "Creating TimestampEstimatorSystem";
+      m_timestamp_estimator.reset(new timinglibs::TimestampEstimatorSystem(m_clock_frequency_hz));
+      break;
+    case faketpcreatorheartbeatmaker::heartbeat_clock::kNone:
+      break;
+  }
+
+  // Look at the clock about once per heartbeat interval when no TPSets arrive
+  m_receive_timeout = m_queue_timeout;
+  if (m_timestamp_estimator) {
+    auto const interval_ms = static_cast<int64_t>(m_heartbeat_interval * 1000 / m_clock_frequency_hz);
+    m_receive_timeout = std::clamp(std::chrono::milliseconds(interval_ms), std::chrono::milliseconds(1), m_queue_timeout);
+  }
 
   m_thread.start_working_thread("heartbeater");
   TLOG_DEBUG(2) << get_name() + " successfully started.";
@@ -74,6 +116,7 @@ void
 FakeTPCreatorHeartbeatMaker::do_stop(const nlohmann::json&)
 {
   m_thread.stop_working_thread();
+  m_timestamp_estimator.reset(nullptr); // Calls TimestampEstimator dtor
   TLOG_DEBUG(2) << get_name() + " successfully stopped.";
 }
 
@@ -84,56 +127,66 @@ FakeTPCreatorHeartbeatMaker::do_scrap(const nlohmann::json&)
 void
 FakeTPCreatorHeartbeatMaker::do_work(std::atomic<bool>& running_flag)
 {
+  // The format is per thread, and this thread does all the sending
+  set_tpset_wire_format(m_tpset_wire_format);
+
   // OpMon.
   m_tpset_received_count.store(0);
   m_tpset_sent_count.store(0);
   m_heartbeats_sent.store(0);
+  m_clock_heartbeats_sent.store(0);
+  m_late_tpset_count.store(0);
 
   bool is_first_tpset_received = true;
+  bool have_tpset_origin = false;
 
-  daqdataformats::timestamp_t last_sent_heartbeat_time;
+  daqdataformats::timestamp_t last_sent_heartbeat_time = 0;
+  // Heartbeats from the clock must not go back before a TPSet that was already sent
+  daqdataformats::timestamp_t last_tpset_start_time = 0;
+  // TPSets that start before a heartbeat sent from the clock are too late for it
+  daqdataformats::timestamp_t last_clock_heartbeat_time = 0;
 
   TPSet::seqno_t sequence_number = 0;
   
   while (true) {
-    std::optional<TPSet> tpset = m_input_queue->try_receive(m_queue_timeout);
-    if(!tpset.has_value()){
-      // The condition to exit the loop is that we've been stopped and
-      // there's nothing left on the input queue
-      if (!running_flag.load()) {
-        break;
-      } else {
-        continue;
-      }
-    }
-
-    // We got a TPSet
-    m_tpset_received_count++;
-    if (m_geoid.region_id == daqdataformats::GeoID::s_invalid_region_id) {
-      m_geoid = tpset->origin;
-    }
-    TLOG_DEBUG(3) << "Activity received.";
+    std::optional<TPSet> tpset = m_input_queue->try_receive(m_receive_timeout);
 
-    daqdataformats::timestamp_t current_tpset_start_time = tpset->start_time;
+    if (tpset.has_value()) {
+      // We got a TPSet
+      m_tpset_received_count++;
+      if (!have_tpset_origin) {
+        m_geoid = tpset->origin;
+        have_tpset_origin = true;
+      }
+      TLOG_DEBUG(3) << "Activity received.";
 
-    bool send_heartbeat =
-      should_send_heartbeat(last_sent_heartbeat_time, current_tpset_start_time, is_first_tpset_received);
+      daqdataformats::timestamp_t current_tpset_start_time = tpset->start_time;
+      if (current_tpset_start_time < last_clock_heartbeat_time) {
+        m_late_tpset_count++;
+        ers::warning(TardyInputSet(ERS_HERE,
+                                   get_name(),
+                                   tpset->origin.region_id,
+                                   tpset->origin.element_id,
+                                   current_tpset_start_time,
+                                   last_clock_heartbeat_time));
+      }
 
-    bool successfully_sent_real_tpset = false;
-    bool successfully_sent_heartbeat = false;
+      if (should_send_heartbeat(last_sent_heartbeat_time, current_tpset_start_time, is_first_tpset_received)) {
+        send_heartbeat(current_tpset_start_time, sequence_number);
+        last_sent_heartbeat_time = current_tpset_start_time;
+        is_first_tpset_received = false;
+      }
+      last_tpset_start_time = std::max(last_tpset_start_time, current_tpset_start_time);
 
-    if (send_heartbeat) {
-      TPSet tpset_heartbeat;
-      get_heartbeat(tpset_heartbeat, current_tpset_start_time);
-      tpset_heartbeat.seqno = sequence_number;
+      tpset->seqno = sequence_number;
       ++sequence_number;
-      while (!successfully_sent_heartbeat) {
+
+      bool successfully_sent_real_tpset = false;
+      while (!successfully_sent_real_tpset) {
         try {
-          m_output_queue->send(std::move(tpset_heartbeat), m_queue_timeout);
-          successfully_sent_heartbeat = true;
-          m_heartbeats_sent++;
-          last_sent_heartbeat_time = current_tpset_start_time;
-          is_first_tpset_received = false;
+          m_output_queue->send(std::move(*tpset), m_queue_timeout);
+          successfully_sent_real_tpset = true;
+          m_tpset_sent_count++;
         } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
           std::ostringstream oss_warn;
           oss_warn << "push to output queue \"" << m_output_queue->get_name() << "\"";
@@ -141,29 +194,67 @@ FakeTPCreatorHeartbeatMaker::do_work(std::atomic<bool>& running_flag)
             dunedaq::iomanager::TimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
         }
       }
+    } else if (!running_flag.load()) {
+      // The condition to exit the loop is that we've been stopped and
+      // there's nothing left on the input queue
+      break;
     }
-    
-    tpset->seqno = sequence_number;
-    ++sequence_number;
-
-    while (!successfully_sent_real_tpset) {
-      try {
-        m_output_queue->send(std::move(*tpset), m_queue_timeout);
-        successfully_sent_real_tpset = true;
-        m_tpset_sent_count++;
-      } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
-        std::ostringstream oss_warn;
-        oss_warn << "push to output queue \"" << m_output_queue->get_name() << "\"";
-        ers::warning(dunedaq::iomanager::TimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
+
+    // If the data time has got a whole interval past the last heartbeat
+    // without a TPSet arriving to send one, send one from the clock
+    if (m_timestamp_estimator) {
+      daqdataformats::timestamp_t const clock_heartbeat_time = get_clock_heartbeat_time();
+      if (clock_heartbeat_time > last_tpset_start_time &&
+          clock_heartbeat_time >= last_sent_heartbeat_time + m_heartbeat_interval) {
+        send_heartbeat(clock_heartbeat_time, sequence_number);
+        m_clock_heartbeats_sent++;
+        last_sent_heartbeat_time = clock_heartbeat_time;
+        last_clock_heartbeat_time = clock_heartbeat_time;
+        is_first_tpset_received = false;
       }
     }
   }
 
   TLOG() << "Received " << m_tpset_received_count << " and sent " << m_tpset_sent_count << " real TPSets. Sent "
-         << m_heartbeats_sent << " fake heartbeats." << std::endl;
+         << m_heartbeats_sent << " fake heartbeats, " << m_clock_heartbeats_sent << " of them from the clock. "
+         << m_late_tpset_count << " TPSets started before a heartbeat from the clock."
+         << std::endl;
   TLOG_DEBUG(2) << "Exiting do_work() method";
 }
 
+void
+FakeTPCreatorHeartbeatMaker::send_heartbeat(daqdataformats::timestamp_t const& heartbeat_time,
+                                            TPSet::seqno_t& sequence_number)
+{
+  TPSet tpset_heartbeat;
+  get_heartbeat(tpset_heartbeat, heartbeat_time);
+  tpset_heartbeat.seqno = sequence_number;
+  ++sequence_number;
+
+  bool successfully_sent_heartbeat = false;
+  while (!successfully_sent_heartbeat) {
+    try {
+      m_output_queue->send(std::move(tpset_heartbeat), m_queue_timeout);
+      successfully_sent_heartbeat = true;
+      m_heartbeats_sent++;
+    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+      std::ostringstream oss_warn;
+      oss_warn << "push to output queue \"" << m_output_queue->get_name() << "\"";
+      ers::warning(dunedaq::iomanager::TimeoutExpired(ERS_HERE, get_name(), oss_warn.str(), m_queue_timeout.count()));
+    }
+  }
+}
+
+daqdataformats::timestamp_t
+FakeTPCreatorHeartbeatMaker::get_clock_heartbeat_time() const
+{
+  dfmessages::timestamp_t const now = m_timestamp_estimator->get_timestamp_estimate();
+  if (now == dfmessages::TypeDefaults::s_invalid_timestamp || now < m_clock_heartbeat_delay) {
+    return 0;
+  }
+  return (now - m_clock_heartbeat_delay) / m_heartbeat_interval * m_heartbeat_interval;
+}
+
 bool
 FakeTPCreatorHeartbeatMaker::should_send_heartbeat(daqdataformats::timestamp_t const& last_sent_heartbeat_time,
                                                    daqdataformats::timestamp_t const& current_tpset_start_time,
@@ -11,14 +11,18 @@
 
 #include "trigger/Issues.hpp"
 #include "trigger/TPSet.hpp"
+#include "trigger/TPSetWireFormat.hpp"
 #include "trigger/faketpcreatorheartbeatmaker/Nljs.hpp"
 #include "trigger/faketpcreatorheartbeatmakerinfo/InfoNljs.hpp"
 
 #include "appfwk/DAQModule.hpp"
+#include "dfmessages/TimeSync.hpp"
 #include "iomanager/Receiver.hpp"
 #include "iomanager/Sender.hpp"
+#include "timinglibs/TimestampEstimator.hpp"
 #include "utilities/WorkerThread.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <memory>
@@ -51,6 +55,12 @@ private:
                              daqdataformats::timestamp_t const& current_tpset_start_time,
                              bool const& is_first_tpset_received);
   void get_heartbeat(TPSet& tpset_heartbeat, daqdataformats::timestamp_t const& current_tpset_start_time);
+  void send_heartbeat(daqdataformats::timestamp_t const& heartbeat_time, TPSet::seqno_t& sequence_number);
+
+  // The latest multiple of m_heartbeat_interval that is at least
+  // m_clock_heartbeat_delay behind the estimated data time, or 0 if there
+  // isn't an estimate yet
+  daqdataformats::timestamp_t get_clock_heartbeat_time() const;
 
   dunedaq::utilities::WorkerThread m_thread;
 
@@ -63,17 +73,33 @@ private:
 
   triggeralgs::timestamp_t m_heartbeat_interval;
 
+  TPSetWireFormat m_tpset_wire_format{ TPSetWireFormat::kMsgPack };
+
+  // Sending heartbeats when no TPSets arrive. Only used if m_heartbeat_clock isn't kNone
+  faketpcreatorheartbeatmaker::heartbeat_clock m_heartbeat_clock{ faketpcreatorheartbeatmaker::heartbeat_clock::kNone };
+  std::string m_time_sync_connection;
+  uint64_t m_clock_frequency_hz{ 0 }; // NOLINT(build/unsigned)
+  daqdataformats::timestamp_t m_clock_heartbeat_delay{ 0 };
+  std::unique_ptr<timinglibs::TimestampEstimatorBase> m_timestamp_estimator;
+  // How long to wait for a TPSet before looking at the clock again
+  std::chrono::milliseconds m_receive_timeout;
+
   daqdataformats::run_number_t m_run_number{ daqdataformats::TypeDefaults::s_invalid_run_number };
 
-  daqdataformats::GeoID m_geoid{
+  // The origin of the heartbeats is m_conf_geoid at the start of each run,
+  // and the origin of the first TPSet received once one arrives
+  daqdataformats::GeoID m_conf_geoid{
     daqdataformats::GeoID::SystemType::kDataSelection,
     daqdataformats::GeoID::s_invalid_region_id,
     daqdataformats::GeoID::s_invalid_element_id };
+  daqdataformats::GeoID m_geoid{ m_conf_geoid };
   // Opmon variables
   using metric_counter_type = decltype(faketpcreatorheartbeatmakerinfo::Info::tpset_received_count);
   std::atomic<metric_counter_type> m_tpset_received_count{ 0 };
   std::atomic<metric_counter_type> m_tpset_sent_count{ 0 };
   std::atomic<metric_counter_type> m_heartbeats_sent{ 0 };
+  std::atomic<metric_counter_type> m_clock_heartbeats_sent{ 0 };
+  std::atomic<metric_counter_type> m_late_tpset_count{ 0 };
 };
 } // namespace trigger
 } // namespace dunedaq
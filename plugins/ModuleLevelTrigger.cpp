@@ -11,6 +11,7 @@
 
 #include "trigger/Issues.hpp"
 #include "trigger/LivetimeCounter.hpp"
+#include "trigger/LogHistogram.hpp"
 #include "trigger/moduleleveltrigger/Nljs.hpp"
 
 #include "appfwk/DAQModuleHelper.hpp"
@@ -26,15 +27,35 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
 #include <pthread.h>
 #include <random>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace dunedaq {
 namespace trigger {
 
+namespace {
+std::map<TCTypeLimiter::type_t, TCTypeLimiter::Limits>
+make_tc_type_limits(const moduleleveltrigger::tc_type_limits& conf)
+{
+  std::map<TCTypeLimiter::type_t, TCTypeLimiter::Limits> limits;
+  for (auto const& type_conf : conf) {
+    TCTypeLimiter::Limits& type_limits = limits[type_conf.tc_type];
+    type_limits.prescale = type_conf.prescale;
+    type_limits.rate_limit_hz = type_conf.rate_limit_hz;
+    type_limits.rate_limit_burst = type_conf.rate_limit_burst;
+    TLOG_DEBUG(0) << "TC type " << type_conf.tc_type << ": prescale " << type_limits.prescale << ", rate limit "
+                  << type_limits.rate_limit_hz << " Hz with bursts of " << type_limits.rate_limit_burst;
+  }
+  return limits;
+}
+} // namespace
+
 ModuleLevelTrigger::ModuleLevelTrigger(const std::string& name)
   : DAQModule(name)
   , m_last_trigger_number(0)
@@ -47,6 +68,7 @@ ModuleLevelTrigger::ModuleLevelTrigger(const std::string& name)
   register_command("pause",  &ModuleLevelTrigger::do_pause);
   register_command("resume", &ModuleLevelTrigger::do_resume);
   register_command("scrap",  &ModuleLevelTrigger::do_scrap);
+  register_command("set_tc_type_limits", &ModuleLevelTrigger::do_set_tc_type_limits);
   // clang-format on
 }
 
@@ -64,9 +86,43 @@ ModuleLevelTrigger::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   i.tc_received_count = m_tc_received_count.load();
 
   i.td_sent_count = m_td_sent_count.load();
+  i.td_queue_timeout_expired_err_count = m_td_queue_timeout_expired_err_count.load();
   i.td_inhibited_count = m_td_inhibited_count.load();
+  i.td_held_count = m_td_held_count.load();
+  i.td_send_failure_count = m_td_send_failure_count.load();
+  i.tc_td_latency_mean_us = static_cast<uint64_t>(m_tc_td_latency.get_mean()); // NOLINT(build/unsigned)
+  i.tc_td_latency_p50_us = m_tc_td_latency.get_quantile(0.5);
+  i.tc_td_latency_p90_us = m_tc_td_latency.get_quantile(0.9);
+  i.tc_td_latency_p99_us = m_tc_td_latency.get_quantile(0.99);
+  i.tc_td_latency_max_us = m_tc_td_latency.get_max();
+  {
+    const LogHistogram& retry_latency = m_td_send_queue.get_retry_latency();
+    i.td_retried_count = retry_latency.get_count();
+    i.td_retry_latency_mean_us = static_cast<uint64_t>(retry_latency.get_mean()); // NOLINT(build/unsigned)
+    i.td_retry_latency_p99_us = retry_latency.get_quantile(0.99);
+    i.td_retry_latency_max_us = retry_latency.get_max();
+  }
+  i.td_hold_released_count = m_td_hold_released_count.load();
+  i.td_hold_dropped_count = m_td_hold_dropped_count.load();
   i.td_paused_count = m_td_paused_count.load();
   i.td_total_count = m_td_total_count.load();
+  i.tc_merged_count = m_tc_merged_count.load();
+  i.td_merged_count = m_td_merged_count.load();
+  i.tc_prescaled_count = m_tc_prescaled_count.load();
+  i.tc_rate_limited_count = m_tc_rate_limited_count.load();
+  i.td_token_wait_count = m_td_token_wait_count.load();
+  i.token_wait_time_us = m_token_wait_time_us.load();
+  i.td_no_token_count = m_td_no_token_count.load();
+  if (m_token_manager.get() != nullptr) {
+    i.td_in_flight = std::max(m_initial_tokens - m_token_manager->get_n_tokens(), 0);
+    const LogHistogram& latency = m_token_manager->get_latency_histogram();
+    i.td_latency_count = latency.get_count();
+    i.td_latency_mean_us = static_cast<uint64_t>(latency.get_mean()); // NOLINT(build/unsigned)
+    i.td_latency_p50_us = latency.get_quantile(0.5);
+    i.td_latency_p90_us = latency.get_quantile(0.9);
+    i.td_latency_p99_us = latency.get_quantile(0.99);
+    i.td_latency_max_us = latency.get_max();
+  }
 
   if (m_livetime_counter.get() != nullptr) {
     i.lc_kLive = m_livetime_counter->get_time(LivetimeCounter::State::kLive);
@@ -75,6 +131,57 @@ ModuleLevelTrigger::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   }
 
   ci.add(i);
+
+  for (auto const& [type, counts] : m_tc_type_limiter.get_counts()) {
+    moduleleveltriggerinfo::TCTypeInfo type_info;
+    type_info.accepted = counts.accepted;
+    type_info.prescaled = counts.prescaled;
+    type_info.rate_limited = counts.rate_limited;
+    opmonlib::InfoCollector type_ci;
+    type_ci.add(type_info);
+    ci.add("tc_type_" + std::to_string(type), type_ci);
+  }
+
+  if (m_livetime_counter.get() != nullptr) {
+    const std::pair<LivetimeCounter::State, std::string> states[] = { { LivetimeCounter::State::kLive, "lc_kLive" },
+                                                                      { LivetimeCounter::State::kDead, "lc_kDead" },
+                                                                      { LivetimeCounter::State::kPaused, "lc_kPaused" } };
+    for (auto const& [state, name] : states) {
+      const LogHistogram& episodes = m_livetime_counter->get_episode_histogram(state);
+      moduleleveltriggerinfo::LivetimeStateInfo state_info;
+      state_info.episodes = episodes.get_count();
+      state_info.mean_us = static_cast<uint64_t>(episodes.get_mean()); // NOLINT(build/unsigned)
+      state_info.p50_us = episodes.get_quantile(0.5);
+      state_info.p90_us = episodes.get_quantile(0.9);
+      state_info.p99_us = episodes.get_quantile(0.99);
+      state_info.longest_us = episodes.get_max();
+      opmonlib::InfoCollector state_ci;
+      state_ci.add(state_info);
+      for (size_t bin = 0; bin < LogHistogram::s_n_bins; ++bin) {
+        if (episodes.get_bin_count(bin) != 0) {
+          moduleleveltriggerinfo::LivetimeEpisodeBinInfo bin_info;
+          bin_info.count = episodes.get_bin_count(bin);
+          opmonlib::InfoCollector bin_ci;
+          bin_ci.add(bin_info);
+          state_ci.add("lt_" + std::to_string(LogHistogram::get_bin_upper_edge(bin)) + "us", bin_ci);
+        }
+      }
+      ci.add(name, state_ci);
+    }
+  }
+
+  if (m_token_manager.get() != nullptr) {
+    const LogHistogram& latency = m_token_manager->get_latency_histogram();
+    for (size_t bin = 0; bin < LogHistogram::s_n_bins; ++bin) {
+      if (latency.get_bin_count(bin) != 0) {
+        moduleleveltriggerinfo::TDLatencyBinInfo bin_info;
+        bin_info.count = latency.get_bin_count(bin);
+        opmonlib::InfoCollector bin_ci;
+        bin_ci.add(bin_info);
+        ci.add("td_latency_lt_" + std::to_string(LogHistogram::get_bin_upper_edge(bin)) + "us", bin_ci);
+      }
+    }
+  }
 }
 
 void
@@ -87,9 +194,39 @@ ModuleLevelTrigger::do_configure(const nlohmann::json& confobj)
     m_links.push_back(
       dfmessages::GeoID{ daqdataformats::GeoID::string_to_system_type(link.system), link.region, link.element });
   }
+
+  std::vector<ReadoutMap::Region> regions;
+  for (auto const& region : params.readout_regions) {
+    regions.push_back({ region.region, region.first_channel, region.last_channel });
+  }
+  std::map<ReadoutMap::type_t, ReadoutMap::TypeReadout> type_readouts;
+  for (auto const& type_readout : params.tc_type_readouts) {
+    ReadoutMap::TypeReadout& readout = type_readouts[type_readout.tc_type];
+    readout.localized = type_readout.localized;
+    readout.window_before = type_readout.window_before;
+    readout.window_after = type_readout.window_after;
+  }
+  try {
+    m_readout_map = ReadoutMap(m_links, regions, type_readouts);
+  } catch (const BadReadoutMap& e) {
+    throw InvalidConfiguration(ERS_HERE, e);
+  }
+
   m_trigger_decision_connection = params.dfo_connection;
   m_inhibit_connection = params.dfo_busy_connection;
+  m_token_connection = params.token_connection;
+  m_initial_tokens = params.initial_token_count;
   m_hsi_passthrough = params.hsi_trigger_type_passthrough;
+  m_tc_merging_window = std::chrono::microseconds(params.tc_merging_window_us);
+  m_tc_type_limiter.set_limits(make_tc_type_limits(params.tc_type_limits), TCTypeLimiter::clock_type::now());
+  std::map<HeldDecisionQueue::type_t, int> priorities;
+  for (auto const& type_priority : params.tc_type_priorities) {
+    priorities[type_priority.tc_type] = type_priority.priority;
+  }
+  m_td_send_timeout = std::chrono::milliseconds(params.td_send_timeout_ms);
+  m_td_send_queue.configure(params.td_retry_queue_depth, std::chrono::milliseconds(params.td_max_retry_time_ms));
+  m_held_decisions = HeldDecisionQueue(
+    params.inhibit_hold_depth, std::chrono::milliseconds(params.inhibit_hold_max_age_ms), priorities);
 
   m_configured_flag.store(true);
 }
@@ -104,10 +241,23 @@ ModuleLevelTrigger::do_start(const nlohmann::json& startobj)
   m_dfo_is_busy.store(false);
 
   m_livetime_counter.reset(new LivetimeCounter(LivetimeCounter::State::kPaused));
+  m_livetime_state.reset(new LivetimeStateTracker(m_livetime_counter));
+
+  if (m_initial_tokens > 0) {
+    m_token_manager.reset(new TokenManager(
+      m_token_connection,
+      m_initial_tokens,
+      m_run_number,
+      [this](bool triggers_allowed) { m_livetime_state->set_triggers_allowed(triggers_allowed); },
+      [this]() { m_tc_events.notify(); }));
+  }
 
   m_inhibit_receiver = get_iom_receiver<dfmessages::TriggerInhibit>(m_inhibit_connection);
   m_inhibit_receiver->add_callback(std::bind(&ModuleLevelTrigger::dfo_busy_callback, this, std::placeholders::_1));
 
+  m_tc_events.open();
+  m_candidate_source->add_callback(std::bind(&ModuleLevelTrigger::candidate_callback, this, std::placeholders::_1));
+
   m_send_trigger_decisions_thread = std::thread(&ModuleLevelTrigger::send_trigger_decisions, this);
   pthread_setname_np(m_send_trigger_decisions_thread.native_handle(), "mlt-trig-dec");
   ers::info(TriggerStartOfRun(ERS_HERE, m_run_number));
@@ -116,15 +266,29 @@ ModuleLevelTrigger::do_start(const nlohmann::json& startobj)
 void
 ModuleLevelTrigger::do_stop(const nlohmann::json& /*stopobj*/)
 {
+  // Stop taking TCs while the send_trigger_decisions thread is still
+  // draining the queue, so that a callback waiting for space gets it. The
+  // thread mustn't wait for tokens meanwhile, as none may come back, so it
+  // is told we are stopping first. Once it sees we've stopped, it takes
+  // whatever is left on the queue before exiting, so no TC that was queued
+  // is lost
+  m_tc_events.stop();
+  m_candidate_source->remove_callback();
+  m_tc_events.close();
+
   m_running_flag.store(false);
+  m_tc_events.notify();
   m_send_trigger_decisions_thread.join();
 
+  m_token_manager.reset(); // Calls TokenManager dtor, which reports any decisions still in flight
+  m_inhibit_receiver->remove_callback();
+  m_livetime_state.reset();
+
   m_lc_deadtime = m_livetime_counter->get_time(LivetimeCounter::State::kDead) +
                   m_livetime_counter->get_time(LivetimeCounter::State::kPaused);
   TLOG(3) << "LivetimeCounter - total deadtime+paused: " << m_lc_deadtime << std::endl;
   m_livetime_counter.reset(); // Calls LivetimeCounter dtor?
 
-  m_inhibit_receiver->remove_callback();
   ers::info(TriggerEndOfRun(ERS_HERE, m_run_number));
 }
 
@@ -132,7 +296,8 @@ void
 ModuleLevelTrigger::do_pause(const nlohmann::json& /*pauseobj*/)
 {
   m_paused.store(true);
-  m_livetime_counter->set_state(LivetimeCounter::State::kPaused);
+  m_tc_events.notify();
+  m_livetime_state->set_paused(true);
   TLOG() << "******* Triggers PAUSED! *********";
   ers::info(TriggerPaused(ERS_HERE));
 }
@@ -142,50 +307,202 @@ ModuleLevelTrigger::do_resume(const nlohmann::json& /*resumeobj*/)
 {
   ers::info(TriggerActive(ERS_HERE));
   TLOG() << "******* Triggers RESUMED! *********";
-  m_livetime_counter->set_state(LivetimeCounter::State::kLive);
+  m_livetime_state->set_paused(false);
   m_paused.store(false);
+  m_tc_events.notify();
 }
 
 void
 ModuleLevelTrigger::do_scrap(const nlohmann::json& /*scrapobj*/)
 {
   m_links.clear();
+  m_readout_map = ReadoutMap();
   m_configured_flag.store(false);
 }
 
+void
+ModuleLevelTrigger::do_set_tc_type_limits(const nlohmann::json& obj)
+{
+  auto params = obj.get<moduleleveltrigger::TCTypeLimitsParams>();
+  m_tc_type_limiter.set_limits(make_tc_type_limits(params.tc_type_limits), TCTypeLimiter::clock_type::now());
+  TLOG() << get_name() << ": set prescales and rate limits for " << params.tc_type_limits.size() << " TC types";
+}
+
+dfmessages::trigger_type_t
+ModuleLevelTrigger::get_trigger_type(const triggeralgs::TriggerCandidate& tc) const
+{
+  if (m_hsi_passthrough == true) {
+    if (tc.type == triggeralgs::TriggerCandidate::Type::kTiming) {
+      return tc.detid & 0xff;
+    } else {
+      return ((int)tc.type << 8);
+    }
+  }
+  return 1; // m_trigger_type;
+}
+
 dfmessages::TriggerDecision
-ModuleLevelTrigger::create_decision(const triggeralgs::TriggerCandidate& tc)
+ModuleLevelTrigger::create_decision(const TCGroup& group)
 {
   dfmessages::TriggerDecision decision;
   decision.trigger_number = m_last_trigger_number + 1;
   decision.run_number = m_run_number;
-  decision.trigger_timestamp = tc.time_candidate;
+  decision.trigger_timestamp = group.time_candidate;
   decision.readout_type = dfmessages::ReadoutType::kLocalized;
 
-  if (m_hsi_passthrough == true) {
-    if (tc.type == triggeralgs::TriggerCandidate::Type::kTiming) {
-      decision.trigger_type = tc.detid & 0xff;
-    } else {
-      m_trigger_type_shifted = ((int)tc.type << 8);
-      decision.trigger_type = m_trigger_type_shifted;
+  // The trigger types of merged TCs are ORed together
+  decision.trigger_type = 0;
+  for (auto const& tc : group.tcs) {
+    dfmessages::trigger_type_t tc_trigger_type = get_trigger_type(tc);
+    decision.trigger_type |= tc_trigger_type;
+
+    TLOG_DEBUG(3) << "HSI passthrough: " << m_hsi_passthrough << ", TC detid: " << tc.detid
+                  << ", TC type: " << (int)tc.type << ", TC trigger type: " << tc_trigger_type;
+  }
+  TLOG_DEBUG(3) << "DECISION trigger type: " << decision.trigger_type << " from " << group.tcs.size() << " TCs";
+
+  m_readout_map.fill_components(group.tcs, decision.components);
+
+  return decision;
+}
+
+bool
+ModuleLevelTrigger::wait_for_token()
+{
+  if (m_token_manager->triggers_allowed()) {
+    return true;
+  }
+  ++m_td_token_wait_count;
+  auto wait_start = std::chrono::steady_clock::now();
+  // TokenManager wakes us when a token comes back. While stopping, no more
+  // may come back, so we don't wait, and the TCs left are drained instead
+  bool const have_token = m_tc_events.wait_unless_stopping([this]() {
+    return m_token_manager->triggers_allowed() || !m_running_flag.load() || m_paused.load() || m_dfo_is_busy.load();
+  });
+  m_token_wait_time_us +=
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wait_start).count();
+  return have_token && m_token_manager->triggers_allowed();
+}
+
+void
+ModuleLevelTrigger::flush_decisions(iomanager::SenderConcept<dfmessages::TriggerDecision>& td_sender)
+{
+  if (m_td_send_queue.empty()) {
+    return;
+  }
+  std::vector<dfmessages::TriggerDecision> dropped;
+  m_td_send_queue.flush(
+    [&](dfmessages::TriggerDecision& decision) {
+      try {
+        // Send a copy, so that the decision is still there to retry if the send fails
+        td_sender.send(dfmessages::TriggerDecision(decision), m_td_send_timeout);
+        m_td_sent_count++;
+        return true;
+      } catch (const ers::Issue& e) {
+        TLOG_DEBUG(1) << "Failed to send trigger decision " << decision.trigger_number << ": " << e.what();
+        ++m_td_send_failure_count;
+        return false;
+      }
+    },
+    SendRetryQueue<dfmessages::TriggerDecision>::clock_type::now(),
+    dropped);
+
+  for (auto const& decision : dropped) {
+    ers::error(TriggerDecisionDropped(ERS_HERE, decision.trigger_number, m_run_number));
+    m_td_queue_timeout_expired_err_count++;
+    if (m_token_manager) {
+      m_token_manager->trigger_not_sent(decision.trigger_number);
     }
-  } else {
-    decision.trigger_type = 1; // m_trigger_type;
   }
+}
 
-  TLOG_DEBUG(3) << "HSI passthrough: " << m_hsi_passthrough << ", TC detid: " << tc.detid
-                << ", TC type: " << (int)tc.type << ", DECISION trigger type: " << decision.trigger_type;
+bool
+ModuleLevelTrigger::hold_decision(const TCGroup& group)
+{
+  switch (m_held_decisions.hold(group, HeldDecisionQueue::clock_type::now())) {
+    case HeldDecisionQueue::Result::kHeld:
+      break;
+    case HeldDecisionQueue::Result::kHeldReplacing:
+      ++m_td_hold_dropped_count;
+      ++m_td_inhibited_count;
+      break;
+    case HeldDecisionQueue::Result::kNotHeld:
+      return false;
+  }
+  ++m_td_held_count;
+  TLOG_DEBUG(1) << "The DFO is busy. Holding the TriggerDecision for candidate timestamp " << group.time_candidate;
+  return true;
+}
 
-  for (auto link : m_links) {
-    dfmessages::ComponentRequest request;
-    request.component = link;
-    request.window_begin = tc.time_start;
-    request.window_end = tc.time_end;
+void
+ModuleLevelTrigger::release_held_decisions(iomanager::SenderConcept<dfmessages::TriggerDecision>& td_sender)
+{
+  if (m_held_decisions.empty()) {
+    return;
+  }
+  size_t const n_expired = m_held_decisions.drop_expired(HeldDecisionQueue::clock_type::now());
+  m_td_hold_dropped_count += n_expired;
+  m_td_inhibited_count += n_expired;
+
+  TCGroup group;
+  while (!m_paused.load() && !m_dfo_is_busy.load() && m_held_decisions.release(group)) {
+    ++m_td_hold_released_count;
+    send_decision(group, td_sender, true);
+  }
+}
 
-    decision.components.push_back(request);
+void
+ModuleLevelTrigger::send_decision(const TCGroup& group,
+                                  iomanager::SenderConcept<dfmessages::TriggerDecision>& td_sender,
+                                  bool released)
+{
+  // With no tokens, hold this decision (and so the TCs behind it) until the
+  // dataflow has finished with an earlier one
+  bool have_token = true;
+  if (m_token_manager && !m_paused.load() && !m_dfo_is_busy.load()) {
+    have_token = wait_for_token();
   }
 
-  return decision;
+  if (!m_paused.load() && !m_dfo_is_busy.load() && have_token) {
+
+    dfmessages::TriggerDecision decision = create_decision(group);
+    m_tc_td_latency.add(std::chrono::duration_cast<std::chrono::microseconds>(TCCoalescer::clock_type::now() -
+                                                                              group.arrival_time)
+                          .count());
+    // The decision keeps its number through any retries, even if it is dropped in the end
+    m_last_trigger_number++;
+    // TokenManager has to know about the decision before the DFO can send back its token
+    if (m_token_manager) {
+      m_token_manager->trigger_sent(decision.trigger_number);
+    }
+    if (group.tcs.size() > 1) {
+      ++m_td_merged_count;
+      m_tc_merged_count += group.tcs.size() - 1;
+    }
+
+    TLOG_DEBUG(1) << "Sending a decision with triggernumber " << decision.trigger_number << " timestamp "
+                  << decision.trigger_timestamp << " number of links " << decision.components.size()
+                  << " based on " << group.tcs.size() << " TCs, the first of type "
+                  << static_cast<std::underlying_type_t<triggeralgs::TriggerCandidate::Type>>(group.tcs.front().type);
+
+    m_td_send_queue.push(std::move(decision), SendRetryQueue<dfmessages::TriggerDecision>::clock_type::now());
+    flush_decisions(td_sender);
+
+  } else if (m_paused.load()) {
+    ++m_td_paused_count;
+    TLOG_DEBUG(1) << "Triggers are paused. Not sending a TriggerDecision ";
+  } else if (!have_token) {
+    ++m_td_no_token_count;
+    TLOG_DEBUG(1) << "No tokens came back before the run stopped. Not sending a TriggerDecision for candidate timestamp "
+                  << group.time_candidate;
+  } else if (!hold_decision(group)) {
+    ers::warning(TriggerInhibited(ERS_HERE, m_run_number));
+    TLOG_DEBUG(1) << "The DFO is busy. Not sending a TriggerDecision for candidate timestamp " << group.time_candidate;
+    m_td_inhibited_count++;
+  }
+  if (!released) {
+    m_td_total_count++;
+  }
 }
 
 void
@@ -198,63 +515,111 @@ ModuleLevelTrigger::send_trigger_decisions()
   // OpMon.
   m_tc_received_count.store(0);
   m_td_sent_count.store(0);
+  m_td_queue_timeout_expired_err_count.store(0);
   m_td_inhibited_count.store(0);
+  m_td_held_count.store(0);
+  m_td_send_failure_count.store(0);
+  m_td_send_queue.reset_counts();
+  m_tc_td_latency.reset();
+  m_td_hold_released_count.store(0);
+  m_td_hold_dropped_count.store(0);
   m_td_paused_count.store(0);
   m_td_total_count.store(0);
   m_lc_kLive.store(0);
   m_lc_kPaused.store(0);
   m_lc_kDead.store(0);
 
+  m_tc_merged_count.store(0);
+  m_td_merged_count.store(0);
+  m_tc_prescaled_count.store(0);
+  m_tc_rate_limited_count.store(0);
+  m_td_token_wait_count.store(0);
+  m_token_wait_time_us.store(0);
+  m_td_no_token_count.store(0);
+  m_tc_type_limiter.reset_counts();
+
   auto td_sender = get_iom_sender<dfmessages::TriggerDecision>(m_trigger_decision_connection);
 
+  // TCs with overlapping readout windows that arrive within
+  // m_tc_merging_window of each other make one decision
+  TCCoalescer coalescer(m_tc_merging_window, &m_readout_map);
+  TCGroup ready;
+
+  std::vector<TCEventQueue::ReceivedTC> tcs;
+
   while (true) {
-    std::optional<triggeralgs::TriggerCandidate> tc = m_candidate_source->try_receive(std::chrono::milliseconds(100));
-    if (!tc.has_value()) {
-      // The condition to exit the loop is that we've been stopped and
-      // there's nothing left on the input queue
-      if (!m_running_flag.load()) {
-        break;
-      } else {
-        continue;
+    // Wait for TCs or anything else to happen, but not past when the TCs
+    // being merged are due, and not for long if decisions need sending again
+    auto now = TCCoalescer::clock_type::now();
+    auto deadline = std::min(coalescer.get_deadline(), now + std::chrono::seconds(1));
+    if (!m_td_send_queue.empty()) {
+      deadline = std::min(deadline, now + std::chrono::milliseconds(1));
+    }
+    // Take all the TCs that have arrived
+    bool const running = !m_tc_events.wait_and_take(deadline, tcs, [this]() { return !m_running_flag.load(); });
+
+    // Decisions waiting to be retried or held go before any new ones
+    flush_decisions(*td_sender);
+    release_held_decisions(*td_sender);
+
+    for (auto& received : tcs) {
+      triggeralgs::TriggerCandidate& tc = received.tc;
+      ++m_tc_received_count;
+      // TCs dropped by their type's limits don't make decisions, or widen others' readout windows
+      switch (m_tc_type_limiter.check(tc.type, received.arrival_time)) {
+        case TCTypeLimiter::Result::kAccepted:
+          // A group that was due before this TC arrived doesn't take it in, even if they arrived in one batch
+          if (coalescer.flush_due(received.arrival_time, ready)) {
+            send_decision(ready, *td_sender);
+          }
+          if (coalescer.add(std::move(tc), received.arrival_time, ready)) {
+            send_decision(ready, *td_sender);
+          }
+          break;
+        case TCTypeLimiter::Result::kPrescaled:
+          ++m_tc_prescaled_count;
+          break;
+        case TCTypeLimiter::Result::kRateLimited:
+          TLOG_DEBUG(1) << "Rate limit reached for TC type " << static_cast<TCTypeLimiter::type_t>(tc.type)
+                        << ". Dropping TC with timestamp " << tc.time_candidate;
+          ++m_tc_rate_limited_count;
+          break;
       }
     }
+    bool const got_tcs = !tcs.empty();
+    tcs.clear();
 
-    // We got a TC
-    ++m_tc_received_count;
-
-    if (!m_paused.load() && !m_dfo_is_busy.load()) {
-
-      dfmessages::TriggerDecision decision = create_decision(*tc);
-
-      TLOG_DEBUG(1) << "Sending a decision with triggernumber " << decision.trigger_number << " timestamp "
-                    << decision.trigger_timestamp << " number of links " << decision.components.size()
-                    << " based on TC of type " << static_cast<std::underlying_type_t<decltype(tc->type)>>(tc->type);
+    if (coalescer.flush_due(TCCoalescer::clock_type::now(), ready)) {
+      send_decision(ready, *td_sender);
+    }
 
-      try {
-        td_sender->send(std::move(decision), std::chrono::milliseconds(1));
-        m_td_sent_count++;
-        m_last_trigger_number++;
-      } catch (const ers::Issue& e) {
-        ers::error(e);
-        TLOG_DEBUG(1) << "The network is misbehaving: it accepted TD but the send failed for " << tc->time_candidate;
-        m_td_queue_timeout_expired_err_count++;
+    // The condition to exit the loop is that we've been stopped and
+    // there's nothing left on the input queue. No more TCs arrive once we've
+    // been stopped, so the queue was drained when we last took from it
+    if (!got_tcs && !running) {
+      if (coalescer.flush(ready)) {
+        send_decision(ready, *td_sender);
       }
-
-    } else if (m_paused.load()) {
-      ++m_td_paused_count;
-      TLOG_DEBUG(1) << "Triggers are paused. Not sending a TriggerDecision ";
-    } else {
-      ers::warning(TriggerInhibited(ERS_HERE, m_run_number));
-      TLOG_DEBUG(1) << "The DFO is busy. Not sending a TriggerDecision for candidate timestamp " << tc->time_candidate;
-      m_td_inhibited_count++;
+      release_held_decisions(*td_sender);
+      // Give decisions that failed to send until their retry time is up
+      while (!m_td_send_queue.empty()) {
+        flush_decisions(*td_sender);
+      }
+      m_td_hold_dropped_count += m_held_decisions.size();
+      m_td_inhibited_count += m_held_decisions.size();
+      m_held_decisions.clear();
+      break;
     }
-    m_td_total_count++;
   }
 
   TLOG() << "Run " << m_run_number << ": "
          << "Received " << m_tc_received_count << " TCs. Sent " << m_td_sent_count.load() << " TDs. "
          << m_td_paused_count << " TDs were created during pause, and " << m_td_inhibited_count.load()
-         << " TDs were inhibited.";
+         << " TDs were inhibited. " << m_tc_merged_count.load() << " TCs were merged into "
+         << m_td_merged_count.load() << " TDs with others. " << m_tc_prescaled_count.load()
+         << " TCs were prescaled, and " << m_tc_rate_limited_count.load() << " were rate limited. "
+         << m_td_held_count.load() << " TDs were held while the DFO was busy, and " << m_td_hold_released_count.load()
+         << " of them were released.";
 
   m_lc_kLive_count = m_livetime_counter->get_time(LivetimeCounter::State::kLive);
   m_lc_kPaused_count = m_livetime_counter->get_time(LivetimeCounter::State::kPaused);
@@ -267,12 +632,22 @@ ModuleLevelTrigger::send_trigger_decisions()
                   m_livetime_counter->get_time(LivetimeCounter::State::kPaused);
 }
 
+void
+ModuleLevelTrigger::candidate_callback(triggeralgs::TriggerCandidate& tc)
+{
+  auto const time_candidate = tc.time_candidate;
+  if (!m_tc_events.push(std::move(tc), TCEventQueue::clock_type::now())) {
+    TLOG_DEBUG(1) << "Not running. Dropping TC with timestamp " << time_candidate;
+  }
+}
+
 void
 ModuleLevelTrigger::dfo_busy_callback(dfmessages::TriggerInhibit& inhibit)
 {
   if (inhibit.run_number == m_run_number) {
     m_dfo_is_busy = inhibit.busy;
-    m_livetime_counter->set_state(LivetimeCounter::State::kDead);
+    m_tc_events.notify();
+    m_livetime_state->set_dfo_busy(inhibit.busy);
   }
 }
 
@@ -14,7 +14,15 @@
 #ifndef TRIGGER_PLUGINS_MODULELEVELTRIGGER_HPP_
 #define TRIGGER_PLUGINS_MODULELEVELTRIGGER_HPP_
 
+#include "trigger/HeldDecisionQueue.hpp"
 #include "trigger/LivetimeCounter.hpp"
+#include "trigger/LivetimeStateTracker.hpp"
+#include "trigger/LogHistogram.hpp"
+#include "trigger/ReadoutMap.hpp"
+#include "trigger/SendRetryQueue.hpp"
+#include "trigger/TCCoalescer.hpp"
+#include "trigger/TCEventQueue.hpp"
+#include "trigger/TCTypeLimiter.hpp"
 #include "trigger/TokenManager.hpp"
 #include "trigger/moduleleveltriggerinfo/InfoNljs.hpp"
 
@@ -26,9 +34,11 @@
 #include "dfmessages/TriggerInhibit.hpp"
 #include "dfmessages/Types.hpp"
 #include "iomanager/Receiver.hpp"
+#include "iomanager/Sender.hpp"
 #include "timinglibs/TimestampEstimator.hpp"
 #include "triggeralgs/TriggerCandidate.hpp"
 
+#include <chrono>
 #include <memory>
 #include <set>
 #include <string>
@@ -68,21 +78,70 @@ private:
   void do_pause(const nlohmann::json& obj);
   void do_resume(const nlohmann::json& obj);
   void do_scrap(const nlohmann::json& obj);
+  void do_set_tc_type_limits(const nlohmann::json& obj);
 
   void send_trigger_decisions();
   std::thread m_send_trigger_decisions_thread;
 
-  // Create the next trigger decision
-  dfmessages::TriggerDecision create_decision(const triggeralgs::TriggerCandidate& tc);
-  dfmessages::trigger_type_t m_trigger_type_shifted;
+  // Create the next trigger decision, reading out the union of the TCs' windows
+  dfmessages::TriggerDecision create_decision(const TCGroup& group);
+  dfmessages::trigger_type_t get_trigger_type(const triggeralgs::TriggerCandidate& tc) const;
+
+  // Send a trigger decision for the group, unless triggers are paused or inhibited. released is
+  // true for groups that were held while the DFO was busy, and so have already been counted
+  void send_decision(const TCGroup& group,
+                     iomanager::SenderConcept<dfmessages::TriggerDecision>& td_sender,
+                     bool released = false);
+
+  // How long to hold a TC for others with overlapping readout windows to be merged into it
+  std::chrono::microseconds m_tc_merging_window{ 0 };
+
+  // Per-type prescales and rate limits, applied to TCs as they arrive
+  TCTypeLimiter m_tc_type_limiter;
 
   void dfo_busy_callback(dfmessages::TriggerInhibit& inhibit);
+  void candidate_callback(triggeralgs::TriggerCandidate& tc);
+
+  // Everything that the send_trigger_decisions thread waits for wakes it
+  // through m_tc_events: TCs arriving, which are passed to it there, and
+  // changes to the DFO's busy state, the tokens, pausing and running
+  static constexpr size_t s_tc_queue_capacity = 1000;
+  TCEventQueue m_tc_events{ s_tc_queue_capacity };
+
+  // Time from a TC arriving to its decision being ready to send, in microseconds
+  LogHistogram m_tc_td_latency;
+
+  // Credit-based flow control. Only used if m_initial_tokens is non-zero
+  std::unique_ptr<TokenManager> m_token_manager;
+  std::string m_token_connection;
+  int m_initial_tokens{ 0 };
+
+  // Decisions waiting to be sent, in order, including those that have failed to send and will be retried.
+  // Only used by the send_trigger_decisions thread
+  SendRetryQueue<dfmessages::TriggerDecision> m_td_send_queue;
+  std::chrono::milliseconds m_td_send_timeout{ 1 };
+
+  // Send as many decisions from m_td_send_queue as possible, and deal with those that have been given up on
+  void flush_decisions(iomanager::SenderConcept<dfmessages::TriggerDecision>& td_sender);
+
+  // Decisions held while the DFO is busy. Only used by the send_trigger_decisions thread
+  HeldDecisionQueue m_held_decisions;
+
+  // Hold the decision for group if it is important enough, as the DFO is busy. Returns whether it was held
+  bool hold_decision(const TCGroup& group);
+  // Send held decisions while the DFO is free, and drop those that are too old
+  void release_held_decisions(iomanager::SenderConcept<dfmessages::TriggerDecision>& td_sender);
+
+  // Wait until a token is available, or triggers are paused, inhibited or stopping. Returns whether there is a token
+  bool wait_for_token();
 
   // Queue sources and sinks
   std::shared_ptr<iomanager::ReceiverConcept<triggeralgs::TriggerCandidate>> m_candidate_source;
   std::shared_ptr<iomanager::ReceiverConcept<dfmessages::TriggerInhibit>> m_inhibit_receiver;
 
   std::vector<dfmessages::GeoID> m_links;
+  // Which of m_links each decision reads out, and when
+  ReadoutMap m_readout_map;
 
   int m_repeat_trigger_count{ 1 };
 
@@ -104,6 +163,8 @@ private:
 
   // LivetimeCounter
   std::shared_ptr<LivetimeCounter> m_livetime_counter;
+  // Sets m_livetime_counter's state from the pause, DFO busy and token states together
+  std::unique_ptr<LivetimeStateTracker> m_livetime_state;
   LivetimeCounter::state_time_t m_lc_kLive_count;
   LivetimeCounter::state_time_t m_lc_kPaused_count;
   LivetimeCounter::state_time_t m_lc_kDead_count;
@@ -117,6 +178,17 @@ private:
   std::atomic<metric_counter_type> m_td_paused_count{ 0 };
   std::atomic<metric_counter_type> m_td_total_count{ 0 };
   std::atomic<metric_counter_type> m_td_queue_timeout_expired_err_count{ 0 };
+  std::atomic<metric_counter_type> m_tc_merged_count{ 0 };
+  std::atomic<metric_counter_type> m_td_merged_count{ 0 };
+  std::atomic<metric_counter_type> m_tc_prescaled_count{ 0 };
+  std::atomic<metric_counter_type> m_tc_rate_limited_count{ 0 };
+  std::atomic<metric_counter_type> m_td_held_count{ 0 };
+  std::atomic<metric_counter_type> m_td_send_failure_count{ 0 };
+  std::atomic<metric_counter_type> m_td_hold_released_count{ 0 };
+  std::atomic<metric_counter_type> m_td_hold_dropped_count{ 0 };
+  std::atomic<metric_counter_type> m_td_token_wait_count{ 0 };
+  std::atomic<metric_counter_type> m_token_wait_time_us{ 0 };
+  std::atomic<metric_counter_type> m_td_no_token_count{ 0 };
   std::atomic<metric_counter_type> m_lc_kLive{ 0 };
   std::atomic<metric_counter_type> m_lc_kPaused{ 0 };
   std::atomic<metric_counter_type> m_lc_kDead{ 0 };
@@ -0,0 +1,272 @@
+/**
+ * @file SyntheticTPGenerator.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "SyntheticTPGenerator.hpp"
+
+#include "trigger/Issues.hpp" // For TLVL_*
+#include "trigger/SetBufferPool.hpp"
+#include "trigger/TPSetWireFormat.hpp"
+
+#include "appfwk/DAQModuleHelper.hpp"
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp"
+#include "rcif/cmd/Nljs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace dunedaq::trigger {
+
+SyntheticTPGenerator::SyntheticTPGenerator(const std::string& name)
+  : dunedaq::appfwk::DAQModule(name)
+  , m_queue_timeout(100)
+{
+  // clang-format off
+  register_command("conf",  &SyntheticTPGenerator::do_configure);
+  register_command("start", &SyntheticTPGenerator::do_start);
+  register_command("stop",  &SyntheticTPGenerator::do_stop);
+  register_command("scrap", &SyntheticTPGenerator::do_scrap);
+  // clang-format on
+}
+
+void
+SyntheticTPGenerator::init(const nlohmann::json& obj)
+{
+  m_tpset_sink = get_iom_sender<TPSet>(appfwk::connection_inst(obj, "tpset_sink"));
+}
+
+void
+SyntheticTPGenerator::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  auto now = std::chrono::steady_clock::now();
+
+  synthetictpgeneratorinfo::Info i;
+  i.tpsets_sent = m_tpsets_sent.load();
+  i.tps_sent = m_tps_sent.load();
+  i.heartbeats_sent = m_heartbeats_sent.load();
+  i.failed_to_send = m_failed_to_send.load();
+  auto data_time = m_data_time.load();
+
+  double seconds = std::chrono::duration<double>(now - m_last_info_time).count();
+  if (seconds > 0) {
+    i.tp_rate_hz = (i.tps_sent - m_last_tps_sent) / seconds;
+    if (m_last_data_time != 0 && data_time >= m_last_data_time) {
+      i.data_speed = (data_time - m_last_data_time) / (m_conf.clock_frequency_hz * seconds);
+    }
+  }
+  m_last_tps_sent = i.tps_sent;
+  m_last_data_time = data_time;
+  m_last_info_time = now;
+
+  ci.add(i);
+}
+
+void
+SyntheticTPGenerator::do_configure(const nlohmann::json& obj)
+{
+  m_conf = obj.get<synthetictpgenerator::ConfParams>();
+
+  // The pacing divides by it
+  if (m_conf.rate_multiplier <= 0) {
+    TLOG() << get_name() << ": rate_multiplier must be positive, not " << m_conf.rate_multiplier;
+    throw InvalidConfiguration(ERS_HERE);
+  }
+  // The TPSet start times are rounded down to a multiple of it
+  if (m_conf.tpset_time_width == 0) {
+    TLOG() << get_name() << ": tpset_time_width must not be zero";
+    throw InvalidConfiguration(ERS_HERE);
+  }
+  // The TPSet sizes, the pacing and the data speed all divide by it
+  if (m_conf.clock_frequency_hz == 0) {
+    TLOG() << get_name() << ": clock_frequency_hz must not be zero";
+    throw InvalidConfiguration(ERS_HERE);
+  }
+}
+
+void
+SyntheticTPGenerator::do_start(const nlohmann::json& args)
+{
+  TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_start() method";
+
+  rcif::cmd::StartParams start_params = args.get<rcif::cmd::StartParams>();
+  m_run_number = start_params.run;
+
+  m_tpsets_sent = 0;
+  m_tps_sent = 0;
+  m_heartbeats_sent = 0;
+  m_failed_to_send = 0;
+  m_data_time = 0;
+  m_last_tps_sent = 0;
+  m_last_data_time = 0;
+  m_last_info_time = std::chrono::steady_clock::now();
+
+  m_running_flag.store(true);
+  m_thread = std::thread(&SyntheticTPGenerator::do_work, this);
+  pthread_setname_np(m_thread.native_handle(), "synthetic-tps");
+
+  TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_start() method";
+}
+
+void
+SyntheticTPGenerator::do_stop(const nlohmann::json& /*args*/)
+{
+  TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_stop() method";
+  m_running_flag.store(false);
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
+}
+
+void
+SyntheticTPGenerator::do_scrap(const nlohmann::json& /*args*/)
+{}
+
+TPGeneratorParams
+SyntheticTPGenerator::make_generator_params() const
+{
+  TPGeneratorParams params;
+  params.clock_frequency_hz = m_conf.clock_frequency_hz;
+  params.first_channel = m_conf.first_channel;
+  params.n_channels = m_conf.n_channels;
+  params.noise_rate_hz = m_conf.noise_rate_hz;
+  params.noise_adc_mean = m_conf.noise_adc_mean;
+  params.ar39_rate_hz = m_conf.ar39_rate_hz;
+  params.ar39_adc_mean = m_conf.ar39_adc_mean;
+  params.track_rate_hz = m_conf.track_rate_hz;
+  params.track_min_channels = m_conf.track_min_channels;
+  params.track_max_channels = m_conf.track_max_channels;
+  params.track_adc_mean = m_conf.track_adc_mean;
+  params.track_max_slope = m_conf.track_max_slope;
+  params.burst_rate_hz = m_conf.burst_rate_hz;
+  params.burst_duration = m_conf.burst_duration;
+  params.burst_cluster_rate_hz = m_conf.burst_cluster_rate_hz;
+  params.burst_adc_mean = m_conf.burst_adc_mean;
+  return params;
+}
+
+bool
+SyntheticTPGenerator::wait_until(std::chrono::steady_clock::time_point time)
+{
+  // check m_running_flag periodically so we can stop punctually
+  auto const slice_period = std::chrono::microseconds(m_conf.maximum_wait_time_us);
+  while (std::chrono::steady_clock::now() + slice_period < time) {
+    if (!m_running_flag.load()) {
+      return false;
+    }
+    std::this_thread::sleep_for(slice_period);
+  }
+  std::this_thread::sleep_until(time);
+  return true;
+}
+
+void
+SyntheticTPGenerator::do_work()
+{
+  TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_work() method";
+  // The format is per thread, and this thread does all the sending
+  set_tpset_wire_format(to_tpset_wire_format(m_conf.tpset_wire_format));
+
+  TPGenerator generator(make_generator_params(), m_conf.seed != 0 ? m_conf.seed : m_run_number);
+  double const natural_rate = generator.get_mean_tp_rate();
+  if (m_conf.target_tp_rate_hz > 0 && natural_rate > 0) {
+    generator.scale_rates(m_conf.target_tp_rate_hz / natural_rate);
+  }
+  double const mean_tp_rate = generator.get_mean_tp_rate();
+  TLOG() << get_name() << ": generating a mean of " << mean_tp_rate << " TPs per second of data time";
+
+  auto const width = m_conf.tpset_time_width;
+  // Room for well above the mean number of TPs per TPSet, so that a new
+  // TPSet rarely has to grow
+  size_t const tpset_capacity = 2 * mean_tp_rate * width / m_conf.clock_frequency_hz + 16;
+  auto& pool = SetBufferPool<TPSet::element_t>::get();
+
+  // Start from the current time, as if the TPs came from a detector now
+  auto const now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+  triggeralgs::timestamp_t const first_start_time =
+    static_cast<triggeralgs::timestamp_t>(now_ns * (m_conf.clock_frequency_hz / 1e9)) / width * width;
+  triggeralgs::timestamp_t start_time = first_start_time;
+
+  bool const paced = m_conf.pacing == synthetictpgenerator::Pacing::kRealTime;
+  // Clock ticks of data per microsecond of wall-clock time
+  double const ticks_per_us = m_conf.clock_frequency_hz / 1e6 * m_conf.rate_multiplier;
+  auto const run_start_time = std::chrono::steady_clock::now();
+
+  uint32_t seqno = 0; // NOLINT(build/unsigned)
+  TPSet tpset;
+
+  while (m_running_flag.load()) {
+    triggeralgs::timestamp_t const end_time = start_time + width;
+
+    // A TPSet can't be sent before the end of its window has come
+    if (paced) {
+      std::chrono::duration<double, std::micro> since_start((end_time - first_start_time) / ticks_per_us);
+      if (!wait_until(run_start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(since_start))) {
+        break;
+      }
+    }
+
+    // The last TPSet's vector went with it, so start from one that a
+    // receiver in this process has finished with, if there is one
+    if (tpset.objects.capacity() == 0) {
+      tpset.objects = pool.acquire();
+      tpset.objects.reserve(tpset_capacity);
+    }
+    generator.fill(tpset, start_time, end_time);
+
+    tpset.seqno = seqno++;
+    tpset.run_number = m_run_number;
+    tpset.origin.region_id = m_conf.region_id;
+    tpset.origin.element_id = m_conf.element_id;
+    size_t const n_tps = tpset.objects.size();
+    if (n_tps > 0) {
+      tpset.type = TPSet::Type::kPayload;
+      tpset.start_time = start_time;
+      tpset.end_time = end_time;
+    } else {
+      // Nothing in this window, but the makers downstream can still move on
+      tpset.type = TPSet::Type::kHeartbeat;
+      tpset.start_time = start_time;
+      tpset.end_time = start_time;
+    }
+
+    try {
+      m_tpset_sink->send(std::move(tpset), m_queue_timeout);
+      if (n_tps > 0) {
+        ++m_tpsets_sent;
+        m_tps_sent += n_tps;
+      } else {
+        ++m_heartbeats_sent;
+      }
+    } catch (const dunedaq::iomanager::TimeoutExpired& e) {
+      ers::warning(e);
+      ++m_failed_to_send;
+    }
+    m_data_time = end_time;
+    start_time = end_time;
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start_time).count();
+  TLOG() << get_name() << ": sent " << m_tpsets_sent.load() << " TP sets (" << m_tps_sent.load() << " TPs) and "
+         << m_heartbeats_sent.load() << " heartbeats in " << static_cast<int>(seconds * 1e3) << " ms. ("
+         << m_tps_sent.load() / seconds << " TPs/s, "
+         << (start_time - first_start_time) / (m_conf.clock_frequency_hz * seconds) << " times real time). "
+         << m_failed_to_send.load() << " failed to push";
+
+  TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
+}
+
+} // namespace dunedaq::trigger
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::trigger::SyntheticTPGenerator)
@@ -0,0 +1,96 @@
+/**
+ * @file SyntheticTPGenerator.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_PLUGINS_SYNTHETICTPGENERATOR_HPP_
+#define TRIGGER_PLUGINS_SYNTHETICTPGENERATOR_HPP_
+
+#include "trigger/TPGenerator.hpp"
+#include "trigger/TPSet.hpp"
+#include "trigger/synthetictpgenerator/Nljs.hpp"
+#include "trigger/synthetictpgeneratorinfo/InfoNljs.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "iomanager/Sender.hpp"
+#include "triggeralgs/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief SyntheticTPGenerator makes up TPSets on the fly from random
+ * distributions of noise, Ar39 decays, tracks and supernova-like bursts,
+ * and sends them in real time or as fast as it can. With TPSetSink at the
+ * other end, or a trigger chain, it can test TP rates far beyond those in
+ * recorded files.
+ */
+class SyntheticTPGenerator : public dunedaq::appfwk::DAQModule
+{
+public:
+  /**
+   * @brief SyntheticTPGenerator Constructor
+   * @param name Instance name for this SyntheticTPGenerator instance
+   */
+  explicit SyntheticTPGenerator(const std::string& name);
+
+  SyntheticTPGenerator(const SyntheticTPGenerator&) = delete; ///< SyntheticTPGenerator is not copy-constructible
+  SyntheticTPGenerator& operator=(const SyntheticTPGenerator&) =
+    delete;                                              ///< SyntheticTPGenerator is not copy-assignable
+  SyntheticTPGenerator(SyntheticTPGenerator&&) = delete; ///< SyntheticTPGenerator is not move-constructible
+  SyntheticTPGenerator& operator=(SyntheticTPGenerator&&) = delete; ///< SyntheticTPGenerator is not move-assignable
+
+  void init(const nlohmann::json& obj) override;
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
+
+private:
+  // Commands
+  void do_configure(const nlohmann::json& obj);
+  void do_start(const nlohmann::json& obj);
+  void do_stop(const nlohmann::json& obj);
+  void do_scrap(const nlohmann::json& obj);
+
+  // Threading
+  void do_work();
+  std::thread m_thread;
+  std::atomic<bool> m_running_flag{ false };
+
+  // Sleep until time, checking m_running_flag every maximum_wait_time_us. Returns false if we were stopped
+  bool wait_until(std::chrono::steady_clock::time_point time);
+
+  TPGeneratorParams make_generator_params() const;
+
+  std::shared_ptr<iomanager::SenderConcept<TPSet>> m_tpset_sink;
+
+  // Configuration
+  synthetictpgenerator::ConfParams m_conf;
+  daqdataformats::run_number_t m_run_number{ daqdataformats::TypeDefaults::s_invalid_run_number };
+  std::chrono::milliseconds m_queue_timeout;
+
+  // OpMon. Written by the do_work thread and read by get_info
+  using metric_counter_type = decltype(synthetictpgeneratorinfo::Info::tpsets_sent);
+  std::atomic<metric_counter_type> m_tpsets_sent{ 0 };
+  std::atomic<metric_counter_type> m_tps_sent{ 0 };
+  std::atomic<metric_counter_type> m_heartbeats_sent{ 0 };
+  std::atomic<metric_counter_type> m_failed_to_send{ 0 };
+  // End time of the last TPSet or heartbeat sent
+  std::atomic<triggeralgs::timestamp_t> m_data_time{ 0 };
+
+  // The values at the last get_info, for calculating rates. Only used by get_info
+  metric_counter_type m_last_tps_sent = 0;
+  triggeralgs::timestamp_t m_last_data_time = 0;
+  std::chrono::steady_clock::time_point m_last_info_time;
+};
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_PLUGINS_SYNTHETICTPGENERATOR_HPP_
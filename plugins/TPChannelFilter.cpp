@@ -8,6 +8,8 @@
 
 #include "TPChannelFilter.hpp"
 
+#include "trigger/TPSetWireFormat.hpp"
+
 #include "appfwk/DAQModuleHelper.hpp"
 #include "iomanager/IOManager.hpp"
 #include "triggeralgs/TriggerPrimitive.hpp"
@@ -96,6 +98,9 @@ TPChannelFilter::channel_should_be_removed(int channel) const
 void
 TPChannelFilter::do_work(std::atomic<bool>& running_flag)
 {
+  // The format is per thread, and this thread does all the sending
+  set_tpset_wire_format(to_tpset_wire_format(m_conf.tpset_wire_format));
+
   while (true) {
     std::optional<TPSet> tpset = m_input_queue->try_receive(m_queue_timeout);;
 
@@ -0,0 +1,12 @@
+/**
+ * @file TriggerActivityMakerADCSimpleWindowBatchPlugin.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/AlgorithmPlugins.hpp"
+#include "trigger/TriggerActivityMakerADCSimpleWindowBatch.hpp"
+
+DEFINE_DUNE_TA_MAKER(dunedaq::trigger::TriggerActivityMakerADCSimpleWindowBatch)
@@ -9,6 +9,7 @@
 #include "TriggerPrimitiveMaker.hpp"
 
 #include "trigger/Issues.hpp" // For TLVL_*
+#include "trigger/TPSetWireFormat.hpp"
 
 #include "appfwk/DAQModuleHelper.hpp"
 #include "appfwk/cmd/Nljs.hpp"
@@ -18,7 +19,6 @@
 
 #include <algorithm>
 #include <chrono>
-#include <fstream>
 #include <limits>
 #include <memory>
 #include <string>
@@ -47,11 +47,79 @@ TriggerPrimitiveMaker::init(const nlohmann::json& obj)
   m_init_obj = obj;
 }
 
+void
+TriggerPrimitiveMaker::StreamCounters::reset()
+{
+  tpsets_sent = 0;
+  tps_sent = 0;
+  heartbeats_sent = 0;
+  failed_to_send = 0;
+  data_time = 0;
+  last_tpsets_sent = 0;
+  last_tps_sent = 0;
+  last_data_time = 0;
+  last_info_time = std::chrono::steady_clock::now();
+}
+
+void
+TriggerPrimitiveMaker::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+{
+  std::lock_guard<std::mutex> lk(m_tp_streams_mutex);
+  auto now = std::chrono::steady_clock::now();
+
+  triggerprimitivemakerinfo::Info total;
+  bool first_stream = true;
+  for (auto& stream : m_tp_streams) {
+    StreamCounters& counters = *stream.counters;
+    triggerprimitivemakerinfo::Info i;
+    i.tpsets_sent = counters.tpsets_sent.load();
+    i.tps_sent = counters.tps_sent.load();
+    i.heartbeats_sent = counters.heartbeats_sent.load();
+    i.failed_to_send = counters.failed_to_send.load();
+    auto data_time = counters.data_time.load();
+
+    double seconds = std::chrono::duration<double>(now - counters.last_info_time).count();
+    if (seconds > 0) {
+      i.tpset_rate_hz = (i.tpsets_sent - counters.last_tpsets_sent) / seconds;
+      i.tp_rate_hz = (i.tps_sent - counters.last_tps_sent) / seconds;
+      if (counters.last_data_time != 0 && data_time >= counters.last_data_time) {
+        i.replay_speed = (data_time - counters.last_data_time) / (m_conf.clock_frequency_hz * seconds);
+      }
+    }
+    counters.last_tpsets_sent = i.tpsets_sent;
+    counters.last_tps_sent = i.tps_sent;
+    counters.last_data_time = data_time;
+    counters.last_info_time = now;
+
+    total.tpsets_sent += i.tpsets_sent;
+    total.tps_sent += i.tps_sent;
+    total.heartbeats_sent += i.heartbeats_sent;
+    total.failed_to_send += i.failed_to_send;
+    total.tpset_rate_hz += i.tpset_rate_hz;
+    total.tp_rate_hz += i.tp_rate_hz;
+    total.replay_speed = first_stream ? i.replay_speed : std::min(total.replay_speed, i.replay_speed);
+    first_stream = false;
+
+    opmonlib::InfoCollector stream_ci;
+    stream_ci.add(i);
+    ci.add(stream.name, stream_ci);
+  }
+  ci.add(total);
+}
+
 void
 TriggerPrimitiveMaker::do_configure(const nlohmann::json& obj)
 {
   m_conf = obj.get<triggerprimitivemaker::ConfParams>();
 
+  // The pacing divides by it
+  if (m_conf.rate_multiplier <= 0) {
+    TLOG() << get_name() << ": rate_multiplier must be positive, not " << m_conf.rate_multiplier;
+    throw InvalidConfiguration(ERS_HERE);
+  }
+
+  m_tpset_wire_format = to_tpset_wire_format(m_conf.tpset_wire_format);
+
   // For each of the streams that are specified in the config, we read
   // the input file, and create an outgoing sink. We also keep track
   // of the total timestamp range of all the streams, so we can keep
@@ -61,16 +129,24 @@ TriggerPrimitiveMaker::do_configure(const nlohmann::json& obj)
   m_earliest_first_tpset_timestamp = std::numeric_limits<triggeralgs::timestamp_t>::max();
   m_latest_last_tpset_timestamp = 0;
 
+  std::lock_guard<std::mutex> lk(m_tp_streams_mutex);
   for (auto& stream : m_conf.tp_streams) {
     TPStream this_stream;
+    this_stream.name = stream.output_sink_name;
+    this_stream.region_id = stream.region_id;
+    this_stream.element_id = stream.element_id;
+    this_stream.counters = std::make_unique<StreamCounters>();
     this_stream.tpset_sink = get_iom_sender<TPSet>(appfwk::connection_inst(m_init_obj, stream.output_sink_name));
 
-    this_stream.tpsets = read_tpsets(stream.filename, stream.region_id, stream.element_id);
+    this_stream.source = make_source(stream);
 
-    m_earliest_first_tpset_timestamp =
-      std::min(m_earliest_first_tpset_timestamp, this_stream.tpsets.front().start_time);
+    if (!this_stream.source->empty()) {
+      m_earliest_first_tpset_timestamp =
+        std::min(m_earliest_first_tpset_timestamp, this_stream.source->get_first_start_time());
 
-    m_latest_last_tpset_timestamp = std::max(m_latest_last_tpset_timestamp, this_stream.tpsets.back().start_time);
+      m_latest_last_tpset_timestamp =
+        std::max(m_latest_last_tpset_timestamp, this_stream.source->get_last_start_time());
+    }
 
     m_tp_streams.push_back(std::move(this_stream));
   }
@@ -93,12 +169,9 @@ TriggerPrimitiveMaker::do_start(const nlohmann::json& args)
   auto earliest_timestamp_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
 
   for (auto& stream : m_tp_streams) {
-    m_threads.push_back(std::make_unique<std::thread>(&TriggerPrimitiveMaker::do_work,
-                                                      this,
-                                                      std::ref(m_running_flag),
-                                                      std::ref(stream.tpsets),
-                                                      std::ref(stream.tpset_sink),
-                                                      earliest_timestamp_time));
+    stream.counters->reset();
+    m_threads.push_back(std::make_unique<std::thread>(
+      &TriggerPrimitiveMaker::do_work, this, std::ref(m_running_flag), std::ref(stream), earliest_timestamp_time));
   }
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_start() method";
 }
@@ -121,172 +194,185 @@ void
 TriggerPrimitiveMaker::do_scrap(const nlohmann::json& /*args*/)
 {
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
+  std::lock_guard<std::mutex> lk(m_tp_streams_mutex);
   m_tp_streams.clear();
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
 }
 
-std::vector<TPSet>
-TriggerPrimitiveMaker::read_tpsets(std::string filename, int region, int element)
+std::unique_ptr<TPSetSource>
+TriggerPrimitiveMaker::make_source(const triggerprimitivemaker::TPStream& stream)
 {
-  std::ifstream file(filename);
-  if (!file || file.bad()) {
-    throw BadTPInputFile(ERS_HERE, get_name(), filename);
-  }
-
-  TriggerPrimitive tp;
-  TPSet tpset;
-  std::vector<TPSet> tpsets;
-
-  uint64_t prev_tpset_number = 0; // NOLINT(build/unsigned)
-  uint32_t seqno = 0;             // NOLINT(build/unsigned)
-  uint64_t old_time_start = 0;    // NOLINT(build/unsigned)
-
   // Read in the file and place the TPs in TPSets. TPSets have time
   // boundaries ( n*tpset_time_width + tpset_time_offset ), and TPs are placed
   // in TPSets based on the TP start time
-  //
-  // This loop assumes the input file is sorted by TP start time
-  while (file >> tp.time_start >> tp.time_over_threshold >> tp.time_peak >> tp.channel >> tp.adc_integral >>
-         tp.adc_peak >> tp.detid >> tp.type) {
-    if (tp.time_start >= old_time_start) {
-      // NOLINTNEXTLINE(build/unsigned)
-      uint64_t current_tpset_number = (tp.time_start + m_conf.tpset_time_offset) / m_conf.tpset_time_width;
-      old_time_start = tp.time_start;
-
-      // If we crossed a time boundary, push the current TPSet and reset it
-      if (current_tpset_number > prev_tpset_number) {
-        tpset.start_time = prev_tpset_number * m_conf.tpset_time_width + m_conf.tpset_time_offset;
-        tpset.end_time = tpset.start_time + m_conf.tpset_time_width;
-        tpset.seqno = seqno;
-        ++seqno;
-
-        // 12-Jul-2021, KAB: setting origin fields from configuration
-        tpset.origin.region_id = region;
-        tpset.origin.element_id = element;
-
-        tpset.type = TPSet::Type::kPayload;
-
-        if (!tpset.objects.empty()) {
-          // We don't send empty TPSets, so there's no point creating them
-          tpsets.push_back(tpset);
-        }
-        prev_tpset_number = current_tpset_number;
+  TPSetSlicer slicer(
+    get_name(), m_conf.tpset_time_width, m_conf.tpset_time_offset, stream.region_id, stream.element_id);
 
-        tpset.objects.clear();
+  std::unique_ptr<TPSetSource> source;
+  switch (stream.input_format) {
+    case triggerprimitivemaker::InputFormat::kBinary:
+      try {
+        source = std::make_unique<BinaryFileTPSetSource>(stream.filename, std::move(slicer));
+      } catch (const BadTPBinaryFile& e) {
+        throw BadTPInputFile(ERS_HERE, get_name(), stream.filename, e);
       }
-      tpset.objects.push_back(tp);
-    } else {
-      ers::warning(UnsortedTP(ERS_HERE, get_name(), tp.time_start));
-    }
+      break;
+    case triggerprimitivemaker::InputFormat::kHDF5:
+      source = std::make_unique<HDF5FileTPSetSource>(stream.filename, std::move(slicer));
+      break;
+    default:
+      if (m_conf.streaming) {
+        source = std::make_unique<StreamingTextFileTPSetSource>(stream.filename, std::move(slicer));
+      } else {
+        source = std::make_unique<TextFileTPSetSource>(stream.filename, std::move(slicer));
+      }
+      break;
+  }
+
+  // In streaming mode, reading the file happens in a thread of its own, a
+  // bounded number of TPSets ahead of the sending thread
+  if (m_conf.streaming) {
+    source = std::make_unique<PrefetchingTPSetSource>(std::move(source), m_conf.prefetch_depth);
   }
-  if (!tpset.objects.empty()) {
-    // We don't send empty TPSets, so there's no point creating them
-    tpsets.push_back(tpset);
+  return source;
+}
+
+bool
+TriggerPrimitiveMaker::wait_until(std::chrono::steady_clock::time_point time, std::atomic<bool>& running_flag)
+{
+  // check running_flag periodically so we can stop punctually
+  auto const slice_period = std::chrono::microseconds(m_conf.maximum_wait_time_us);
+  while (std::chrono::steady_clock::now() + slice_period < time) {
+    if (!running_flag.load()) {
+      TLOG() << "while waiting to send next TP, negative running flag detected.";
+      return false;
+    }
+    std::this_thread::sleep_for(slice_period);
   }
-  TLOG_DEBUG(0) << "Read " << seqno << " TPs into " << tpsets.size() << " TPSets, from file " << filename;
-  return tpsets;
+  std::this_thread::sleep_until(time);
+  return true;
 }
 
 void
 TriggerPrimitiveMaker::do_work(std::atomic<bool>& running_flag,
-                               std::vector<TPSet>& tpsets,
-                               std::shared_ptr<iomanager::SenderConcept<TPSet>>& tpset_sink,
+                               TPStream& stream,
                                std::chrono::steady_clock::time_point earliest_timestamp_time)
 {
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_work() method";
+  // The format is per thread, and this thread does all of this stream's sending
+  set_tpset_wire_format(m_tpset_wire_format);
+  TPSetSource& source = *stream.source;
+  StreamCounters& counters = *stream.counters;
+  if (source.empty()) {
+    TLOG() << get_name() << ": No TPs to send from stream " << stream.name;
+    return;
+  }
   uint64_t current_iteration = 0; // NOLINT(build/unsigned)
-  size_t generated_count = 0;
-  size_t push_failed_count = 0;
-  size_t generated_tp_count = 0;
 
-  uint64_t prev_tpset_start_time = 0; // NOLINT(build/unsigned)
-  auto prev_tpset_send_time = std::chrono::steady_clock::now();
-
-  auto const total_stream_duration = m_latest_last_tpset_timestamp - m_earliest_first_tpset_timestamp;
+  // The last TPSet of one loop and the first of the next are a TPSet width apart
+  auto const total_stream_duration =
+    m_latest_last_tpset_timestamp - m_earliest_first_tpset_timestamp + m_conf.tpset_time_width;
 
   auto run_start_time = std::chrono::steady_clock::now();
 
   uint32_t seqno = 0; // NOLINT(build/unsigned)
+  TPSet tpset;
 
-  auto const clocks_per_us = m_conf.clock_frequency_hz / 1'000'000;
+  // Start times of the first and latest TPSet or heartbeat sent
+  triggeralgs::timestamp_t first_start_time = 0;
+  triggeralgs::timestamp_t prev_start_time = 0;
+
+  bool const paced = m_conf.replay_mode == triggerprimitivemaker::ReplayMode::kRealTime;
+  // Clock ticks of data per microsecond of wall-clock time
+  double const ticks_per_us = m_conf.clock_frequency_hz / 1e6 * m_conf.rate_multiplier;
+
+  // The argument `earliest_timestamp_time` is the wall-clock time
+  // of the earliest first tpset timestamp in _any_ of the input
+  // streams, so every stream sends each TPSet at that time plus the
+  // TPSet's (scaled) time since that earliest timestamp
+  auto send_time = [&](triggeralgs::timestamp_t start_time) {
+    std::chrono::duration<double, std::micro> since_earliest((start_time - m_earliest_first_tpset_timestamp) /
+                                                              ticks_per_us);
+    return earliest_timestamp_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(since_earliest);
+  };
+
+  auto send = [&](TPSet&& set) {
+    try {
+      stream.tpset_sink->send(std::move(set), m_queue_timeout);
+      return true;
+    } catch (const dunedaq::iomanager::TimeoutExpired& e) {
+      ers::warning(e);
+      ++counters.failed_to_send;
+      return false;
+    }
+  };
 
   while (running_flag.load()) {
     if (m_conf.number_of_loops > 0 && current_iteration >= m_conf.number_of_loops) {
       break;
     }
 
-    for (auto& tpset : tpsets) {
-
-      if (!running_flag.load()) {
-        break;
-      }
-
-      // The argument `earliest_timestamp_time` is the wall-clock time
-      // of the earliest first tpset timestamp in _any_ of the input
-      // streams. So for the first TPSet we send out, we wait until
-      // _this_ stream's first timestamp comes up
-      auto wait_time_us = 0;
-      std::chrono::steady_clock::time_point next_tpset_send_time;
-      if (prev_tpset_start_time == 0) {
-        wait_time_us = (tpset.start_time - m_earliest_first_tpset_timestamp) / clocks_per_us;
-        next_tpset_send_time = earliest_timestamp_time + std::chrono::microseconds(wait_time_us);
-      } else {
-        wait_time_us = (tpset.start_time - prev_tpset_start_time) / clocks_per_us;
-        next_tpset_send_time = prev_tpset_send_time + std::chrono::microseconds(wait_time_us);
-      }
+    // Shift the timestamps in each loop over the file, so they don't repeat.
+    // The source applies the shift as it builds each TPSet, so the TPs are
+    // only gone over once, and what it reads from is left as it was
+    source.rewind(current_iteration * total_stream_duration);
+    while (running_flag.load() && source.next(tpset)) {
+      tpset.run_number = m_run_number;
 
-      // check running_flag periodically so we can stop punctually
-      auto slice_period = std::chrono::microseconds(m_conf.maximum_wait_time_us);
-      auto next_slice_send_time = prev_tpset_send_time + slice_period;
-      bool break_flag = false;
-      while (next_tpset_send_time > next_slice_send_time + slice_period) {
-        if (!running_flag.load()) {
-          TLOG() << "while waiting to send next TP, negative running flag detected.";
-          break_flag = true;
-          break;
+      // Fill a long gap since the previous TPSet with heartbeats, so that
+      // the makers downstream can move on without waiting for data
+      if (m_conf.heartbeat_interval > 0 && prev_start_time != 0) {
+        while (tpset.start_time - prev_start_time > m_conf.heartbeat_interval) {
+          prev_start_time += m_conf.heartbeat_interval;
+          if (paced && !wait_until(send_time(prev_start_time), running_flag)) {
+            break;
+          }
+          TPSet heartbeat;
+          heartbeat.type = TPSet::Type::kHeartbeat;
+          heartbeat.start_time = prev_start_time;
+          heartbeat.end_time = prev_start_time;
+          heartbeat.run_number = m_run_number;
+          heartbeat.origin.region_id = stream.region_id;
+          heartbeat.origin.element_id = stream.element_id;
+          heartbeat.seqno = seqno;
+          ++seqno;
+          if (send(std::move(heartbeat))) {
+            ++counters.heartbeats_sent;
+          }
+          counters.data_time = prev_start_time;
         }
-        std::this_thread::sleep_until(next_slice_send_time);
-        next_slice_send_time = next_slice_send_time + slice_period;
-      }
-      if (!break_flag) {
-        std::this_thread::sleep_until(next_tpset_send_time);
       }
-      prev_tpset_send_time = next_tpset_send_time;
-      prev_tpset_start_time = tpset.start_time;
 
-      ++generated_count;
-      generated_tp_count += tpset.objects.size();
-      try {
-          TPSet tpset_copy(tpset);
-        tpset_sink->send(std::move(tpset_copy), m_queue_timeout);
-      } catch (const dunedaq::iomanager::TimeoutExpired& e) {
-        ers::warning(e);
-        ++push_failed_count;
+      if (paced && !wait_until(send_time(tpset.start_time), running_flag)) {
+        break;
       }
-
-      tpset.run_number = m_run_number;
-      // Increase seqno and the timestamps in the TPSet and TPs so they don't
-      // repeat when we do multiple loops over the file
-      tpset.start_time += total_stream_duration;
-      tpset.end_time += total_stream_duration;
-      for (auto& tp : tpset.objects) {
-        tp.time_start += total_stream_duration;
-        tp.time_peak += total_stream_duration;
+      if (first_start_time == 0) {
+        first_start_time = tpset.start_time;
       }
+      prev_start_time = tpset.start_time;
+
       tpset.seqno = seqno;
       ++seqno;
-
-    } // end loop over tpsets
+      size_t n_tps = tpset.objects.size();
+      if (send(std::move(tpset))) {
+        ++counters.tpsets_sent;
+        counters.tps_sent += n_tps;
+      }
+      counters.data_time = prev_start_time;
+    } // end loop over source
     ++current_iteration;
 
   } // end while(running_flag.load())
 
   auto run_end_time = std::chrono::steady_clock::now();
-  auto time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(run_end_time - run_start_time).count();
-  float rate_hz = 1e3 * static_cast<float>(generated_count) / time_ms;
-
-  TLOG() << "Generated " << generated_count << " TP sets (" << generated_tp_count << " TPs) in " << time_ms << " ms. ("
-         << rate_hz << " TPSets/s). " << push_failed_count << " failed to push";
+  double seconds = std::chrono::duration<double>(run_end_time - run_start_time).count();
+  double replay_speed = (prev_start_time - first_start_time) / (m_conf.clock_frequency_hz * seconds);
+
+  TLOG() << get_name() << ": stream " << stream.name << " sent " << counters.tpsets_sent.load() << " TP sets ("
+         << counters.tps_sent.load() << " TPs) and " << counters.heartbeats_sent.load() << " heartbeats in "
+         << static_cast<int>(seconds * 1e3) << " ms. (" << counters.tpsets_sent.load() / seconds << " TPSets/s, "
+         << counters.tps_sent.load() / seconds << " TPs/s, " << replay_speed << " times real time). "
+         << counters.failed_to_send.load() << " failed to push";
 
   TLOG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
 }
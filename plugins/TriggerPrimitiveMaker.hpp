@@ -10,7 +10,10 @@
 #define TRIGGER_PLUGINS_TRIGGERPRIMITIVEMAKER_HPP_
 
 #include "trigger/TPSet.hpp"
+#include "trigger/TPSetSource.hpp"
+#include "trigger/TPSetWireFormat.hpp"
 #include "trigger/triggerprimitivemaker/Nljs.hpp"
+#include "trigger/triggerprimitivemakerinfo/InfoNljs.hpp"
 
 #include "appfwk/DAQModule.hpp"
 #include "iomanager/Sender.hpp"
@@ -18,7 +21,10 @@
 #include "triggeralgs/Types.hpp"
 #include "utilities/WorkerThread.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -40,6 +46,7 @@ public:
   TriggerPrimitiveMaker& operator=(TriggerPrimitiveMaker&&) = delete; ///< TriggerPrimitiveMaker is not move-assignable
 
   void init(const nlohmann::json& obj) override;
+  void get_info(opmonlib::InfoCollector& ci, int level) override;
 
 private:
   // Commands
@@ -48,30 +55,59 @@ private:
   void do_stop(const nlohmann::json& obj);
   void do_scrap(const nlohmann::json& obj);
 
+  struct TPStream;
+
   // Threading
-  void do_work(std::atomic<bool>&,
-               std::vector<TPSet>& tpsets,
-               std::shared_ptr<iomanager::SenderConcept<TPSet>>& tpset_sink,
-               std::chrono::steady_clock::time_point earliest_timestamp_time);
+  void do_work(std::atomic<bool>&, TPStream& stream, std::chrono::steady_clock::time_point earliest_timestamp_time);
   std::vector<std::unique_ptr<std::thread>> m_threads;
   std::atomic<bool> m_running_flag;
 
-  std::vector<TPSet> read_tpsets(std::string filename, int region, int element);
+  // Sleep until time, checking running_flag every maximum_wait_time_us. Returns false if we were stopped
+  bool wait_until(std::chrono::steady_clock::time_point time, std::atomic<bool>& running_flag);
+
+  std::unique_ptr<TPSetSource> make_source(const triggerprimitivemaker::TPStream& stream);
 
   // Configuration
   triggerprimitivemaker::ConfParams m_conf;
+  TPSetWireFormat m_tpset_wire_format{ TPSetWireFormat::kMsgPack };
 
   daqdataformats::run_number_t m_run_number{ daqdataformats::TypeDefaults::s_invalid_run_number };
 
   nlohmann::json m_init_obj; // Stash this so we know name -> instance mappings
 
+  using metric_counter_type = decltype(triggerprimitivemakerinfo::Info::tpsets_sent);
+
+  // Written by a stream's do_work thread and read by get_info
+  struct StreamCounters
+  {
+    std::atomic<metric_counter_type> tpsets_sent{ 0 };
+    std::atomic<metric_counter_type> tps_sent{ 0 };
+    std::atomic<metric_counter_type> heartbeats_sent{ 0 };
+    std::atomic<metric_counter_type> failed_to_send{ 0 };
+    // Start time of the last TPSet or heartbeat sent
+    std::atomic<triggeralgs::timestamp_t> data_time{ 0 };
+
+    // The values at the last get_info, for calculating rates. Only used by get_info
+    metric_counter_type last_tpsets_sent = 0;
+    metric_counter_type last_tps_sent = 0;
+    triggeralgs::timestamp_t last_data_time = 0;
+    std::chrono::steady_clock::time_point last_info_time;
+
+    void reset();
+  };
+
   struct TPStream
   {
+    std::string name;
+    uint16_t region_id;  // NOLINT(build/unsigned)
+    uint32_t element_id; // NOLINT(build/unsigned)
     std::shared_ptr<iomanager::SenderConcept<TPSet>> tpset_sink;
-    std::vector<TPSet> tpsets;
+    std::unique_ptr<TPSetSource> source;
+    std::unique_ptr<StreamCounters> counters;
   };
 
   std::vector<TPStream> m_tp_streams;
+  std::mutex m_tp_streams_mutex; // between get_info and configure/scrap
 
   std::chrono::milliseconds m_queue_timeout;
 
@@ -12,6 +12,8 @@
 #include "zipper.hpp"
 
 #include "trigger/Issues.hpp"
+#include "trigger/LocalConnection.hpp"
+#include "trigger/TPSetWireFormat.hpp"
 #include "trigger/triggerzipper/Nljs.hpp"
 
 #include "appfwk/DAQModule.hpp"
@@ -69,14 +71,15 @@ public:
   using zm_type = zipper::merge<node_type>;
   zm_type m_zm;
 
-  // queues
-  using source_t = iomanager::ReceiverConcept<TSET>;
-  using sink_t = iomanager::SenderConcept<TSET>;
+  // queues: iomanager connections, or local ones if the connection names say so
+  using source_t = InputConnection<TSET>;
+  using sink_t = OutputConnection<TSET>;
   std::shared_ptr<source_t> m_inq{};
   std::shared_ptr<sink_t> m_outq{};
 
   using cfg_t = triggerzipper::ConfParams;
   cfg_t m_cfg;
+  TPSetWireFormat m_tpset_wire_format{ TPSetWireFormat::kMsgPack };
 
   std::thread m_thread;
   std::atomic<bool> m_running{ false };
@@ -110,16 +113,17 @@ public:
   }
   void set_input(const std::string& name)
   {
-    m_inq = get_iom_receiver<TSET>(name);
+    m_inq = get_input_connection<TSET>(name);
   }
   void set_output(const std::string& name)
   {
-    m_outq = get_iom_sender<TSET>(name);
+    m_outq = get_output_connection<TSET>(name);
   }
 
   void do_configure(const nlohmann::json& cfgobj)
   {
     m_cfg = cfgobj.get<cfg_t>();
+    m_tpset_wire_format = to_tpset_wire_format(m_cfg.tpset_wire_format);
     m_zm.set_max_latency(std::chrono::milliseconds(m_cfg.max_latency_ms));
     m_zm.set_cardinality(m_cfg.cardinality);
   }
@@ -225,6 +229,8 @@ public:
 
   void send_out(std::vector<node_type>& got)
   {
+    // Called from do_stop() as well as the worker thread, so set the format for each call
+    TPSetWireFormatScope wire_format_scope(m_tpset_wire_format);
     for (auto& node : got) {
       payload_type lit = node.payload;
       auto& tset = *lit; // list iterator
@@ -235,13 +241,12 @@ public:
       tset.seqno = m_next_seqno;
       ++m_next_seqno;
 
-      try {
-        m_outq->send(std::move(tset), std::chrono::milliseconds(10));
+      if (m_outq->try_send(std::move(tset), std::chrono::milliseconds(10))) {
         ++m_n_sent;
-      } catch (const iomanager::TimeoutExpired& err) {
+      } else {
         // our output queue is stuffed.  should more be done
         // here than simply complain and drop?
-        ers::error(err);
+        ers::error(iomanager::TimeoutExpired(ERS_HERE, get_name(), "push to output queue", 10));
       }
       m_cache.erase(lit);
     }
@@ -20,7 +20,6 @@ from appfwk.conf_utils import Direction, Connection
 def get_replay_app(INPUT_FILES: [str],
                    SLOWDOWN_FACTOR: float):
 
-    clock_frequency_hz = 50_000_000 / SLOWDOWN_FACTOR
     modules = []
 
     n_streams = len(INPUT_FILES)
@@ -39,7 +38,8 @@ def get_replay_app(INPUT_FILES: [str],
                                                    number_of_loops=-1, # Infinite
                                                    tpset_time_offset=0,
                                                    tpset_time_width=10000,
-                                                   clock_frequency_hz=clock_frequency_hz,
+                                                   clock_frequency_hz=50_000_000,
+                                                   rate_multiplier=1/SLOWDOWN_FACTOR,
                                                    maximum_wait_time_us=1000,),
                              connections = {}))
 
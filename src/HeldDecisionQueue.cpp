@@ -0,0 +1,82 @@
+/**
+ * @file HeldDecisionQueue.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/HeldDecisionQueue.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace dunedaq {
+namespace trigger {
+
+int
+HeldDecisionQueue::get_priority(const TCGroup& group) const
+{
+  int priority = 0;
+  for (auto const& tc : group.tcs) {
+    auto it = m_priorities.find(static_cast<type_t>(tc.type));
+    if (it != m_priorities.end()) {
+      priority = std::max(priority, it->second);
+    }
+  }
+  return priority;
+}
+
+HeldDecisionQueue::Result
+HeldDecisionQueue::hold(const TCGroup& group, clock_type::time_point now)
+{
+  if (m_depth == 0) {
+    return Result::kNotHeld;
+  }
+  int const priority = get_priority(group);
+  if (priority <= 0) {
+    return Result::kNotHeld;
+  }
+
+  if (m_held.size() < m_depth) {
+    m_held.push_back({ group, priority, now });
+    return Result::kHeld;
+  }
+
+  // The newest of the lowest-priority groups
+  auto victim = std::min_element(m_held.begin(), m_held.end(), [](const Entry& a, const Entry& b) {
+    return a.priority < b.priority || (a.priority == b.priority && a.held_time > b.held_time);
+  });
+  if (victim->priority >= priority) {
+    return Result::kNotHeld;
+  }
+  *victim = { group, priority, now };
+  return Result::kHeldReplacing;
+}
+
+size_t
+HeldDecisionQueue::drop_expired(clock_type::time_point now)
+{
+  auto expired_begin = std::remove_if(
+    m_held.begin(), m_held.end(), [&](const Entry& entry) { return now - entry.held_time > m_max_age; });
+  size_t const n_expired = m_held.end() - expired_begin;
+  m_held.erase(expired_begin, m_held.end());
+  return n_expired;
+}
+
+bool
+HeldDecisionQueue::release(TCGroup& group)
+{
+  if (m_held.empty()) {
+    return false;
+  }
+  auto next = std::min_element(m_held.begin(), m_held.end(), [](const Entry& a, const Entry& b) {
+    return a.priority > b.priority || (a.priority == b.priority && a.held_time < b.held_time);
+  });
+  group = std::move(next->group);
+  m_held.erase(next);
+  return true;
+}
+
+} // namespace trigger
+} // namespace dunedaq
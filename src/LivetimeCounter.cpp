@@ -3,17 +3,18 @@
 #include "logging/Logging.hpp"
 
 #include <sstream>
+#include <thread>
 
 namespace dunedaq::trigger {
 
 LivetimeCounter::LivetimeCounter(LivetimeCounter::State state)
   : m_state(state)
-  , m_last_state_change_time(now())
+  , m_last_state_change_time_ns(now_ns())
 {
   TLOG_DEBUG(1) << "Starting LivetimeCounter in state " << get_state_name(state);
-  m_state_times[State::kLive]=0;
-  m_state_times[State::kDead]=0;
-  m_state_times[State::kPaused]=0;
+  for (auto& time : m_state_times_ns) {
+    time.store(0, std::memory_order_relaxed);
+  }
 }
 
 LivetimeCounter::~LivetimeCounter()
@@ -23,55 +24,105 @@ LivetimeCounter::~LivetimeCounter()
 }
 
 void
-LivetimeCounter::update_map()
+LivetimeCounter::set_state(LivetimeCounter::State state)
 {
-  // Caller must lock the mutex, so we don't here
-  auto current_time=now();
-  auto delta=(current_time-m_last_state_change_time);
-  m_state_times[m_state]+=delta;
-  m_last_state_change_time=current_time;
+  // Wait for any other set_state() call to finish, and make the sequence odd
+  uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+  while ((sequence & 1) != 0 ||
+         !m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+    std::this_thread::yield();
+    sequence = m_sequence.load(std::memory_order_relaxed);
+  }
+  // Readers that see any of the stores below also see the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+
+  State const old_state = m_state.load(std::memory_order_relaxed);
+  if (old_state == state) {
+    // Nothing changed, so put the sequence back as it was
+    m_sequence.store(sequence, std::memory_order_release);
+    return;
+  }
+
+  // Add the time to the old state. Only one thread gets here at a time, so plain loads and stores are enough
+  uint64_t const now = now_ns();
+  uint64_t const episode_ns = now - m_last_state_change_time_ns.load(std::memory_order_relaxed);
+  auto& old_time = m_state_times_ns[static_cast<size_t>(old_state)];
+  old_time.store(old_time.load(std::memory_order_relaxed) + episode_ns, std::memory_order_relaxed);
+  m_last_state_change_time_ns.store(now, std::memory_order_relaxed);
+  m_state.store(state, std::memory_order_relaxed);
+
+  m_sequence.store(sequence + 2, std::memory_order_release);
+
+  m_episode_histograms[static_cast<size_t>(old_state)].add(episode_ns / 1000);
+  TLOG_DEBUG(1) << "Changing state from " << get_state_name(old_state) << " to " << get_state_name(state);
 }
 
+LivetimeCounter::State
+LivetimeCounter::get_state() const
+{
+  return m_state.load(std::memory_order_relaxed);
+}
 
-void
-LivetimeCounter::set_state(LivetimeCounter::State state)
+LivetimeCounter::Snapshot
+LivetimeCounter::read() const
 {
-  std::lock_guard<std::mutex> l(m_mutex);
-  update_map(); // Add the time to the old state
-  TLOG_DEBUG(1) << "Changing state from " << get_state_name(m_state) << " to " << get_state_name(state);
-  m_state=state;
+  Snapshot snapshot;
+  uint64_t last_state_change_time_ns = 0;
+  while (true) {
+    uint64_t const sequence = m_sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) == 0) {
+      snapshot.state = m_state.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < s_n_states; ++i) {
+        snapshot.times_ns[i] = m_state_times_ns[i].load(std::memory_order_relaxed);
+      }
+      last_state_change_time_ns = m_last_state_change_time_ns.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_sequence.load(std::memory_order_relaxed) == sequence) {
+        break;
+      }
+    }
+    // A set_state() call is part way through. It won't take long, unless its thread has been descheduled
+    std::this_thread::yield();
+  }
+  snapshot.times_ns[static_cast<size_t>(snapshot.state)] += now_ns() - last_state_change_time_ns;
+  return snapshot;
 }
 
 std::map<LivetimeCounter::State, LivetimeCounter::state_time_t>
-LivetimeCounter::get_time_map()
+LivetimeCounter::get_time_map() const
 {
-  std::lock_guard<std::mutex> l(m_mutex);
-  update_map();
-  return m_state_times;
+  Snapshot const snapshot = read();
+  std::map<State, state_time_t> state_times;
+  for (State state : { State::kLive, State::kDead, State::kPaused }) {
+    state_times[state] = snapshot.times_ns[static_cast<size_t>(state)] / 1'000'000;
+  }
+  return state_times;
 }
 
 LivetimeCounter::state_time_t
-LivetimeCounter::get_time(LivetimeCounter::State state)
+LivetimeCounter::get_time(LivetimeCounter::State state) const
 {
-  std::lock_guard<std::mutex> l(m_mutex);
-  update_map();
-  return m_state_times[state];
+  return get_time_ns(state) / 1'000'000;
 }
 
-LivetimeCounter::state_time_t
-LivetimeCounter::now() const
+uint64_t
+LivetimeCounter::get_time_ns(LivetimeCounter::State state) const
+{
+  return read().times_ns[static_cast<size_t>(state)];
+}
+
+uint64_t
+LivetimeCounter::now_ns()
 {
   using namespace std::chrono;
-  return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
 std::string
-LivetimeCounter::get_report_string()
+LivetimeCounter::get_report_string() const
 {
-  std::lock_guard<std::mutex> l(m_mutex);
-  update_map();
   std::ostringstream oss;
-  for(auto const& [state, t]: m_state_times){
+  for(auto const& [state, t]: get_time_map()){
     oss << get_state_name(state) << ": " << t << "ms ";
   }
   return oss.str();
@@ -0,0 +1,149 @@
+/**
+ * @file ReadoutMap.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/ReadoutMap.hpp"
+
+#include "trigger/Issues.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace dunedaq {
+namespace trigger {
+
+namespace {
+void
+add_request(std::vector<daqdataformats::ComponentRequest>& components,
+            const daqdataformats::GeoID& link,
+            triggeralgs::timestamp_t window_begin,
+            triggeralgs::timestamp_t window_end)
+{
+  daqdataformats::ComponentRequest& request = components.emplace_back();
+  request.component = link;
+  request.window_begin = window_begin;
+  request.window_end = window_end;
+}
+} // namespace
+
+ReadoutMap::ReadoutMap(const std::vector<daqdataformats::GeoID>& links,
+                       const std::vector<Region>& regions,
+                       const std::map<type_t, TypeReadout>& type_readouts)
+  : m_links(links)
+  , m_regions(regions)
+{
+  std::sort(m_regions.begin(), m_regions.end(), [](const Region& a, const Region& b) {
+    return a.first_channel < b.first_channel;
+  });
+  for (size_t i = 0; i < m_regions.size(); ++i) {
+    if (m_regions[i].last_channel < m_regions[i].first_channel) {
+      throw BadReadoutMap(ERS_HERE, "region " + std::to_string(m_regions[i].region) + " has no channels");
+    }
+    if (i > 0 && m_regions[i].first_channel <= m_regions[i - 1].last_channel) {
+      throw BadReadoutMap(ERS_HERE,
+                          "the channels of regions " + std::to_string(m_regions[i - 1].region) + " and " +
+                            std::to_string(m_regions[i].region) + " overlap");
+    }
+    m_region_links[m_regions[i].region]; // so that a region without links reads out nothing, rather than everything
+  }
+  for (size_t i = 0; i < m_links.size(); ++i) {
+    auto it = m_region_links.find(m_links[i].region_id);
+    if (it != m_region_links.end()) {
+      it->second.push_back(i);
+    }
+  }
+
+  for (auto const& [type, readout] : type_readouts) {
+    if (type < 0) {
+      continue; // Not a real TC type, so it never comes up
+    }
+    if (static_cast<size_t>(type) >= m_type_readouts.size()) {
+      m_type_readouts.resize(type + 1);
+    }
+    m_type_readouts[type] = readout;
+  }
+
+  m_links_needed.resize(m_links.size());
+}
+
+const ReadoutMap::TypeReadout&
+ReadoutMap::get_type_readout(triggeralgs::TriggerCandidate::Type type) const
+{
+  auto index = static_cast<type_t>(type);
+  if (index < 0 || static_cast<size_t>(index) >= m_type_readouts.size()) {
+    return m_default_type_readout;
+  }
+  return m_type_readouts[index];
+}
+
+bool
+ReadoutMap::add_regions(const triggeralgs::TriggerCandidate& tc) const
+{
+  bool found = false;
+  for (auto const& ta : tc.inputs) {
+    // The first region that ends at or after the TA's first channel, and the ones after it that the TA reaches
+    auto it = std::lower_bound(
+      m_regions.begin(), m_regions.end(), ta.channel_start, [](const Region& region, channel_t channel) {
+        return region.last_channel < channel;
+      });
+    for (; it != m_regions.end() && it->first_channel <= ta.channel_end; ++it) {
+      m_regions_hit.push_back(it->region);
+      found = true;
+    }
+  }
+  return found;
+}
+
+void
+ReadoutMap::fill_components(const std::vector<triggeralgs::TriggerCandidate>& tcs,
+                            std::vector<daqdataformats::ComponentRequest>& components) const
+{
+  components.clear();
+  if (tcs.empty()) {
+    return;
+  }
+
+  triggeralgs::timestamp_t window_begin = std::numeric_limits<triggeralgs::timestamp_t>::max();
+  triggeralgs::timestamp_t window_end = 0;
+  bool all_links = false;
+  m_regions_hit.clear();
+  for (auto const& tc : tcs) {
+    const TypeReadout& readout = get_type_readout(tc.type);
+    triggeralgs::timestamp_t tc_window_begin, tc_window_end;
+    get_readout_window(tc, tc_window_begin, tc_window_end);
+    window_begin = std::min(window_begin, tc_window_begin);
+    window_end = std::max(window_end, tc_window_end);
+    if (!all_links && (!readout.localized || !add_regions(tc))) {
+      all_links = true;
+    }
+  }
+
+  if (all_links) {
+    components.reserve(m_links.size());
+    for (auto const& link : m_links) {
+      add_request(components, link, window_begin, window_end);
+    }
+    return;
+  }
+
+  // Each link once, in the order they were configured
+  std::fill(m_links_needed.begin(), m_links_needed.end(), false);
+  for (auto region : m_regions_hit) {
+    for (size_t i : m_region_links.find(region)->second) {
+      m_links_needed[i] = true;
+    }
+  }
+  for (size_t i = 0; i < m_links.size(); ++i) {
+    if (m_links_needed[i]) {
+      add_request(components, m_links[i], window_begin, window_end);
+    }
+  }
+}
+
+} // namespace trigger
+} // namespace dunedaq
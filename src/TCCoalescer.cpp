@@ -0,0 +1,78 @@
+/**
+ * @file TCCoalescer.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCCoalescer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace dunedaq {
+namespace trigger {
+
+void
+TCGroup::add(triggeralgs::TriggerCandidate&& tc, triggeralgs::timestamp_t begin, triggeralgs::timestamp_t end)
+{
+  if (empty()) {
+    window_begin = begin;
+    window_end = end;
+    time_candidate = tc.time_candidate;
+  } else {
+    window_begin = std::min(window_begin, begin);
+    window_end = std::max(window_end, end);
+    time_candidate = std::min(time_candidate, tc.time_candidate);
+  }
+  tcs.push_back(std::move(tc));
+}
+
+bool
+TCCoalescer::add(triggeralgs::TriggerCandidate&& tc, clock_type::time_point now, TCGroup& ready)
+{
+  triggeralgs::timestamp_t begin = tc.time_start;
+  triggeralgs::timestamp_t end = tc.time_end;
+  if (m_readout_map != nullptr) {
+    m_readout_map->get_readout_window(tc, begin, end);
+  }
+
+  if (m_held.empty() || m_held.overlaps(begin, end)) {
+    if (m_held.empty()) {
+      m_deadline = now + m_window;
+      m_held.arrival_time = now;
+    }
+    m_held.add(std::move(tc), begin, end);
+    return false;
+  }
+  flush(ready);
+  m_deadline = now + m_window;
+  m_held.arrival_time = now;
+  m_held.add(std::move(tc), begin, end);
+  return true;
+}
+
+bool
+TCCoalescer::flush_due(clock_type::time_point now, TCGroup& ready)
+{
+  if (m_held.empty() || now < m_deadline) {
+    return false;
+  }
+  return flush(ready);
+}
+
+bool
+TCCoalescer::flush(TCGroup& ready)
+{
+  if (m_held.empty()) {
+    return false;
+  }
+  // Swap, so that the vector that ready had is reused for the next group
+  std::swap(ready, m_held);
+  m_held.clear();
+  return true;
+}
+
+} // namespace trigger
+} // namespace dunedaq
@@ -0,0 +1,83 @@
+/**
+ * @file TCTypeLimiter.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCTypeLimiter.hpp"
+
+#include <algorithm>
+
+namespace dunedaq {
+namespace trigger {
+
+void
+TCTypeLimiter::set_limits(const std::map<type_t, Limits>& limits, clock_type::time_point now)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  for (auto& [type, state] : m_states) {
+    state.limits = Limits();
+  }
+  for (auto const& [type, type_limits] : limits) {
+    TypeState& state = m_states[type];
+    state.limits = type_limits;
+    state.limits.prescale = std::max<uint64_t>(state.limits.prescale, 1); // NOLINT(build/unsigned)
+    state.limits.rate_limit_burst = std::max(state.limits.rate_limit_burst, 1.);
+    // Start with a full bucket, and the next TC accepted
+    state.n_since_accepted = 0;
+    state.tokens = state.limits.rate_limit_burst;
+    state.last_refill = now;
+  }
+}
+
+TCTypeLimiter::Result
+TCTypeLimiter::check(triggeralgs::TriggerCandidate::Type type, clock_type::time_point now)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  TypeState& state = m_states[static_cast<type_t>(type)];
+
+  if (state.n_since_accepted++ % state.limits.prescale != 0) {
+    ++state.counts.prescaled;
+    return Result::kPrescaled;
+  }
+  state.n_since_accepted = 1;
+
+  if (state.limits.rate_limit_hz > 0) {
+    double seconds = std::chrono::duration<double>(now - state.last_refill).count();
+    state.tokens = std::min(state.limits.rate_limit_burst, state.tokens + seconds * state.limits.rate_limit_hz);
+    state.last_refill = now;
+    if (state.tokens < 1.) {
+      ++state.counts.rate_limited;
+      return Result::kRateLimited;
+    }
+    state.tokens -= 1.;
+  }
+
+  ++state.counts.accepted;
+  return Result::kAccepted;
+}
+
+std::map<TCTypeLimiter::type_t, TCTypeLimiter::Counts>
+TCTypeLimiter::get_counts() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  std::map<type_t, Counts> counts;
+  for (auto const& [type, state] : m_states) {
+    counts[type] = state.counts;
+  }
+  return counts;
+}
+
+void
+TCTypeLimiter::reset_counts()
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  for (auto& [type, state] : m_states) {
+    state.counts = Counts();
+  }
+}
+
+} // namespace trigger
+} // namespace dunedaq
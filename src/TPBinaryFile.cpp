@@ -0,0 +1,124 @@
+/**
+ * @file TPBinaryFile.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPBinaryFile.hpp"
+
+#include "trigger/Issues.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using dunedaq::detdataformats::trigger::TriggerPrimitive;
+
+namespace dunedaq::trigger {
+
+TPBinaryFileWriter::TPBinaryFileWriter(const std::string& filename)
+  : m_filename(filename)
+  , m_file(filename, std::ios::binary | std::ios::trunc)
+{
+  if (!m_file) {
+    throw BadTPBinaryFile(ERS_HERE, m_filename, "can't open for writing");
+  }
+  // The header is written again with the final TP count on close()
+  m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+}
+
+TPBinaryFileWriter::~TPBinaryFileWriter()
+{
+  if (m_file.is_open()) {
+    try {
+      close();
+    } catch (const BadTPBinaryFile& e) {
+      ers::error(e);
+    }
+  }
+}
+
+void
+TPBinaryFileWriter::write(const TriggerPrimitive* tps, size_t n_tps)
+{
+  m_file.write(reinterpret_cast<const char*>(tps), n_tps * sizeof(TriggerPrimitive));
+  m_header.n_tps += n_tps;
+}
+
+void
+TPBinaryFileWriter::close()
+{
+  m_file.seekp(0);
+  m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+  m_file.close();
+  if (m_file.fail()) {
+    throw BadTPBinaryFile(ERS_HERE, m_filename, "error while writing");
+  }
+}
+
+TPBinaryFileReader::TPBinaryFileReader(const std::string& filename)
+  : m_filename(filename)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw BadTPBinaryFile(ERS_HERE, m_filename, std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw BadTPBinaryFile(ERS_HERE, m_filename, std::strerror(errno));
+  }
+  m_map_size = st.st_size;
+  if (m_map_size < sizeof(TPBinaryFileHeader)) {
+    ::close(fd);
+    throw BadTPBinaryFile(ERS_HERE, m_filename, "file is shorter than the header");
+  }
+  m_map = ::mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file descriptor is closed
+  ::close(fd);
+  if (m_map == MAP_FAILED) {
+    m_map = nullptr;
+    throw BadTPBinaryFile(ERS_HERE, m_filename, std::strerror(errno));
+  }
+  // We read the file front to back, so let the kernel read ahead generously
+  ::madvise(m_map, m_map_size, MADV_SEQUENTIAL);
+
+  TPBinaryFileHeader header;
+  std::memcpy(&header, m_map, sizeof(header));
+  std::string problem;
+  if (header.magic != TPBinaryFileHeader::s_magic) {
+    problem = "not a TP binary file";
+  } else if (header.version != TPBinaryFileHeader::s_version) {
+    problem = "unknown version " + std::to_string(header.version);
+  } else if (header.tp_size != sizeof(TriggerPrimitive)) {
+    problem = "file has TPs of size " + std::to_string(header.tp_size) + ", but TriggerPrimitive has size " +
+              std::to_string(sizeof(TriggerPrimitive));
+  } else if (header.n_tps > (m_map_size - sizeof(header)) / sizeof(TriggerPrimitive)) {
+    problem = "file is truncated";
+  }
+  if (!problem.empty()) {
+    ::munmap(m_map, m_map_size);
+    m_map = nullptr;
+    throw BadTPBinaryFile(ERS_HERE, m_filename, problem);
+  }
+
+  m_n_tps = header.n_tps;
+  // The header is 16 bytes, so the TPs are suitably aligned for TriggerPrimitive
+  m_tps = reinterpret_cast<const TriggerPrimitive*>(static_cast<const char*>(m_map) + sizeof(header));
+}
+
+TPBinaryFileReader::~TPBinaryFileReader()
+{
+  if (m_map) {
+    ::munmap(m_map, m_map_size);
+  }
+}
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,190 @@
+/**
+ * @file TPGenerator.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using dunedaq::detdataformats::trigger::TriggerPrimitive;
+
+namespace dunedaq::trigger {
+
+Xoshiro256::Xoshiro256(uint64_t seed) // NOLINT(build/unsigned)
+{
+  // Fill the state with splitmix64, as the xoshiro authors recommend, so
+  // that similar seeds give unrelated sequences and the state isn't all zero
+  for (auto& s : m_s) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15); // NOLINT(build/unsigned)
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    s = z ^ (z >> 31);
+  }
+}
+
+TPGenerator::TPGenerator(const TPGeneratorParams& params, uint64_t seed) // NOLINT(build/unsigned)
+  : m_params(params)
+  , m_rng(seed)
+{
+  m_params.n_channels = std::max<uint32_t>(m_params.n_channels, 1); // NOLINT(build/unsigned)
+  m_params.track_min_channels = std::clamp<uint32_t>(m_params.track_min_channels, 1, m_params.n_channels);
+  m_params.track_max_channels =
+    std::clamp<uint32_t>(m_params.track_max_channels, m_params.track_min_channels, m_params.n_channels);
+  m_params.max_time_over_threshold = std::max(m_params.max_time_over_threshold, m_params.min_time_over_threshold);
+}
+
+double
+TPGenerator::get_mean_tp_rate() const
+{
+  double const mean_track_channels = (m_params.track_min_channels + m_params.track_max_channels) / 2.;
+  double const burst_fraction =
+    std::min(1., m_params.burst_rate_hz * m_params.burst_duration / m_params.clock_frequency_hz);
+  // Ar39 clusters have one or two channels, burst clusters one to four
+  return m_params.n_channels * m_params.noise_rate_hz + m_params.ar39_rate_hz * 1.5 +
+         m_params.track_rate_hz * mean_track_channels + burst_fraction * m_params.burst_cluster_rate_hz * 2.5;
+}
+
+void
+TPGenerator::scale_rates(double factor)
+{
+  m_params.noise_rate_hz *= factor;
+  m_params.ar39_rate_hz *= factor;
+  m_params.track_rate_hz *= factor;
+  m_params.burst_cluster_rate_hz *= factor;
+}
+
+void
+TPGenerator::fill(TPSet& tpset, daqdataformats::timestamp_t start_time, daqdataformats::timestamp_t end_time)
+{
+  tp_vector& tps = tpset.objects;
+  tps.clear();
+  daqdataformats::timestamp_t const duration = end_time - start_time;
+
+  // Clusters from earlier windows that reach into this one
+  auto pending_end = std::partition(
+    m_pending.begin(), m_pending.end(), [end_time](const TriggerPrimitive& tp) { return tp.time_start < end_time; });
+  tps.insert(tps.end(), m_pending.begin(), pending_end);
+  m_pending.erase(m_pending.begin(), pending_end);
+
+  for (uint32_t i = n_events(m_params.noise_rate_hz * m_params.n_channels, duration); i > 0; --i) { // NOLINT
+    add_tp(tps, random_time(start_time, duration), random_channel(), m_params.noise_adc_mean);
+  }
+  for (uint32_t i = n_events(m_params.ar39_rate_hz, duration); i > 0; --i) { // NOLINT(build/unsigned)
+    add_cluster(tps, random_time(start_time, duration), 1 + (m_rng.uniform() < 0.5), m_params.ar39_adc_mean);
+  }
+  for (uint32_t i = n_events(m_params.track_rate_hz, duration); i > 0; --i) { // NOLINT(build/unsigned)
+    add_track(tps, random_time(start_time, duration));
+  }
+
+  // A new burst can only start once the last one is over
+  if (m_burst_end <= start_time && n_events(m_params.burst_rate_hz, duration) > 0) {
+    m_burst_end = random_time(start_time, duration) + m_params.burst_duration;
+  }
+  if (m_burst_end > start_time) {
+    // The burst may have started part way through this window, but assume
+    // the whole window is in it. Bursts are much longer than TPSets
+    daqdataformats::timestamp_t const burst_window = std::min(m_burst_end, end_time) - start_time;
+    for (uint32_t i = n_events(m_params.burst_cluster_rate_hz, burst_window); i > 0; --i) { // NOLINT
+      add_cluster(tps, random_time(start_time, burst_window), 1 + m_rng.below(4), m_params.burst_adc_mean);
+    }
+  }
+
+  // Keep what starts after this window for the next one
+  auto late_begin = std::partition(
+    tps.begin(), tps.end(), [end_time](const TriggerPrimitive& tp) { return tp.time_start < end_time; });
+  m_pending.insert(m_pending.end(), late_begin, tps.end());
+  tps.erase(late_begin, tps.end());
+
+  std::sort(tps.begin(), tps.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return a.time_start < b.time_start;
+  });
+}
+
+uint32_t // NOLINT(build/unsigned)
+TPGenerator::n_events(double rate_hz, daqdataformats::timestamp_t duration)
+{
+  double const mean = rate_hz * duration / m_params.clock_frequency_hz;
+  if (mean <= 0) {
+    return 0;
+  }
+  std::poisson_distribution<uint32_t> poisson(mean); // NOLINT(build/unsigned)
+  return poisson(m_rng);
+}
+
+daqdataformats::timestamp_t
+TPGenerator::random_time(daqdataformats::timestamp_t start, daqdataformats::timestamp_t duration)
+{
+  return duration == 0 ? start : start + m_rng.below(duration);
+}
+
+detdataformats::trigger::channel_t
+TPGenerator::random_channel()
+{
+  return m_params.first_channel + m_rng.below(m_params.n_channels);
+}
+
+daqdataformats::timestamp_t
+TPGenerator::random_time_over_threshold()
+{
+  return m_params.min_time_over_threshold +
+         m_rng.below(m_params.max_time_over_threshold - m_params.min_time_over_threshold + 1);
+}
+
+void
+TPGenerator::add_tp(tp_vector& tps,
+                    daqdataformats::timestamp_t time_start,
+                    detdataformats::trigger::channel_t channel,
+                    double adc_mean)
+{
+  TriggerPrimitive& tp = tps.emplace_back();
+  tp.time_start = time_start;
+  tp.time_over_threshold = random_time_over_threshold();
+  tp.time_peak = time_start + tp.time_over_threshold / 2;
+  tp.channel = channel;
+  // Exponentially distributed, and at least 1. 1 - uniform() is never 0
+  tp.adc_integral = 1 + static_cast<uint32_t>(-adc_mean * std::log(1. - m_rng.uniform())); // NOLINT
+  // A triangular pulse
+  tp.adc_peak = static_cast<uint16_t>( // NOLINT(build/unsigned)
+    std::min<uint64_t>(2 * tp.adc_integral / tp.time_over_threshold, std::numeric_limits<uint16_t>::max())); // NOLINT
+  tp.detid = m_params.detid;
+  tp.type = TriggerPrimitive::Type::kTPC;
+  tp.algorithm = TriggerPrimitive::Algorithm::kTPCDefault;
+}
+
+void
+TPGenerator::add_cluster(tp_vector& tps,
+                         daqdataformats::timestamp_t time_start,
+                         uint32_t n_channels, // NOLINT(build/unsigned)
+                         double adc_mean)
+{
+  detdataformats::trigger::channel_t const channel = random_channel();
+  detdataformats::trigger::channel_t const last_channel = m_params.first_channel + m_params.n_channels - 1;
+  for (uint32_t i = 0; i < n_channels && channel + i <= last_channel; ++i) { // NOLINT(build/unsigned)
+    // The neighbouring channels see the charge at nearly the same time
+    add_tp(tps, time_start + m_rng.below(8), channel + i, adc_mean);
+  }
+}
+
+void
+TPGenerator::add_track(tp_vector& tps, daqdataformats::timestamp_t time_start)
+{
+  uint32_t const length = m_params.track_min_channels + // NOLINT(build/unsigned)
+                          m_rng.below(m_params.track_max_channels - m_params.track_min_channels + 1);
+  detdataformats::trigger::channel_t const start_channel =
+    m_params.first_channel + m_rng.below(m_params.n_channels - length + 1);
+  daqdataformats::timestamp_t const slope = m_rng.below(m_params.track_max_slope + 1);
+  // Which end of the track is earliest, so that no TP is before time_start
+  bool const forwards = m_rng.uniform() < 0.5;
+  for (uint32_t i = 0; i < length; ++i) { // NOLINT(build/unsigned)
+    daqdataformats::timestamp_t const step = forwards ? i : length - 1 - i;
+    add_tp(tps, time_start + step * slope, start_channel + i, m_params.track_adc_mean);
+  }
+}
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,466 @@
+/**
+ * @file TPSetSource.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPSetSource.hpp"
+
+#include "trigger/Issues.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+#include "daqdataformats/FragmentHeader.hpp"
+#include "hdf5libs/HDF5RawDataFile.hpp"
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+
+using dunedaq::detdataformats::trigger::TriggerPrimitive;
+
+namespace dunedaq::trigger {
+
+bool
+read_text_tp(std::istream& in, TriggerPrimitive& tp)
+{
+  return static_cast<bool>(in >> tp.time_start >> tp.time_over_threshold >> tp.time_peak >> tp.channel >>
+                           tp.adc_integral >> tp.adc_peak >> tp.detid >> tp.type);
+}
+
+bool
+TPSetSlicer::add(const TriggerPrimitive& tp, TPSet& out)
+{
+  if (tp.time_start < m_last_time_start) {
+    ers::warning(UnsortedTP(ERS_HERE, m_name, tp.time_start));
+    return false;
+  }
+  m_last_time_start = tp.time_start;
+
+  bool complete = false;
+  // NOLINTNEXTLINE(build/unsigned)
+  uint64_t tpset_number = (tp.time_start + m_offset) / m_width;
+  // If we crossed a time boundary, the current TPSet is done. We don't
+  // send empty TPSets, so there's no point creating them
+  if (tpset_number > m_tpset_number) {
+    if (!m_objects.empty()) {
+      fill(out);
+      complete = true;
+    }
+    m_tpset_number = tpset_number;
+  }
+  // Shift the copy as it is made, rather than going over the TPSet again later
+  auto& shifted = m_objects.emplace_back(tp);
+  shifted.time_start += m_time_shift;
+  shifted.time_peak += m_time_shift;
+  return complete;
+}
+
+bool
+TPSetSlicer::finish(TPSet& out)
+{
+  if (m_objects.empty()) {
+    return false;
+  }
+  fill(out);
+  return true;
+}
+
+void
+TPSetSlicer::reset(daqdataformats::timestamp_t time_shift)
+{
+  m_time_shift = time_shift;
+  m_objects.clear();
+  m_tpset_number = 0;
+  m_last_time_start = 0;
+  m_seqno = 0;
+}
+
+void
+TPSetSlicer::fill(TPSet& out)
+{
+  out.start_time = m_tpset_number * m_width + m_offset + m_time_shift;
+  out.end_time = out.start_time + m_width;
+  out.seqno = m_seqno++;
+  out.origin.region_id = m_region_id;
+  out.origin.element_id = m_element_id;
+  out.type = TPSet::Type::kPayload;
+  // Swap rather than copy, so both vectors keep their capacity
+  out.objects.clear();
+  std::swap(out.objects, m_objects);
+}
+
+TextFileTPSetSource::TextFileTPSetSource(const std::string& filename, TPSetSlicer slicer)
+{
+  std::ifstream file(filename);
+  if (!file || file.bad()) {
+    throw BadTPInputFile(ERS_HERE, slicer.get_name(), filename);
+  }
+
+  TriggerPrimitive tp;
+  TPSet tpset;
+  size_t n_tps = 0;
+  while (read_text_tp(file, tp)) {
+    ++n_tps;
+    if (slicer.add(tp, tpset)) {
+      m_tpsets.push_back(tpset);
+    }
+  }
+  if (slicer.finish(tpset)) {
+    m_tpsets.push_back(tpset);
+  }
+  TLOG_DEBUG(0) << "Read " << n_tps << " TPs into " << m_tpsets.size() << " TPSets, from file " << filename;
+}
+
+bool
+TextFileTPSetSource::next(TPSet& tpset)
+{
+  if (m_index >= m_tpsets.size()) {
+    return false;
+  }
+  // Copy and shift in one go. m_tpsets itself is never changed
+  const TPSet& from = m_tpsets[m_index++];
+  tpset.seqno = from.seqno;
+  tpset.run_number = from.run_number;
+  tpset.origin = from.origin;
+  tpset.type = from.type;
+  tpset.start_time = from.start_time + m_time_shift;
+  tpset.end_time = from.end_time + m_time_shift;
+  tpset.objects.clear();
+  tpset.objects.reserve(from.objects.size());
+  std::transform(from.objects.begin(),
+                 from.objects.end(),
+                 std::back_inserter(tpset.objects),
+                 [shift = m_time_shift](TriggerPrimitive tp) {
+                   tp.time_start += shift;
+                   tp.time_peak += shift;
+                   return tp;
+                 });
+  return true;
+}
+
+StreamingTextFileTPSetSource::StreamingTextFileTPSetSource(const std::string& filename, TPSetSlicer slicer)
+  : m_file(filename)
+  , m_slicer(std::move(slicer))
+{
+  if (!m_file || m_file.bad()) {
+    throw BadTPInputFile(ERS_HERE, m_slicer.get_name(), filename);
+  }
+
+  TriggerPrimitive tp;
+  if (!read_text_tp(m_file, tp)) {
+    return; // m_empty stays true
+  }
+  m_empty = false;
+  m_first_start_time = m_slicer.tpset_start_time(tp.time_start);
+  m_last_start_time = m_first_start_time;
+
+  // Find the last TP from the end of the file, rather than reading all of
+  // it. The last few kB are plenty to hold the last line
+  constexpr std::streamoff tail_size = 4096;
+  m_file.seekg(0, std::ios::end);
+  std::streamoff file_size = m_file.tellg();
+  m_file.seekg(std::max<std::streamoff>(0, file_size - tail_size));
+  std::string tail(static_cast<size_t>(std::min(file_size, tail_size)), '\0');
+  m_file.read(tail.data(), tail.size());
+
+  std::istringstream lines(tail);
+  std::string line;
+  bool first_line = file_size > tail_size; // probably cut in half, so skip it
+  while (std::getline(lines, line)) {
+    std::istringstream line_stream(line);
+    if (!first_line && read_text_tp(line_stream, tp)) {
+      m_last_start_time = std::max(m_last_start_time, m_slicer.tpset_start_time(tp.time_start));
+    }
+    first_line = false;
+  }
+
+  rewind(0);
+  TLOG_DEBUG(0) << "Streaming TPs from file " << filename;
+}
+
+bool
+StreamingTextFileTPSetSource::next(TPSet& tpset)
+{
+  TriggerPrimitive tp;
+  while (read_text_tp(m_file, tp)) {
+    if (m_slicer.add(tp, tpset)) {
+      return true;
+    }
+  }
+  return m_slicer.finish(tpset);
+}
+
+void
+StreamingTextFileTPSetSource::rewind(daqdataformats::timestamp_t time_shift)
+{
+  m_file.clear();
+  m_file.seekg(0);
+  m_slicer.reset(time_shift);
+}
+
+BinaryFileTPSetSource::BinaryFileTPSetSource(const std::string& filename, TPSetSlicer slicer)
+  : m_reader(filename)
+  , m_slicer(std::move(slicer))
+{
+  TLOG_DEBUG(0) << "Mapped " << m_reader.size() << " TPs from file " << filename;
+}
+
+bool
+BinaryFileTPSetSource::next(TPSet& tpset)
+{
+  const TriggerPrimitive* tps = m_reader.data();
+  while (m_index < m_reader.size()) {
+    if (m_slicer.add(tps[m_index++], tpset)) {
+      return true;
+    }
+  }
+  return m_slicer.finish(tpset);
+}
+
+void
+BinaryFileTPSetSource::rewind(daqdataformats::timestamp_t time_shift)
+{
+  m_index = 0;
+  m_slicer.reset(time_shift);
+}
+
+daqdataformats::timestamp_t
+BinaryFileTPSetSource::get_first_start_time() const
+{
+  return m_slicer.tpset_start_time(m_reader.data()[0].time_start);
+}
+
+daqdataformats::timestamp_t
+BinaryFileTPSetSource::get_last_start_time() const
+{
+  return m_slicer.tpset_start_time(m_reader.data()[m_reader.size() - 1].time_start);
+}
+
+namespace {
+
+// libhdf5 is usually built without thread safety, and then no two threads
+// may be in it at once, even with different files. Every stream, and every
+// prefetching reader thread, has its own HDF5FileTPSetSource, so all of
+// them take this lock around their HDF5 calls
+std::mutex&
+hdf5_mutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+} // namespace
+
+HDF5FileTPSetSource::HDF5FileTPSetSource(const std::string& filename, TPSetSlicer slicer)
+  : m_filename(filename)
+  , m_slicer(std::move(slicer))
+{
+  {
+    std::lock_guard<std::mutex> lk(hdf5_mutex());
+    try {
+      m_file = std::make_unique<hdf5libs::HDF5RawDataFile>(filename);
+    } catch (const ers::Issue& e) {
+      throw BadTPInputFile(ERS_HERE, m_slicer.get_name(), filename, e);
+    }
+    auto record_ids = m_file->get_all_record_ids();
+    m_record_ids.assign(record_ids.begin(), record_ids.end());
+  }
+
+  // The first and last TPs are in the first and last records that have any
+  for (auto it = m_record_ids.begin(); it != m_record_ids.end() && m_tps.empty(); ++it) {
+    read_record(*it);
+  }
+  if (!m_tps.empty()) {
+    m_empty = false;
+    m_first_start_time = m_slicer.tpset_start_time(m_tps.front().time_start);
+  }
+  for (auto it = m_record_ids.rbegin(); it != m_record_ids.rend() && !m_empty; ++it) {
+    read_record(*it);
+    if (!m_tps.empty()) {
+      m_last_start_time = m_slicer.tpset_start_time(m_tps.back().time_start);
+      break;
+    }
+  }
+
+  rewind(0);
+  TLOG_DEBUG(0) << "Streaming TPs from " << m_record_ids.size() << " records in file " << filename;
+}
+
+// Out of line so that the header doesn't need HDF5RawDataFile to be a complete type
+HDF5FileTPSetSource::~HDF5FileTPSetSource()
+{
+  // Closing the file is an HDF5 call too
+  std::lock_guard<std::mutex> lk(hdf5_mutex());
+  m_file.reset();
+}
+
+bool
+HDF5FileTPSetSource::next(TPSet& tpset)
+{
+  while (true) {
+    while (m_next_tp < m_tps.size()) {
+      if (m_slicer.add(m_tps[m_next_tp++], tpset)) {
+        return true;
+      }
+    }
+    if (m_next_record == m_record_ids.size()) {
+      return m_slicer.finish(tpset);
+    }
+    read_record(m_record_ids[m_next_record++]);
+  }
+}
+
+void
+HDF5FileTPSetSource::rewind(daqdataformats::timestamp_t time_shift)
+{
+  m_next_record = 0;
+  m_tps.clear();
+  m_next_tp = 0;
+  m_slicer.reset(time_shift);
+}
+
+void
+HDF5FileTPSetSource::read_record(const record_id_t& record_id)
+{
+  m_tps.clear();
+  m_next_tp = 0;
+  std::unique_lock<std::mutex> lk(hdf5_mutex());
+  for (auto const& path : m_file->get_fragment_dataset_paths(record_id)) {
+    auto frag = m_file->get_frag_ptr(path);
+    size_t payload_size = frag->get_size() - sizeof(daqdataformats::FragmentHeader);
+    if (payload_size % sizeof(TriggerPrimitive) != 0) {
+      // Not a TP fragment, or a damaged one
+      TLOG_DEBUG(1) << "Skipping fragment " << path << " in " << m_filename << " with payload size " << payload_size
+                    << ", which is not a whole number of TPs";
+      continue;
+    }
+    const TriggerPrimitive* prim = static_cast<const TriggerPrimitive*>(frag->get_data());
+    m_tps.insert(m_tps.end(), prim, prim + payload_size / sizeof(TriggerPrimitive));
+  }
+  lk.unlock();
+  std::stable_sort(m_tps.begin(), m_tps.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+    return a.time_start < b.time_start;
+  });
+}
+
+PrefetchingTPSetSource::PrefetchingTPSetSource(std::unique_ptr<TPSetSource> source, size_t depth)
+  : m_source(std::move(source))
+  , m_buffer(depth)
+{
+  start_reading();
+}
+
+PrefetchingTPSetSource::~PrefetchingTPSetSource()
+{
+  stop_reading();
+}
+
+bool
+PrefetchingTPSetSource::next(TPSet& tpset)
+{
+  m_consumed = true;
+  while (true) {
+    if (std::optional<TPSet> ready = m_buffer.try_receive()) {
+      tpset = std::move(*ready);
+      notify_reader();
+      return true;
+    }
+    if (m_done.load(std::memory_order_acquire)) {
+      // The reader may have added more after we looked, and before it finished
+      if (std::optional<TPSet> ready = m_buffer.try_receive()) {
+        tpset = std::move(*ready);
+        return true;
+      }
+      return false;
+    }
+    // The reader is behind. This only happens if reading is slower than replay
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+void
+PrefetchingTPSetSource::rewind(daqdataformats::timestamp_t time_shift)
+{
+  if (!m_consumed && time_shift == m_time_shift) {
+    return; // the reader thread is already reading from the beginning
+  }
+  stop_reading();
+  while (m_buffer.try_receive()) {
+  }
+  m_time_shift = time_shift;
+  m_source->rewind(time_shift);
+  start_reading();
+}
+
+void
+PrefetchingTPSetSource::start_reading()
+{
+  m_stop = false;
+  m_done = false;
+  m_consumed = false;
+  m_thread = std::thread(&PrefetchingTPSetSource::read_ahead, this);
+}
+
+void
+PrefetchingTPSetSource::stop_reading()
+{
+  {
+    // Under the lock, so the reader can't miss the notification between checking m_stop and waiting
+    std::lock_guard<std::mutex> lk(m_reader_mutex);
+    m_stop = true;
+    m_reader_cv.notify_one();
+  }
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void
+PrefetchingTPSetSource::read_ahead()
+{
+  TPSet tpset;
+  try {
+    while (!m_stop.load() && m_source->next(tpset)) {
+      // try_send leaves tpset alone if the buffer is full
+      if (!m_buffer.try_send(std::move(tpset))) {
+        std::unique_lock<std::mutex> lk(m_reader_mutex);
+        m_reader_waiting.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in notify_reader(): either next() sees that
+        // we are waiting, or we see the room it has just made
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!m_buffer.try_send(std::move(tpset))) {
+          if (m_stop.load()) {
+            m_reader_waiting.store(false, std::memory_order_relaxed);
+            return;
+          }
+          m_reader_cv.wait(lk);
+        }
+        m_reader_waiting.store(false, std::memory_order_relaxed);
+      }
+    }
+  } catch (const ers::Issue& e) {
+    ers::error(e);
+  }
+  m_done.store(true, std::memory_order_release);
+}
+
+void
+PrefetchingTPSetSource::notify_reader()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_reader_waiting.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lk(m_reader_mutex);
+    m_reader_cv.notify_one();
+  }
+}
+
+} // namespace dunedaq::trigger
@@ -7,27 +7,41 @@
  */
 
 #include "trigger/TokenManager.hpp"
-#include "trigger/LivetimeCounter.hpp"
 
 #include "iomanager/IOManager.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 
 namespace dunedaq::trigger {
 
 TokenManager::TokenManager(const std::string& connection_name,
                            int initial_tokens,
                            daqdataformats::run_number_t run_number,
-                           std::shared_ptr<LivetimeCounter> livetime_counter)
+                           std::function<void(bool)> triggers_allowed_callback,
+                           std::function<void()> token_received_callback)
   : m_connection_name(connection_name)
   , m_n_tokens(initial_tokens)
   , m_run_number(run_number)
-  , m_livetime_counter(livetime_counter)
+  , m_triggers_allowed_callback(std::move(triggers_allowed_callback))
+  , m_token_received_callback(std::move(token_received_callback))
   , m_token_receiver(nullptr)
 {
   m_open_trigger_time = std::chrono::steady_clock::now();
 
+  // Trigger numbers go up by one per decision, so with a few times as many
+  // slots as tokens, a decision only misses out on a slot if one sent much
+  // earlier is still in flight
+  size_t n_slots = 64;
+  while (n_slots < 4 * static_cast<size_t>(std::max(initial_tokens, 0))) {
+    n_slots *= 2;
+  }
+  m_slots.reset(new Slot[n_slots]);
+  m_slot_mask = n_slots - 1;
+
   m_token_receiver = get_iom_receiver<dfmessages::TriggerDecisionToken>(m_connection_name);
   m_token_receiver->add_callback(std::bind(&TokenManager::receive_token, this, std::placeholders::_1));
 }
@@ -36,25 +50,20 @@ TokenManager::~TokenManager()
 {
   m_token_receiver->remove_callback();
 
-  if (!m_open_trigger_decisions.empty()) {
-
-    auto now = std::chrono::steady_clock::now();
-    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_open_trigger_time) >
-        std::chrono::milliseconds(3000)) {
-      std::ostringstream o;
-      o << "Open Trigger Decisions: [";
-      { // Scope for lock_guard
-        bool first = true;
-        std::lock_guard<std::mutex> lk(m_open_trigger_decisions_mutex);
-        for (auto& td : m_open_trigger_decisions) {
-          if (!first)
-            o << ", ";
-          o << td;
-          first = false;
-        }
-        o << "]";
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_open_trigger_time) >
+      std::chrono::milliseconds(3000)) {
+    std::ostringstream o;
+    bool first = true;
+    for (size_t i = 0; i <= m_slot_mask; ++i) {
+      uint64_t const trigger_number_plus_one = m_slots[i].trigger_number_plus_one.load(); // NOLINT(build/unsigned)
+      if (trigger_number_plus_one != 0) {
+        o << (first ? "" : ", ") << trigger_number_plus_one - 1;
+        first = false;
       }
-      TLOG_DEBUG(0) << o.str();
+    }
+    if (!first) {
+      TLOG_DEBUG(0) << "Open Trigger Decisions: [" << o.str() << "]";
     }
   }
 }
@@ -68,11 +77,26 @@ TokenManager::get_n_tokens() const
 void
 TokenManager::trigger_sent(dfmessages::trigger_number_t trigger_number)
 {
-  std::lock_guard<std::mutex> lk(m_open_trigger_decisions_mutex);
-  m_open_trigger_decisions.insert(trigger_number);
-  m_n_tokens--;
-  if (m_n_tokens.load() == 0) {
-    m_livetime_counter->set_state(LivetimeCounter::State::kDead);
+  Slot& slot = m_slots[trigger_number & m_slot_mask];
+  // Only this thread fills slots, so a free slot stays free until we fill it.
+  // The time is written first, so that whoever sees the trigger number sees the time too
+  if (slot.trigger_number_plus_one.load(std::memory_order_acquire) == 0) {
+    slot.sent_time_ns.store(now_ns(), std::memory_order_relaxed);
+    slot.trigger_number_plus_one.store(trigger_number + 1, std::memory_order_release);
+  }
+
+  if (m_n_tokens.fetch_sub(1) == 1) {
+    update_triggers_allowed();
+  }
+}
+
+void
+TokenManager::trigger_not_sent(dfmessages::trigger_number_t trigger_number)
+{
+  int64_t sent_time_ns = 0;
+  release_slot(trigger_number, sent_time_ns);
+  if (m_n_tokens.fetch_add(1) == 0) {
+    update_triggers_allowed();
   }
 }
 
@@ -81,24 +105,57 @@ TokenManager::receive_token(dfmessages::TriggerDecisionToken& token)
 {
   TLOG_DEBUG(1) << "Received token with run number " << token.run_number << ", current run number " << m_run_number;
   if (token.run_number == m_run_number) {
-    if (m_n_tokens.load() == 0) {
-      m_livetime_counter->set_state(LivetimeCounter::State::kLive);
+    int const n_tokens = m_n_tokens.fetch_add(1) + 1;
+    if (n_tokens == 1) {
+      update_triggers_allowed();
+    }
+    TLOG_DEBUG(1) << "There are now " << n_tokens << " tokens available";
+    if (m_token_received_callback) {
+      m_token_received_callback();
     }
-    m_n_tokens++;
-    TLOG_DEBUG(1) << "There are now " << m_n_tokens.load() << " tokens available";
 
     if (token.trigger_number != dfmessages::TypeDefaults::s_invalid_trigger_number) {
-      if (m_open_trigger_decisions.count(token.trigger_number)) {
-        std::lock_guard<std::mutex> lk(m_open_trigger_decisions_mutex);
-        m_open_trigger_decisions.erase(token.trigger_number);
-        TLOG_DEBUG(1) << "Token indicates that trigger decision " << token.trigger_number
-                      << " has been completed. There are now " << m_open_trigger_decisions.size()
-                      << " triggers in flight";
+      int64_t sent_time_ns = 0;
+      if (release_slot(token.trigger_number, sent_time_ns)) {
+        int64_t const latency_ns = now_ns() - sent_time_ns;
+        m_latency_histogram.add(latency_ns > 0 ? latency_ns / 1000 : 0);
+        TLOG_DEBUG(1) << "Token indicates that trigger decision " << token.trigger_number << " has been completed after "
+                      << latency_ns / 1000 << " us";
       } else {
-        // ERS warning: received token for trigger number I don't recognize
+        // Received token for a trigger number we aren't tracking
+        TLOG_DEBUG(1) << "Token for trigger decision " << token.trigger_number << ", which isn't known to be in flight";
       }
     }
   }
 }
 
+bool
+TokenManager::release_slot(dfmessages::trigger_number_t trigger_number, int64_t& sent_time_ns)
+{
+  Slot& slot = m_slots[trigger_number & m_slot_mask];
+  uint64_t expected = trigger_number + 1; // NOLINT(build/unsigned)
+  if (slot.trigger_number_plus_one.load(std::memory_order_acquire) != expected) {
+    return false;
+  }
+  // Read the time while we still hold the slot: once it is free, trigger_sent() may overwrite it
+  sent_time_ns = slot.sent_time_ns.load(std::memory_order_relaxed);
+  return slot.trigger_number_plus_one.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+}
+
+void
+TokenManager::update_triggers_allowed()
+{
+  if (m_triggers_allowed_callback) {
+    std::lock_guard<std::mutex> lk(m_triggers_allowed_mutex);
+    m_triggers_allowed_callback(triggers_allowed());
+  }
+}
+
+int64_t
+TokenManager::now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
 } // namespace dunedaq::trigger
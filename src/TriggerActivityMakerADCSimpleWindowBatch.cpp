@@ -0,0 +1,267 @@
+/**
+ * @file TriggerActivityMakerADCSimpleWindowBatch.cpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TriggerActivityMakerADCSimpleWindowBatch.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace dunedaq::trigger {
+
+namespace {
+
+using timestamp_t = triggeralgs::timestamp_t;
+
+// Write start + in[0] + ... + in[k] to out[k] for each k < n. Sums wrap
+// exactly as the running uint32_t sum in triggeralgs does
+void
+prefix_sum_scalar(const uint32_t* in, size_t n, uint32_t start, uint32_t* out) // NOLINT(build/unsigned)
+{
+  uint32_t sum = start; // NOLINT(build/unsigned)
+  for (size_t k = 0; k < n; ++k) {
+    sum += in[k];
+    out[k] = sum;
+  }
+}
+
+// Return the first j in [lo, hi) for which times[j] is less than
+// window_length before t_now, or hi if there is none
+size_t
+find_window_start_scalar(const timestamp_t* times, size_t lo, size_t hi, timestamp_t t_now, timestamp_t window_length)
+{
+  size_t j = lo;
+  while (j < hi && !(t_now - times[j] < window_length)) {
+    ++j;
+  }
+  return j;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) void
+prefix_sum_avx2(const uint32_t* in, size_t n, uint32_t start, uint32_t* out) // NOLINT(build/unsigned)
+{
+  const __m256i low_lane_last = _mm256_set1_epi32(3);
+  const __m256i last = _mm256_set1_epi32(7);
+  __m256i carry = _mm256_set1_epi32(static_cast<int>(start));
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + k));
+    // Running sums within each 128-bit lane...
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    // ...then carry the low lane's total into the high lane
+    __m256i low_total = _mm256_permutevar8x32_epi32(x, low_lane_last);
+    x = _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_setzero_si256(), low_total, 0xF0));
+    x = _mm256_add_epi32(x, carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k), x);
+    carry = _mm256_permutevar8x32_epi32(x, last);
+  }
+  prefix_sum_scalar(in + k, n - k, static_cast<uint32_t>(_mm256_extract_epi32(carry, 0)), out + k); // NOLINT
+}
+
+__attribute__((target("avx2"))) size_t
+find_window_start_avx2(const timestamp_t* times, size_t lo, size_t hi, timestamp_t t_now, timestamp_t window_length)
+{
+  // AVX2 only has a signed 64-bit compare, so flip the sign bits to compare unsigned values
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i now = _mm256_set1_epi64x(static_cast<int64_t>(t_now));
+  const __m256i length = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(window_length)), sign);
+  size_t j = lo;
+  for (; j + 4 <= hi; j += 4) {
+    __m256i diff = _mm256_sub_epi64(now, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times + j)));
+    __m256i in_window = _mm256_cmpgt_epi64(length, _mm256_xor_si256(diff, sign));
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(in_window));
+    if (mask != 0) {
+      return j + __builtin_ctz(mask);
+    }
+  }
+  return find_window_start_scalar(times, j, hi, t_now, window_length);
+}
+
+bool
+cpu_has_avx2()
+{
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool
+cpu_has_avx2()
+{
+  return false;
+}
+
+#endif
+
+} // namespace
+
+TriggerActivityMakerADCSimpleWindowBatch::TriggerActivityMakerADCSimpleWindowBatch()
+  : m_use_avx2(cpu_has_avx2())
+{}
+
+bool
+TriggerActivityMakerADCSimpleWindowBatch::avx2_supported()
+{
+  return cpu_has_avx2();
+}
+
+void
+TriggerActivityMakerADCSimpleWindowBatch::operator()(const TriggerPrimitive& input_tp,
+                                                     std::vector<TriggerActivity>& output_ta)
+{
+  // The same steps as triggeralgs::TriggerActivityMakerADCSimpleWindow, for a single TP
+  if (m_window.empty()) {
+    m_window.push_back(input_tp);
+    m_window_adc_integral = input_tp.adc_integral;
+    return;
+  }
+
+  if (input_tp.time_start - m_window.front().time_start < m_window_length) {
+    // Still inside the window: add it
+    m_window.push_back(input_tp);
+    m_window_adc_integral += input_tp.adc_integral;
+  } else if (m_window_adc_integral > m_adc_threshold) {
+    // Window is complete and over threshold: make a TA and start a new window
+    output_ta.push_back(construct_ta(m_window, m_window_adc_integral));
+    m_window.clear();
+    m_window.push_back(input_tp);
+    m_window_adc_integral = input_tp.adc_integral;
+  } else {
+    // Below threshold: move the window along
+    auto first_kept = std::find_if(m_window.begin(), m_window.end(), [&](const TriggerPrimitive& tp) {
+      return input_tp.time_start - tp.time_start < m_window_length;
+    });
+    for (auto it = m_window.begin(); it != first_kept; ++it) {
+      m_window_adc_integral -= it->adc_integral;
+    }
+    m_window.erase(m_window.begin(), first_kept);
+    m_window.push_back(input_tp);
+    m_window_adc_integral += input_tp.adc_integral;
+  }
+}
+
+void
+TriggerActivityMakerADCSimpleWindowBatch::process_batch(const TPBatch& batch, std::vector<TriggerActivity>& output_ta)
+{
+  if (batch.empty()) {
+    return;
+  }
+
+  // Work on the TPs carried over in the window followed by the TPs in the
+  // batch, as index k in [0, n_carried + batch.size())
+  const size_t n_carried = m_window.size();
+  const size_t n = n_carried + batch.size();
+  auto tp_at = [&](size_t k) -> const TriggerPrimitive& {
+    return k < n_carried ? m_window[k] : batch.tps()[k - n_carried];
+  };
+
+  m_times.resize(n);
+  m_adc_prefix.resize(n + 1);
+  // m_adc_prefix[k] is the sum of adc_integral over [0, k), so the sum over
+  // the window [lo, i) is m_adc_prefix[i] - m_adc_prefix[lo]. With uint32_t
+  // wraparound that's the same value as the algorithm's running sum
+  m_adc_prefix[0] = 0;
+  for (size_t k = 0; k < n_carried; ++k) {
+    m_times[k] = m_window[k].time_start;
+    m_adc_prefix[k + 1] = m_adc_prefix[k] + m_window[k].adc_integral;
+  }
+  std::copy(batch.time_start.begin(), batch.time_start.end(), m_times.begin() + n_carried);
+#if defined(__x86_64__)
+  if (m_use_avx2) {
+    prefix_sum_avx2(batch.adc_integral.data(), batch.size(), m_adc_prefix[n_carried], &m_adc_prefix[n_carried + 1]);
+  } else
+#endif
+  {
+    prefix_sum_scalar(batch.adc_integral.data(), batch.size(), m_adc_prefix[n_carried], &m_adc_prefix[n_carried + 1]);
+  }
+
+  // The window is [lo, i). The very first TP we ever see starts it
+  size_t lo = 0;
+  size_t i = (n_carried == 0) ? 1 : n_carried;
+  for (; i < n; ++i) {
+    if (m_times[i] - m_times[lo] < m_window_length) {
+      continue;
+    }
+    const uint32_t window_adc_integral = m_adc_prefix[i] - m_adc_prefix[lo]; // NOLINT(build/unsigned)
+    if (window_adc_integral > m_adc_threshold) {
+      std::vector<TriggerPrimitive> inputs;
+      inputs.reserve(i - lo);
+      for (size_t k = lo; k < i; ++k) {
+        inputs.push_back(tp_at(k));
+      }
+      output_ta.push_back(construct_ta(std::move(inputs), window_adc_integral));
+      lo = i;
+    } else {
+#if defined(__x86_64__)
+      if (m_use_avx2) {
+        lo = find_window_start_avx2(m_times.data(), lo, i, m_times[i], m_window_length);
+      } else
+#endif
+      {
+        lo = find_window_start_scalar(m_times.data(), lo, i, m_times[i], m_window_length);
+      }
+    }
+  }
+
+  // Carry the open window over to the next call
+  m_next_window.clear();
+  for (size_t k = lo; k < n; ++k) {
+    m_next_window.push_back(tp_at(k));
+  }
+  m_window.swap(m_next_window);
+  m_window_adc_integral = m_adc_prefix[n] - m_adc_prefix[lo];
+}
+
+void
+TriggerActivityMakerADCSimpleWindowBatch::configure(const nlohmann::json& config)
+{
+  if (config.is_object()) {
+    if (config.contains("window_length")) {
+      m_window_length = config["window_length"];
+    }
+    if (config.contains("adc_threshold")) {
+      m_adc_threshold = config["adc_threshold"];
+    }
+  }
+  TLOG_DEBUG(2) << "ADCSimpleWindowBatch window_length " << m_window_length << ", adc_threshold " << m_adc_threshold
+                << (m_use_avx2 ? ", using AVX2" : ", not using AVX2");
+}
+
+triggeralgs::TriggerActivity
+TriggerActivityMakerADCSimpleWindowBatch::construct_ta(std::vector<TriggerPrimitive> inputs,
+                                                       uint32_t adc_integral) const // NOLINT(build/unsigned)
+{
+  const TriggerPrimitive& latest_tp_in_window = inputs.back();
+
+  TriggerActivity ta;
+  ta.time_start = inputs.front().time_start;
+  ta.time_end = latest_tp_in_window.time_start + latest_tp_in_window.time_over_threshold;
+  ta.time_peak = latest_tp_in_window.time_peak;
+  ta.time_activity = latest_tp_in_window.time_peak;
+  ta.channel_start = latest_tp_in_window.channel;
+  ta.channel_end = latest_tp_in_window.channel;
+  ta.channel_peak = latest_tp_in_window.channel;
+  ta.adc_integral = adc_integral;
+  ta.adc_peak = latest_tp_in_window.adc_peak;
+  ta.detid = latest_tp_in_window.detid;
+  ta.type = TriggerActivity::Type::kTPC;
+  ta.algorithm = TriggerActivity::Algorithm::kADCSimpleWindow;
+  ta.inputs = std::move(inputs);
+  return ta;
+}
+
+} // namespace dunedaq::trigger
@@ -0,0 +1,99 @@
+/**
+ * @file HeldDecisionQueue.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_HELDDECISIONQUEUE_HPP_
+#define TRIGGER_SRC_TRIGGER_HELDDECISIONQUEUE_HPP_
+
+#include "trigger/TCCoalescer.hpp"
+
+#include "triggeralgs/TriggerCandidate.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief HeldDecisionQueue holds on to the TC groups of important trigger
+ * decisions while the DFO is busy, so that they can still be sent if it
+ * frees up soon.
+ *
+ * Each TC type has a priority, 0 unless configured otherwise, and a group
+ * has the highest priority of its TCs. Groups with priority 0 are never
+ * held. When the queue is full, a new group replaces the newest of the
+ * lowest-priority groups held, if its priority is higher. Groups are
+ * released highest priority first, and oldest first within a priority.
+ * Groups held for longer than the maximum age are dropped.
+ */
+class HeldDecisionQueue
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+  using type_t = std::underlying_type_t<triggeralgs::TriggerCandidate::Type>;
+
+  enum class Result
+  {
+    kHeld,          // The group is held
+    kHeldReplacing, // The group is held, in place of one with a lower priority, which was dropped
+    kNotHeld        // The group isn't held, because of its priority or because the queue is full
+  };
+
+  // A queue that never holds anything
+  HeldDecisionQueue() = default;
+
+  HeldDecisionQueue(size_t depth, clock_type::duration max_age, const std::map<type_t, int>& priorities)
+    : m_depth(depth)
+    , m_max_age(max_age)
+    , m_priorities(priorities)
+  {
+    m_held.reserve(depth);
+  }
+
+  int get_priority(const TCGroup& group) const;
+
+  Result hold(const TCGroup& group, clock_type::time_point now);
+
+  /**
+   * Drop the groups that have been held for longer than the maximum age.
+   * Returns how many were dropped
+   */
+  size_t drop_expired(clock_type::time_point now);
+
+  /**
+   * Move the next group to release into group and return true, or return false if there isn't one
+   */
+  bool release(TCGroup& group);
+
+  size_t size() const { return m_held.size(); }
+  bool empty() const { return m_held.empty(); }
+  void clear() { m_held.clear(); }
+
+private:
+  struct Entry
+  {
+    TCGroup group;
+    int priority;
+    clock_type::time_point held_time;
+  };
+
+  size_t m_depth = 0;
+  clock_type::duration m_max_age{ 0 };
+  std::map<type_t, int> m_priorities;
+  // Never more than m_depth entries, so searching it is cheap
+  std::vector<Entry> m_held;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_HELDDECISIONQUEUE_HPP_
@@ -1,19 +1,34 @@
 #ifndef TRIGGER_PLUGINS_LIVETIMECOUNTER_HPP_
 #define TRIGGER_PLUGINS_LIVETIMECOUNTER_HPP_
+#include "trigger/LogHistogram.hpp"
+
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <map>
-#include <mutex>
 #include <string>
 
 namespace dunedaq::trigger {
 
 /**
- ** @brief LivetimeCounter counts the total time in milliseconds spent in each of the available states
+ ** @brief LivetimeCounter counts the total time spent in each of the available states
  **
  ** The current state is set at construction, and can be changed with
  ** set_state(). The accumulated time in a particular state can be
  ** retrieved with get_time(State), and the times spent in all the
  ** states with get_time_map()
+ **
+ ** Times are kept in nanoseconds of std::chrono::steady_clock, so short
+ ** inhibits aren't rounded away. The state and times are protected by a
+ ** seqlock: set_state() calls take turns, but the getters never wait for
+ ** anything and never hold up set_state(), so monitoring can read the
+ ** counter as often as it likes
+ **
+ ** Each time the state changes, the length of the episode in the old state
+ ** goes into that state's histogram, so that eg many short inhibits can be
+ ** told apart from a few long ones
  **/
 class LivetimeCounter
 {
@@ -24,6 +39,8 @@ public:
     kPaused // Triggers paused (so we are dead to triggers, but intentionally)
   };
 
+  static constexpr size_t s_n_states = 3;
+
  /**
  ** @brief A type to store a time duration in milliseconds
  **/
@@ -43,37 +60,66 @@ public:
  /**
  ** @brief Set the current state to @a state
  **
- ** Updates the accumulated time in the previous state and switches the state
+ ** Updates the accumulated time in the previous state and switches the
+ ** state. Setting the state that the counter is already in does nothing:
+ ** the episode in that state carries on
  **/
   void set_state(State state);
 
+  State get_state() const;
+
  /**
  ** @brief Get a map of accumulated time in milliseconds in each state
  **/
-  std::map<State, state_time_t> get_time_map();
+  std::map<State, state_time_t> get_time_map() const;
 
  /**
  ** @brief Get the accumulated time in milliseconds spent in a particular state
  **/
-  state_time_t get_time(State state);
+  state_time_t get_time(State state) const;
+
+ /**
+ ** @brief Get the accumulated time in nanoseconds spent in a particular state
+ **/
+  uint64_t get_time_ns(State state) const;
+
+ /**
+ ** @brief Get the histogram of the lengths in microseconds of the episodes
+ ** in a particular state that have ended
+ **
+ ** Its count is the number of times the counter has left the state, and
+ ** its max is the longest episode. The current episode isn't included
+ **/
+  const LogHistogram& get_episode_histogram(State state) const
+  {
+    return m_episode_histograms[static_cast<size_t>(state)];
+  }
 
  /**
  ** @brief Get a nicely-formatted string of the time spent in each state
  **/
-  std::string get_report_string();
+  std::string get_report_string() const;
 
   std::string get_state_name(State state) const;
   
 private:
-  state_time_t now() const;
-  // Precondition:  m_mutex is locked by caller
-     void update_map();
-       
-     std::mutex m_mutex;
-     State m_state;
-     std::map<State, state_time_t> m_state_times;
-     state_time_t m_last_state_change_time;
-  
+  // A consistent copy of the counter, with the time in the current state added in
+  struct Snapshot
+  {
+    State state;
+    std::array<uint64_t, s_n_states> times_ns;
+  };
+
+  Snapshot read() const;
+
+  static uint64_t now_ns();
+
+  // Odd while a set_state() call is changing the fields below
+  std::atomic<uint64_t> m_sequence{ 0 };
+  std::atomic<State> m_state;
+  std::array<std::atomic<uint64_t>, s_n_states> m_state_times_ns;
+  std::atomic<uint64_t> m_last_state_change_time_ns;
+  std::array<LogHistogram, s_n_states> m_episode_histograms;
 };
 } // namespace dunedaq::trigger
  
@@ -0,0 +1,83 @@
+/**
+ * @file LivetimeStateTracker.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_LIVETIMESTATETRACKER_HPP_
+#define TRIGGER_SRC_TRIGGER_LIVETIMESTATETRACKER_HPP_
+
+#include "LivetimeCounter.hpp"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief Sets a LivetimeCounter's state from everything that can stop
+ * triggers, so that none of them overrides the others
+ *
+ * Paused beats dead, which beats live: a busy DFO or running out of tokens
+ * makes us dead, but only when we aren't paused, and we are only live again
+ * when nothing at all is stopping triggers. Each input can be set from its
+ * own thread. The state is worked out and set under a lock, so the last
+ * state set is always the one for the latest inputs
+ */
+class LivetimeStateTracker
+{
+public:
+  using State = LivetimeCounter::State;
+
+  // Starts paused, with the DFO not busy and triggers allowed by the tokens
+  explicit LivetimeStateTracker(std::shared_ptr<LivetimeCounter> livetime_counter)
+    : m_livetime_counter(std::move(livetime_counter))
+  {
+    update();
+  }
+
+  void set_paused(bool paused)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_paused = paused;
+    update();
+  }
+
+  void set_dfo_busy(bool dfo_busy)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_dfo_busy = dfo_busy;
+    update();
+  }
+
+  void set_triggers_allowed(bool triggers_allowed)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_triggers_allowed = triggers_allowed;
+    update();
+  }
+
+  static State get_state(bool paused, bool dfo_busy, bool triggers_allowed)
+  {
+    if (paused) {
+      return State::kPaused;
+    }
+    return dfo_busy || !triggers_allowed ? State::kDead : State::kLive;
+  }
+
+private:
+  void update() { m_livetime_counter->set_state(get_state(m_paused, m_dfo_busy, m_triggers_allowed)); }
+
+  std::shared_ptr<LivetimeCounter> m_livetime_counter;
+  std::mutex m_mutex;
+  bool m_paused{ true };
+  bool m_dfo_busy{ false };
+  bool m_triggers_allowed{ true };
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_LIVETIMESTATETRACKER_HPP_
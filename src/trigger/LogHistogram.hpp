@@ -0,0 +1,108 @@
+/**
+ * @file LogHistogram.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_LOGHISTOGRAM_HPP_
+#define TRIGGER_SRC_TRIGGER_LOGHISTOGRAM_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace dunedaq::trigger {
+
+// A histogram of non-negative integer values with power-of-two bin widths:
+// bin 0 holds 0, and bin b > 0 holds [2^(b-1), 2^b). Values too big for the
+// last bin go in it. add() is lock-free and may be called from any number of
+// threads while others read, which makes it cheap enough for latencies
+// measured on every message. The getters can see an add() half done, eg the
+// count updated but not the sum, so they are for monitoring, not accounting
+class LogHistogram
+{
+public:
+  using value_type = uint64_t; // NOLINT(build/unsigned)
+
+  static constexpr size_t s_n_bins = 40;
+
+  void add(value_type value)
+  {
+    m_bins[get_bin(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    value_type max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  static size_t get_bin(value_type value)
+  {
+    size_t bin = 0;
+    while (value != 0 && bin < s_n_bins - 1) {
+      value >>= 1;
+      ++bin;
+    }
+    return bin;
+  }
+
+  // The smallest value that is past the end of bin
+  static value_type get_bin_upper_edge(size_t bin) { return value_type(1) << bin; }
+
+  value_type get_bin_count(size_t bin) const { return m_bins[bin].load(std::memory_order_relaxed); }
+  value_type get_count() const { return m_count.load(std::memory_order_relaxed); }
+  value_type get_sum() const { return m_sum.load(std::memory_order_relaxed); }
+  value_type get_max() const { return m_max.load(std::memory_order_relaxed); }
+
+  double get_mean() const
+  {
+    value_type const count = get_count();
+    return count == 0 ? 0. : static_cast<double>(get_sum()) / count;
+  }
+
+  // An upper bound on the q-quantile (0 <= q <= 1): the upper edge of the bin
+  // that it is in, or the largest value seen if that is smaller. 0 if there
+  // are no values
+  value_type get_quantile(double q) const
+  {
+    value_type const count = get_count();
+    if (count == 0) {
+      return 0;
+    }
+    // The rank of the quantile, counting from 1
+    value_type rank = static_cast<value_type>(q * count + 0.5);
+    rank = rank == 0 ? 1 : rank;
+    value_type seen = 0;
+    for (size_t bin = 0; bin < s_n_bins; ++bin) {
+      seen += get_bin_count(bin);
+      if (seen >= rank) {
+        value_type const max = get_max();
+        return get_bin_upper_edge(bin) - 1 < max ? get_bin_upper_edge(bin) - 1 : max;
+      }
+    }
+    return get_max();
+  }
+
+  void reset()
+  {
+    for (auto& bin : m_bins) {
+      bin.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::array<std::atomic<value_type>, s_n_bins> m_bins{};
+  std::atomic<value_type> m_count{ 0 };
+  std::atomic<value_type> m_sum{ 0 };
+  std::atomic<value_type> m_max{ 0 };
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_LOGHISTOGRAM_HPP_
@@ -0,0 +1,106 @@
+/**
+ * @file ReadoutMap.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_READOUTMAP_HPP_
+#define TRIGGER_SRC_TRIGGER_READOUTMAP_HPP_
+
+#include "daqdataformats/ComponentRequest.hpp"
+#include "daqdataformats/GeoID.hpp"
+#include "triggeralgs/TriggerCandidate.hpp"
+#include "triggeralgs/Types.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief ReadoutMap decides which links a trigger decision reads out, and
+ * over what time window.
+ *
+ * Each TC type can have its readout window extended before and after the
+ * TC's own window. A type can also be "localized", in which case only the
+ * links of the regions (APAs) that its TAs' channels are in are read out,
+ * rather than every link. The regions are given as ranges of channels.
+ * TCs without TAs, or whose TAs' channels aren't in any region, read out
+ * every link. Everything that depends only on the configuration is worked
+ * out in the constructor, so making a decision only looks things up.
+ */
+class ReadoutMap
+{
+public:
+  using type_t = std::underlying_type_t<triggeralgs::TriggerCandidate::Type>;
+  using channel_t = decltype(triggeralgs::TriggerActivity::channel_start);
+  using region_t = decltype(daqdataformats::GeoID::region_id);
+
+  struct Region
+  {
+    region_t region;
+    channel_t first_channel;
+    channel_t last_channel;
+  };
+
+  struct TypeReadout
+  {
+    bool localized = false;
+    triggeralgs::timestamp_t window_before = 0;
+    triggeralgs::timestamp_t window_after = 0;
+  };
+
+  ReadoutMap() = default;
+  ReadoutMap(const std::vector<daqdataformats::GeoID>& links,
+             const std::vector<Region>& regions,
+             const std::map<type_t, TypeReadout>& type_readouts);
+
+  /**
+   * Replace components with requests for the union of the tcs' (extended)
+   * windows, from the links that any of them needs
+   */
+  void fill_components(const std::vector<triggeralgs::TriggerCandidate>& tcs,
+                       std::vector<daqdataformats::ComponentRequest>& components) const;
+
+  const TypeReadout& get_type_readout(triggeralgs::TriggerCandidate::Type type) const;
+
+  // tc's own window, extended by its type's window_before and window_after
+  void get_readout_window(const triggeralgs::TriggerCandidate& tc,
+                          triggeralgs::timestamp_t& window_begin,
+                          triggeralgs::timestamp_t& window_end) const
+  {
+    const TypeReadout& readout = get_type_readout(tc.type);
+    window_begin = tc.time_start - std::min(tc.time_start, readout.window_before);
+    window_end = tc.time_end + readout.window_after;
+  }
+
+private:
+  // Add the regions that tc's TAs are in to m_regions_hit. Returns false if
+  // there are none, so that every link is needed
+  bool add_regions(const triggeralgs::TriggerCandidate& tc) const;
+
+  std::vector<daqdataformats::GeoID> m_links;
+  // Sorted by first_channel, and not overlapping
+  std::vector<Region> m_regions;
+  // The indices in m_links of each region's links
+  std::map<region_t, std::vector<size_t>> m_region_links;
+  // Indexed by type
+  std::vector<TypeReadout> m_type_readouts;
+  TypeReadout m_default_type_readout;
+
+  // Scratch space for fill_components, so it doesn't allocate. So
+  // fill_components must only be called from one thread at a time
+  mutable std::vector<region_t> m_regions_hit;
+  mutable std::vector<bool> m_links_needed;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_READOUTMAP_HPP_
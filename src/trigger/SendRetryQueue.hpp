@@ -0,0 +1,128 @@
+/**
+ * @file SendRetryQueue.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_SENDRETRYQUEUE_HPP_
+#define TRIGGER_SRC_TRIGGER_SENDRETRYQUEUE_HPP_
+
+#include "trigger/LogHistogram.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief Sends items in order, keeping those that fail to send for another
+ * try later instead of losing them.
+ *
+ * Items are queued with push() and sent by flush(), oldest first, stopping
+ * at the first that fails. An item that fails is dropped instead if it has
+ * been trying for longer than the maximum retry time, or if more than
+ * `depth` items are waiting, so that a receiver that has gone away can't
+ * make the queue grow without limit. With a depth of 0, an item that fails
+ * is dropped straight away.
+ */
+template<class T>
+class SendRetryQueue
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  SendRetryQueue() = default;
+
+  SendRetryQueue(size_t depth, clock_type::duration max_retry_time)
+    : m_depth(depth)
+    , m_max_retry_time(max_retry_time)
+  {}
+
+  // Change the depth and maximum retry time. The items already queued are kept
+  void configure(size_t depth, clock_type::duration max_retry_time)
+  {
+    m_depth = depth;
+    m_max_retry_time = max_retry_time;
+  }
+
+  void push(T&& item, clock_type::time_point now) { m_queue.push_back({ std::move(item), now, 0 }); }
+
+  /**
+   * Send as many of the queued items as possible. try_send(T&) is called for
+   * each, and must return whether it was sent. Items that are dropped are
+   * appended to dropped. Returns the number of items sent
+   */
+  template<class SendFunction>
+  size_t flush(SendFunction&& try_send, clock_type::time_point now, std::vector<T>& dropped)
+  {
+    size_t n_sent = 0;
+    while (!m_queue.empty()) {
+      Entry& entry = m_queue.front();
+      if (try_send(entry.item)) {
+        if (entry.n_failures != 0) {
+          m_retry_latency.add(std::chrono::duration_cast<std::chrono::microseconds>(now - entry.first_try).count());
+        }
+        m_queue.pop_front();
+        ++n_sent;
+        continue;
+      }
+      ++entry.n_failures;
+      ++m_n_failures;
+      if (now - entry.first_try < m_max_retry_time && m_queue.size() <= m_depth) {
+        break;
+      }
+      dropped.push_back(std::move(entry.item));
+      m_queue.pop_front();
+    }
+    return n_sent;
+  }
+
+  // Drop all the queued items, appending them to dropped
+  void drop_all(std::vector<T>& dropped)
+  {
+    for (auto& entry : m_queue) {
+      dropped.push_back(std::move(entry.item));
+    }
+    m_queue.clear();
+  }
+
+  size_t size() const { return m_queue.size(); }
+  bool empty() const { return m_queue.empty(); }
+
+  // The number of failed tries to send an item
+  uint64_t get_n_failures() const { return m_n_failures; } // NOLINT(build/unsigned)
+
+  void reset_counts()
+  {
+    m_n_failures = 0;
+    m_retry_latency.reset();
+  }
+
+  // The time in microseconds from the first try to send an item to sending
+  // it, for the items that didn't send at the first try
+  const LogHistogram& get_retry_latency() const { return m_retry_latency; }
+
+private:
+  struct Entry
+  {
+    T item;
+    clock_type::time_point first_try;
+    size_t n_failures;
+  };
+
+  size_t m_depth = 0;
+  clock_type::duration m_max_retry_time{ 0 };
+  std::deque<Entry> m_queue;
+  uint64_t m_n_failures = 0; // NOLINT(build/unsigned)
+  LogHistogram m_retry_latency;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_SENDRETRYQUEUE_HPP_
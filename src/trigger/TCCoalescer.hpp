@@ -0,0 +1,113 @@
+/**
+ * @file TCCoalescer.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TCCOALESCER_HPP_
+#define TRIGGER_SRC_TRIGGER_TCCOALESCER_HPP_
+
+#include "trigger/ReadoutMap.hpp"
+
+#include "triggeralgs/TriggerCandidate.hpp"
+#include "triggeralgs/Types.hpp"
+
+#include <chrono>
+#include <type_traits>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TCs whose readout windows overlap, to be read out with one trigger
+ * decision covering the union of their windows
+ */
+struct TCGroup
+{
+  std::vector<triggeralgs::TriggerCandidate> tcs;
+  // The union of the TCs' readout windows, as extended by the ReadoutMap
+  triggeralgs::timestamp_t window_begin = 0;
+  triggeralgs::timestamp_t window_end = 0;
+  // The earliest time_candidate of the TCs
+  triggeralgs::timestamp_t time_candidate = 0;
+  // When the first TC of the group arrived, as given to TCCoalescer::add()
+  std::chrono::steady_clock::time_point arrival_time;
+
+  bool empty() const { return tcs.empty(); }
+  void clear() { tcs.clear(); }
+
+  // Whether the readout window [begin, end] overlaps the group's
+  bool overlaps(triggeralgs::timestamp_t begin, triggeralgs::timestamp_t end) const
+  {
+    return !empty() && begin <= window_end && end >= window_begin;
+  }
+
+  // Add tc, whose readout window is [begin, end]
+  void add(triggeralgs::TriggerCandidate&& tc, triggeralgs::timestamp_t begin, triggeralgs::timestamp_t end);
+};
+
+/**
+ * @brief TCCoalescer holds each TC for a short time, and merges into it any
+ * TCs that arrive meanwhile with readout windows that overlap it, so that
+ * the same data isn't read out twice.
+ *
+ * The time is counted from the arrival of the first TC of a group, so a TC
+ * is never held for longer than the merging window however many others
+ * join it. A TC that doesn't overlap the group being held ends the group
+ * early. With a window of zero, every TC is a group of its own.
+ *
+ * The readout windows compared are the ones that will be read out: if a
+ * ReadoutMap is given, each TC's window is extended by its type's
+ * window_before and window_after. Otherwise the TCs' own windows are used.
+ */
+class TCCoalescer
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+  static_assert(std::is_same_v<clock_type, decltype(TCGroup::arrival_time)::clock>);
+
+  // readout_map, if given, must outlive the TCCoalescer
+  explicit TCCoalescer(std::chrono::microseconds window, const ReadoutMap* readout_map = nullptr)
+    : m_window(window)
+    , m_readout_map(readout_map)
+  {}
+
+  /**
+   * Add a TC. If it doesn't overlap the group being held, that group is put
+   * in ready and true is returned, and the TC starts a new group
+   */
+  bool add(triggeralgs::TriggerCandidate&& tc, clock_type::time_point now, TCGroup& ready);
+
+  /**
+   * If the group being held has been held for the merging window, put it
+   * in ready and return true
+   */
+  bool flush_due(clock_type::time_point now, TCGroup& ready);
+
+  /**
+   * Put the group being held, if any, in ready and return true
+   */
+  bool flush(TCGroup& ready);
+
+  /**
+   * When the group being held is due. clock_type::time_point::max() if there isn't one
+   */
+  clock_type::time_point get_deadline() const
+  {
+    return m_held.empty() ? clock_type::time_point::max() : m_deadline;
+  }
+
+private:
+  std::chrono::microseconds m_window;
+  const ReadoutMap* m_readout_map;
+  TCGroup m_held;
+  clock_type::time_point m_deadline;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TCCOALESCER_HPP_
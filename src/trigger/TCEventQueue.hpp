@@ -0,0 +1,158 @@
+/**
+ * @file TCEventQueue.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TCEVENTQUEUE_HPP_
+#define TRIGGER_SRC_TRIGGER_TCEVENTQUEUE_HPP_
+
+#include "trigger/TCCoalescer.hpp"
+
+#include "triggeralgs/TriggerCandidate.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief Passes TCs from the ModuleLevelTrigger's input callback to its
+ * decision thread, and wakes that thread for everything else it waits for
+ *
+ * push() waits for room, so that a slow decision thread holds up its input.
+ * Stopping a run takes two steps:
+ *
+ * - stop() tells the decision thread to stop waiting for anything but TCs,
+ *   eg tokens that may never come back, so that it keeps taking TCs and a
+ *   push() waiting for room gets it.
+ * - close() is called once nothing more will be pushed, eg once the callback
+ *   has been removed, and makes any push() still waiting drop its TC.
+ */
+class TCEventQueue
+{
+public:
+  using clock_type = TCCoalescer::clock_type;
+
+  struct ReceivedTC
+  {
+    triggeralgs::TriggerCandidate tc;
+    clock_type::time_point arrival_time;
+  };
+
+  explicit TCEventQueue(size_t capacity)
+    : m_capacity(capacity)
+  {}
+
+  // Empty the queue and start taking TCs, at the start of a run
+  void open()
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_queue.clear();
+      m_event_pending = false;
+      m_open = true;
+    }
+    m_stopping.store(false);
+  }
+
+  // Wake the decision thread, and make wait_unless_stopping() return from now on
+  void stop()
+  {
+    m_stopping.store(true);
+    notify();
+  }
+
+  bool is_stopping() const { return m_stopping.load(); }
+
+  // Stop taking TCs. A push() waiting for room drops its TC
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_open = false;
+    }
+    m_space_cv.notify_all();
+  }
+
+  // Add tc once there is room. Returns false, dropping tc, if the queue is or becomes closed
+  bool push(triggeralgs::TriggerCandidate&& tc, clock_type::time_point arrival_time)
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_space_cv.wait(lk, [this]() { return m_queue.size() < m_capacity || !m_open; });
+      if (!m_open) {
+        return false;
+      }
+      m_queue.push_back({ std::move(tc), arrival_time });
+    }
+    m_event_cv.notify_one();
+    return true;
+  }
+
+  // Wake the decision thread to look at whatever it is waiting for again
+  void notify()
+  {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_event_pending = true;
+    }
+    m_event_cv.notify_one();
+  }
+
+  /**
+   * @brief Wait until there are TCs, notify() is called, done() is true or
+   * the deadline has passed, and then swap all the TCs queued into tcs
+   *
+   * Returns done(), as it was when the TCs were taken. So if done() means no
+   * more TCs will be pushed, true means that none were left behind
+   */
+  template<class Predicate>
+  bool wait_and_take(clock_type::time_point deadline, std::vector<ReceivedTC>& tcs, Predicate done)
+  {
+    tcs.clear();
+    bool is_done = false;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_event_cv.wait_until(lk, deadline, [&]() { return !m_queue.empty() || m_event_pending || done(); });
+      m_event_pending = false;
+      // The vectors swap back and forth, so they keep their capacity
+      tcs.swap(m_queue);
+      is_done = done();
+    }
+    m_space_cv.notify_all();
+    return is_done;
+  }
+
+  // Wait until ready() is true, or stop() is called. Returns ready()
+  template<class Predicate>
+  bool wait_unless_stopping(Predicate ready)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_event_cv.wait(lk, [&]() { return ready() || m_stopping.load(); });
+    return ready();
+  }
+
+private:
+  const size_t m_capacity;
+  std::mutex m_mutex;
+  std::condition_variable m_event_cv;
+  std::condition_variable m_space_cv;
+  // Guarded by m_mutex
+  std::vector<ReceivedTC> m_queue;
+  bool m_event_pending{ false };
+  bool m_open{ false };
+  std::atomic<bool> m_stopping{ false };
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TCEVENTQUEUE_HPP_
@@ -0,0 +1,90 @@
+/**
+ * @file TCTypeLimiter.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TCTYPELIMITER_HPP_
+#define TRIGGER_SRC_TRIGGER_TCTYPELIMITER_HPP_
+
+#include "triggeralgs/TriggerCandidate.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <type_traits>
+
+namespace dunedaq {
+namespace trigger {
+
+/**
+ * @brief TCTypeLimiter decides which TCs of each type go on to make trigger
+ * decisions, so that one misbehaving trigger type can't swamp the dataflow.
+ *
+ * Each type can have a prescale, so that only one in every `prescale` TCs
+ * of the type is accepted, and a token bucket rate limit on the TCs that
+ * pass the prescale: up to `rate_limit_burst` at once, refilled at
+ * `rate_limit_hz`. Types without limits set are always accepted. The
+ * limits can be changed while check() is being called from another thread.
+ */
+class TCTypeLimiter
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+  using type_t = std::underlying_type_t<triggeralgs::TriggerCandidate::Type>;
+
+  enum class Result
+  {
+    kAccepted,
+    kPrescaled,
+    kRateLimited
+  };
+
+  struct Limits
+  {
+    uint64_t prescale = 1;     // NOLINT(build/unsigned)
+    double rate_limit_hz = 0.; // 0 for no limit
+    double rate_limit_burst = 1.;
+  };
+
+  struct Counts
+  {
+    uint64_t accepted = 0;     // NOLINT(build/unsigned)
+    uint64_t prescaled = 0;    // NOLINT(build/unsigned)
+    uint64_t rate_limited = 0; // NOLINT(build/unsigned)
+  };
+
+  /**
+   * Replace the limits of all types. Types that aren't in limits have no
+   * limits from now on. The counts carry on
+   */
+  void set_limits(const std::map<type_t, Limits>& limits, clock_type::time_point now);
+
+  Result check(triggeralgs::TriggerCandidate::Type type, clock_type::time_point now);
+
+  // The counts of each type that has been checked
+  std::map<type_t, Counts> get_counts() const;
+
+  void reset_counts();
+
+private:
+  struct TypeState
+  {
+    Limits limits;
+    uint64_t n_since_accepted = 0; // NOLINT(build/unsigned)
+    double tokens = 0.;
+    clock_type::time_point last_refill;
+    Counts counts;
+  };
+
+  mutable std::mutex m_mutex;
+  std::map<type_t, TypeState> m_states;
+};
+
+} // namespace trigger
+} // namespace dunedaq
+
+#endif // TRIGGER_SRC_TRIGGER_TCTYPELIMITER_HPP_
@@ -0,0 +1,88 @@
+/**
+ * @file TPBinaryFile.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TPBINARYFILE_HPP_
+#define TRIGGER_SRC_TRIGGER_TPBINARYFILE_HPP_
+
+#include "detdataformats/trigger/TriggerPrimitive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace dunedaq::trigger {
+
+// A TP binary file is a TPBinaryFileHeader followed by a contiguous array of
+// TriggerPrimitive, exactly as they are laid out in memory, sorted by
+// time_start. This lets TriggerPrimitiveMaker map the file into memory and
+// slice it into TPSets as it goes, rather than parsing a text file up front.
+// Files are written with TPBinaryFileWriter, usually by the
+// convert_TPs_to_binary application
+struct TPBinaryFileHeader
+{
+  static constexpr uint32_t s_magic = 0x46425054; // "TPBF" NOLINT(build/unsigned)
+  static constexpr uint16_t s_version = 1;        // NOLINT(build/unsigned)
+
+  uint32_t magic = s_magic;       // NOLINT(build/unsigned)
+  uint16_t version = s_version;   // NOLINT(build/unsigned)
+  uint16_t tp_size = sizeof(detdataformats::trigger::TriggerPrimitive); // NOLINT(build/unsigned)
+  uint64_t n_tps = 0;             // NOLINT(build/unsigned)
+};
+static_assert(sizeof(TPBinaryFileHeader) == 16, "TPBinaryFileHeader must not have padding");
+
+class TPBinaryFileWriter
+{
+public:
+  explicit TPBinaryFileWriter(const std::string& filename);
+  ~TPBinaryFileWriter();
+
+  TPBinaryFileWriter(const TPBinaryFileWriter&) = delete;
+  TPBinaryFileWriter& operator=(const TPBinaryFileWriter&) = delete;
+
+  void write(const detdataformats::trigger::TriggerPrimitive& tp) { write(&tp, 1); }
+  void write(const detdataformats::trigger::TriggerPrimitive* tps, size_t n_tps);
+
+  // Fill in the TP count in the header and close the file. Called by the destructor if needed
+  void close();
+
+  size_t get_n_tps() const { return m_header.n_tps; }
+
+private:
+  std::string m_filename;
+  std::ofstream m_file;
+  TPBinaryFileHeader m_header;
+};
+
+// Maps a TP binary file into memory, read-only. The TPs are paged in by the
+// kernel as they are read, so opening even a very large file is quick and
+// only the parts recently read occupy memory
+class TPBinaryFileReader
+{
+public:
+  explicit TPBinaryFileReader(const std::string& filename);
+  ~TPBinaryFileReader();
+
+  TPBinaryFileReader(const TPBinaryFileReader&) = delete;
+  TPBinaryFileReader& operator=(const TPBinaryFileReader&) = delete;
+
+  const detdataformats::trigger::TriggerPrimitive* data() const { return m_tps; }
+  size_t size() const { return m_n_tps; }
+  bool empty() const { return m_n_tps == 0; }
+
+private:
+  std::string m_filename;
+  void* m_map = nullptr;
+  size_t m_map_size = 0;
+  const detdataformats::trigger::TriggerPrimitive* m_tps = nullptr;
+  size_t m_n_tps = 0;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_TPBINARYFILE_HPP_
@@ -0,0 +1,150 @@
+/**
+ * @file TPGenerator.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TPGENERATOR_HPP_
+#define TRIGGER_SRC_TRIGGER_TPGENERATOR_HPP_
+
+#include "trigger/TPSet.hpp"
+
+#include "daqdataformats/Types.hpp"
+#include "detdataformats/trigger/TriggerPrimitive.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+// xoshiro256++ (Blackman and Vigna). Much cheaper than std::mt19937 and
+// plenty good enough for making up TPs. Satisfies UniformRandomBitGenerator,
+// so it can drive the std:: distributions too
+class Xoshiro256
+{
+public:
+  using result_type = uint64_t; // NOLINT(build/unsigned)
+
+  explicit Xoshiro256(uint64_t seed); // NOLINT(build/unsigned)
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()()
+  {
+    uint64_t const result = rotl(m_s[0] + m_s[3], 23) + m_s[0]; // NOLINT(build/unsigned)
+    uint64_t const t = m_s[1] << 17;                             // NOLINT(build/unsigned)
+    m_s[2] ^= m_s[0];
+    m_s[3] ^= m_s[1];
+    m_s[1] ^= m_s[2];
+    m_s[0] ^= m_s[3];
+    m_s[2] ^= t;
+    m_s[3] = rotl(m_s[3], 45);
+    return result;
+  }
+
+  // Uniform in [0, 1)
+  double uniform() { return static_cast<double>((*this)() >> 11) * 0x1.0p-53; }
+
+  // Uniform in [0, n). n must be non-zero
+  uint64_t below(uint64_t n) { return (*this)() % n; } // NOLINT(build/unsigned)
+
+private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); } // NOLINT(build/unsigned)
+
+  uint64_t m_s[4]; // NOLINT(build/unsigned)
+};
+
+// What TPGenerator makes. Rates are in Hz of data time, and times in clock ticks
+struct TPGeneratorParams
+{
+  double clock_frequency_hz = 50e6;
+
+  detdataformats::trigger::channel_t first_channel = 0;
+  uint32_t n_channels = 2560; // NOLINT(build/unsigned)
+
+  // Single-channel noise TPs, per channel
+  double noise_rate_hz = 10.;
+  double noise_adc_mean = 100.;
+
+  // Ar39 decays: one or two adjacent channels, a bit above the noise
+  double ar39_rate_hz = 0.;
+  double ar39_adc_mean = 600.;
+
+  // Tracks: a line of TPs across adjacent channels, with the time changing steadily along it
+  double track_rate_hz = 0.;
+  uint32_t track_min_channels = 20;  // NOLINT(build/unsigned)
+  uint32_t track_max_channels = 200; // NOLINT(build/unsigned)
+  double track_adc_mean = 3000.;
+  // Largest time difference between neighbouring channels of a track
+  daqdataformats::timestamp_t track_max_slope = 100;
+
+  // Supernova-like bursts: for burst_duration after each burst starts, there
+  // are extra low-energy clusters of up to four channels anywhere in the detector
+  double burst_rate_hz = 0.;
+  daqdataformats::timestamp_t burst_duration = 500'000'000;
+  double burst_cluster_rate_hz = 100.;
+  double burst_adc_mean = 1500.;
+
+  daqdataformats::timestamp_t min_time_over_threshold = 4;
+  daqdataformats::timestamp_t max_time_over_threshold = 64;
+
+  detdataformats::trigger::detid_t detid = 0;
+};
+
+// Makes up TPs from the distributions in TPGeneratorParams, one TPSet's time
+// window at a time. The same seed and windows give the same TPs
+class TPGenerator
+{
+public:
+  TPGenerator(const TPGeneratorParams& params, uint64_t seed); // NOLINT(build/unsigned)
+
+  // The mean number of TPs per second of data time
+  double get_mean_tp_rate() const;
+
+  // Multiply all the rates by factor, eg to get a given mean TP rate
+  void scale_rates(double factor);
+
+  // Replace tpset.objects with the TPs that start in [start_time, end_time),
+  // sorted by time_start. TPs of clusters that start in the window but
+  // carry on past its end are kept for the next window. Windows must be
+  // given in order, without gaps. tpset.objects keeps its capacity, so
+  // reusing a TPSet means no allocation once it is big enough. The other
+  // fields of tpset are left alone
+  void fill(TPSet& tpset, daqdataformats::timestamp_t start_time, daqdataformats::timestamp_t end_time);
+
+private:
+  using tp_vector = std::vector<detdataformats::trigger::TriggerPrimitive>;
+
+  // The number of events in an interval, with a mean of rate_hz * duration
+  uint32_t n_events(double rate_hz, daqdataformats::timestamp_t duration); // NOLINT(build/unsigned)
+
+  daqdataformats::timestamp_t random_time(daqdataformats::timestamp_t start, daqdataformats::timestamp_t duration);
+  detdataformats::trigger::channel_t random_channel();
+  daqdataformats::timestamp_t random_time_over_threshold();
+
+  void add_tp(tp_vector& tps,
+              daqdataformats::timestamp_t time_start,
+              detdataformats::trigger::channel_t channel,
+              double adc_mean);
+  void add_cluster(tp_vector& tps,
+                   daqdataformats::timestamp_t time_start,
+                   uint32_t n_channels, // NOLINT(build/unsigned)
+                   double adc_mean);
+  void add_track(tp_vector& tps, daqdataformats::timestamp_t time_start);
+
+  TPGeneratorParams m_params;
+  Xoshiro256 m_rng;
+
+  // TPs made in an earlier window that start after its end
+  tp_vector m_pending;
+  // When the current burst, if any, ends
+  daqdataformats::timestamp_t m_burst_end = 0;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_TPGENERATOR_HPP_
@@ -0,0 +1,260 @@
+/**
+ * @file TPSetSource.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TPSETSOURCE_HPP_
+#define TRIGGER_SRC_TRIGGER_TPSETSOURCE_HPP_
+
+#include "trigger/SPSCRingBuffer.hpp"
+#include "trigger/TPBinaryFile.hpp"
+#include "trigger/TPSet.hpp"
+
+#include "daqdataformats/Types.hpp"
+#include "detdataformats/trigger/TriggerPrimitive.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::hdf5libs {
+class HDF5RawDataFile;
+} // namespace dunedaq::hdf5libs
+
+namespace dunedaq::trigger {
+
+// Read one TP from a text file in the format used by TriggerPrimitiveMaker:
+// whitespace-separated time_start, time_over_threshold, time_peak, channel,
+// adc_integral, adc_peak, detid, type. Returns false at the end of the file
+bool
+read_text_tp(std::istream& in, detdataformats::trigger::TriggerPrimitive& tp);
+
+// Groups a time-ordered sequence of TPs into TPSets with time boundaries
+// n*width + offset. TPs that are earlier than the previous TP are dropped
+// with a warning. The TPSets can be shifted in time as they are built, by
+// adding the time shift given to reset() to all their timestamps
+class TPSetSlicer
+{
+public:
+  TPSetSlicer(const std::string& name,
+              daqdataformats::timestamp_t width,
+              daqdataformats::timestamp_t offset,
+              uint16_t region_id,  // NOLINT(build/unsigned)
+              uint32_t element_id) // NOLINT(build/unsigned)
+    : m_name(name)
+    , m_width(width)
+    , m_offset(offset)
+    , m_region_id(region_id)
+    , m_element_id(element_id)
+  {}
+
+  // Add the next TP. If it is past the end of the TPSet being built, the
+  // completed TPSet is put in out and true is returned
+  bool add(const detdataformats::trigger::TriggerPrimitive& tp, TPSet& out);
+
+  // Put the last TPSet in out, if it has any TPs
+  bool finish(TPSet& out);
+
+  // Go back to the state before any TPs were added, and shift the
+  // timestamps of the TPSets built from then on by time_shift
+  void reset(daqdataformats::timestamp_t time_shift = 0);
+
+  const std::string& get_name() const { return m_name; }
+
+  // The start time of the TPSet that a TP with this time_start would go in
+  daqdataformats::timestamp_t tpset_start_time(daqdataformats::timestamp_t tp_time) const
+  {
+    return (tp_time + m_offset) / m_width * m_width + m_offset;
+  }
+
+private:
+  void fill(TPSet& out);
+
+  std::string m_name;
+  daqdataformats::timestamp_t m_width;
+  daqdataformats::timestamp_t m_offset;
+  daqdataformats::timestamp_t m_time_shift = 0;
+  uint16_t m_region_id;  // NOLINT(build/unsigned)
+  uint32_t m_element_id; // NOLINT(build/unsigned)
+
+  std::vector<detdataformats::trigger::TriggerPrimitive> m_objects;
+  uint64_t m_tpset_number = 0; // NOLINT(build/unsigned)
+  daqdataformats::timestamp_t m_last_time_start = 0;
+  TPSet::seqno_t m_seqno = 0;
+};
+
+// A stream of TPSets for TriggerPrimitiveMaker to replay
+class TPSetSource
+{
+public:
+  virtual ~TPSetSource() = default;
+
+  // Put the next TPSet in tpset. Returns false at the end of the stream
+  virtual bool next(TPSet& tpset) = 0;
+
+  // Go back to the start of the stream. From then on, time_shift is added to
+  // the timestamps of the TPSets and their TPs as they are built, so that
+  // a stream can be replayed several times without its timestamps repeating
+  virtual void rewind(daqdataformats::timestamp_t time_shift) = 0;
+
+  virtual bool empty() const = 0;
+
+  // Start times of the first and last TPSets in the stream. Only meaningful if the stream isn't empty
+  virtual daqdataformats::timestamp_t get_first_start_time() const = 0;
+  virtual daqdataformats::timestamp_t get_last_start_time() const = 0;
+};
+
+// Holds the whole stream in memory, having read it all up front from a text file
+class TextFileTPSetSource : public TPSetSource
+{
+public:
+  TextFileTPSetSource(const std::string& filename, TPSetSlicer slicer);
+
+  bool next(TPSet& tpset) override;
+  void rewind(daqdataformats::timestamp_t time_shift) override
+  {
+    m_index = 0;
+    m_time_shift = time_shift;
+  }
+  bool empty() const override { return m_tpsets.empty(); }
+  daqdataformats::timestamp_t get_first_start_time() const override { return m_tpsets.front().start_time; }
+  daqdataformats::timestamp_t get_last_start_time() const override { return m_tpsets.back().start_time; }
+
+private:
+  std::vector<TPSet> m_tpsets;
+  size_t m_index = 0;
+  daqdataformats::timestamp_t m_time_shift = 0;
+};
+
+// Reads TPs from a text file only as they are needed, so memory use doesn't
+// depend on the size of the file
+class StreamingTextFileTPSetSource : public TPSetSource
+{
+public:
+  StreamingTextFileTPSetSource(const std::string& filename, TPSetSlicer slicer);
+
+  bool next(TPSet& tpset) override;
+  void rewind(daqdataformats::timestamp_t time_shift) override;
+  bool empty() const override { return m_empty; }
+  daqdataformats::timestamp_t get_first_start_time() const override { return m_first_start_time; }
+  daqdataformats::timestamp_t get_last_start_time() const override { return m_last_start_time; }
+
+private:
+  std::ifstream m_file;
+  TPSetSlicer m_slicer;
+  bool m_empty = true;
+  daqdataformats::timestamp_t m_first_start_time = 0;
+  daqdataformats::timestamp_t m_last_start_time = 0;
+};
+
+// Slices the TPs from a memory-mapped TP binary file into TPSets as they are asked for
+class BinaryFileTPSetSource : public TPSetSource
+{
+public:
+  BinaryFileTPSetSource(const std::string& filename, TPSetSlicer slicer);
+
+  bool next(TPSet& tpset) override;
+  void rewind(daqdataformats::timestamp_t time_shift) override;
+  bool empty() const override { return m_reader.empty(); }
+  daqdataformats::timestamp_t get_first_start_time() const override;
+  daqdataformats::timestamp_t get_last_start_time() const override;
+
+private:
+  TPBinaryFileReader m_reader;
+  TPSetSlicer m_slicer;
+  size_t m_index = 0;
+};
+
+// Reads the TPs in the fragments of an HDF5 raw data file, one record at a
+// time. The fragment payloads are arrays of TriggerPrimitive, as in the
+// files written by the TP stream writer. Within a record, the TPs from all of
+// the fragments are sorted by time_start before slicing, so that TPs from
+// several links can be replayed as one stream. All the instances in a
+// process take turns to call into libhdf5, which needn't be threadsafe
+class HDF5FileTPSetSource : public TPSetSource
+{
+public:
+  HDF5FileTPSetSource(const std::string& filename, TPSetSlicer slicer);
+  ~HDF5FileTPSetSource();
+
+  bool next(TPSet& tpset) override;
+  void rewind(daqdataformats::timestamp_t time_shift) override;
+  bool empty() const override { return m_empty; }
+  daqdataformats::timestamp_t get_first_start_time() const override { return m_first_start_time; }
+  daqdataformats::timestamp_t get_last_start_time() const override { return m_last_start_time; }
+
+private:
+  using record_id_t = std::pair<uint64_t, daqdataformats::sequence_number_t>; // NOLINT(build/unsigned)
+
+  // Replace m_tps with the sorted TPs of the record
+  void read_record(const record_id_t& record_id);
+
+  std::string m_filename;
+  std::unique_ptr<hdf5libs::HDF5RawDataFile> m_file;
+  TPSetSlicer m_slicer;
+  std::vector<record_id_t> m_record_ids;
+  size_t m_next_record = 0;
+  std::vector<detdataformats::trigger::TriggerPrimitive> m_tps;
+  size_t m_next_tp = 0;
+
+  bool m_empty = true;
+  daqdataformats::timestamp_t m_first_start_time = 0;
+  daqdataformats::timestamp_t m_last_start_time = 0;
+};
+
+// Runs another source in a reader thread of its own, which keeps up to
+// `depth` TPSets ready in a ring buffer. next() and rewind() must all be
+// called from one thread. When the buffer is full, the reader thread sleeps
+// until next() makes room or the source is rewound or destroyed
+class PrefetchingTPSetSource : public TPSetSource
+{
+public:
+  PrefetchingTPSetSource(std::unique_ptr<TPSetSource> source, size_t depth);
+  ~PrefetchingTPSetSource();
+
+  PrefetchingTPSetSource(const PrefetchingTPSetSource&) = delete;
+  PrefetchingTPSetSource& operator=(const PrefetchingTPSetSource&) = delete;
+
+  bool next(TPSet& tpset) override;
+  void rewind(daqdataformats::timestamp_t time_shift) override;
+  bool empty() const override { return m_source->empty(); }
+  daqdataformats::timestamp_t get_first_start_time() const override { return m_source->get_first_start_time(); }
+  daqdataformats::timestamp_t get_last_start_time() const override { return m_source->get_last_start_time(); }
+
+private:
+  void start_reading();
+  void stop_reading();
+  void read_ahead();
+  // Wake the reader thread if it is waiting for room in m_buffer
+  void notify_reader();
+
+  std::unique_ptr<TPSetSource> m_source;
+  SPSCRingBuffer<TPSet> m_buffer;
+  std::thread m_thread;
+  std::atomic<bool> m_stop{ false };
+  // Set by the reader thread when m_source has no more TPSets
+  std::atomic<bool> m_done{ false };
+  std::mutex m_reader_mutex;
+  std::condition_variable m_reader_cv;
+  // Set by the reader thread while it is waiting for room, so that next() only takes the lock then
+  std::atomic<bool> m_reader_waiting{ false };
+  // Whether next() has been called since the reader thread started from the beginning
+  bool m_consumed = false;
+  // The time shift that the reader thread is applying
+  daqdataformats::timestamp_t m_time_shift = 0;
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_TPSETSOURCE_HPP_
@@ -11,11 +11,13 @@
 
 #include "trigger/Issues.hpp"
 #include "trigger/Set.hpp"
+#include "trigger/SetBufferPool.hpp"
 
 #include "logging/Logging.hpp"
 
 #include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace dunedaq::trigger {
@@ -36,20 +38,20 @@ public:
   // Add a new Set<T> to the buffer. If it's inconsistent with buffered events,
   // fill time_slice, start_time, end_time with the previous (complete) slice.
   // Returns whether the previous slice was complete (and time_slice etc was filled)
-  bool buffer(Set<T> in,
+  bool buffer(Set<T>&& in,
               std::vector<T>& time_slice,
               daqdataformats::timestamp_t& start_time,
               daqdataformats::timestamp_t& end_time)
   {
     if (m_buffer.size() == 0 || m_buffer.back().start_time == in.start_time) {
       // if `in` is the current time slice
-      m_buffer.emplace_back(in);
+      m_buffer.emplace_back(std::move(in));
       return false; // buffer the time slice
     }
     // obtain the current (complete) time slice
     flush(time_slice, start_time, end_time);
     // add `in`, which is the next time slice
-    m_buffer.emplace_back(in);
+    m_buffer.emplace_back(std::move(in));
     return true;
   }
   // Fill time_slice with the sorted buffer, clear the buffer, and return true
@@ -67,6 +69,8 @@ public:
         ers::warning(InconsistentSetTimeError(ERS_HERE, m_name, m_algorithm));
       }
       time_slice.insert(time_slice.end(), x.objects.begin(), x.objects.end());
+      // hand the set's vector back, so the next deserialized set can reuse it
+      SetBufferPool<T>::get().recycle(x);
     }
     // clear the buffer
     m_buffer.clear();
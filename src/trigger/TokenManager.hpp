@@ -9,7 +9,7 @@
 #ifndef TRIGGER_SRC_TRIGGER_TOKENMANAGER_HPP_
 #define TRIGGER_SRC_TRIGGER_TOKENMANAGER_HPP_
 
-#include "LivetimeCounter.hpp"
+#include "LogHistogram.hpp"
 
 #include "dfmessages/TimeSync.hpp"
 #include "dfmessages/TriggerDecisionToken.hpp"
@@ -18,8 +18,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <set>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -36,6 +38,12 @@ namespace trigger {
  * TriggerDecisionToken is received on the queue, the number of tokens
  * is incremented. When the count of available tokens reaches zero, no
  * further TriggerDecisions may be issued.
+ *
+ * The in-flight decisions are kept in a fixed-size table indexed by trigger
+ * number, whose slots are claimed and released with atomic operations, so
+ * sending a decision and receiving its token never wait for each other.
+ * When the token comes back, the time since the decision was sent goes into
+ * a latency histogram.
  */
 class TokenManager
 {
@@ -43,7 +51,8 @@ public:
   TokenManager(const std::string& connection_name,
                int initial_tokens,
                daqdataformats::run_number_t run_number,
-               std::shared_ptr<LivetimeCounter> livetime_counter);
+               std::function<void(bool)> triggers_allowed_callback = nullptr,
+               std::function<void()> token_received_callback = nullptr);
 
   virtual ~TokenManager();
 
@@ -72,10 +81,39 @@ public:
    */
   void trigger_sent(dfmessages::trigger_number_t);
 
+  /**
+   * Undo trigger_sent() for a trigger decision that could not be sent after
+   * all, so that its token isn't lost
+   */
+  void trigger_not_sent(dfmessages::trigger_number_t);
+
+  /**
+   * The times in microseconds from trigger_sent() to receiving the token, for
+   * the decisions whose tokens have come back
+   */
+  const LogHistogram& get_latency_histogram() const { return m_latency_histogram; }
+
 private:
   // The main thread
   void receive_token(dfmessages::TriggerDecisionToken& token);
 
+  // One in-flight trigger decision. trigger_number_plus_one is 0 when the slot is free
+  struct Slot
+  {
+    std::atomic<uint64_t> trigger_number_plus_one{ 0 }; // NOLINT(build/unsigned)
+    std::atomic<int64_t> sent_time_ns{ 0 };
+  };
+
+  // Free the slot of trigger_number, if it has it. Returns whether it did,
+  // and sets sent_time_ns to when the decision was sent
+  bool release_slot(dfmessages::trigger_number_t trigger_number, int64_t& sent_time_ns);
+
+  // Pass triggers_allowed() to the triggers-allowed callback. Called when the
+  // number of tokens goes to or from zero
+  void update_triggers_allowed();
+
+  static int64_t now_ns();
+
   std::string m_connection_name;
 
   // Are we running?
@@ -83,16 +121,27 @@ private:
   // How many tokens are currently available?
   std::atomic<int> m_n_tokens;
 
-  // The currently-in-flight trigger decisions, and a mutex to guard it
-  std::set<dfmessages::trigger_number_t> m_open_trigger_decisions;
-  std::mutex m_open_trigger_decisions_mutex;
+  // The currently-in-flight trigger decisions, in slot trigger_number & m_slot_mask.
+  // A decision whose slot is still held by an older one isn't tracked
+  std::unique_ptr<Slot[]> m_slots;
+  size_t m_slot_mask;
+
+  LogHistogram m_latency_histogram;
 
   daqdataformats::run_number_t m_run_number;
-  std::shared_ptr<LivetimeCounter> m_livetime_counter;
+  // Called, if set, with whether triggers are allowed whenever that changes,
+  // eg to keep the livetime counter's state up to date
+  std::function<void(bool)> m_triggers_allowed_callback;
+  // Only taken when the number of tokens goes to or from zero, so that the
+  // last value passed to the callback is the right one when two threads do that at once
+  std::mutex m_triggers_allowed_mutex;
 
   // open strigger report time
   std::chrono::time_point<std::chrono::steady_clock> m_open_trigger_time;
 
+  // Called, if set, after each token is received, eg to wake a thread waiting for one
+  std::function<void()> m_token_received_callback;
+
   // the IOManager receiver instance
   std::shared_ptr<iomanager::ReceiverConcept<dfmessages::TriggerDecisionToken>> m_token_receiver;
 };
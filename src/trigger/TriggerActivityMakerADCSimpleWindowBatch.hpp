@@ -0,0 +1,90 @@
+/**
+ * @file TriggerActivityMakerADCSimpleWindowBatch.hpp
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERADCSIMPLEWINDOWBATCH_HPP_
+#define TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERADCSIMPLEWINDOWBATCH_HPP_
+
+#include "trigger/TPBatch.hpp"
+
+#include "triggeralgs/TriggerActivity.hpp"
+#include "triggeralgs/TriggerActivityMaker.hpp"
+#include "triggeralgs/TriggerPrimitive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq::trigger {
+
+/**
+ * @brief Batch implementation of triggeralgs::TriggerActivityMakerADCSimpleWindow
+ *
+ * Produces exactly the same TriggerActivities as the triggeralgs
+ * algorithm, with the same configuration keys (window_length and
+ * adc_threshold), but works on a whole TPBatch at a time. The window ADC
+ * sum is taken from a prefix sum of the adc_integral column, and the new
+ * window start after a move is found by scanning the time_start column.
+ * Both loops use AVX2 when the CPU supports it, and plain C++ otherwise.
+ *
+ * The window is kept between calls, so TPs can be fed either through
+ * process_batch() or one at a time through operator(), in any mix.
+ */
+class TriggerActivityMakerADCSimpleWindowBatch
+  : public triggeralgs::TriggerActivityMaker
+  , public TPBatchProcessor<triggeralgs::TriggerActivity>
+{
+public:
+  using TriggerPrimitive = triggeralgs::TriggerPrimitive;
+  using TriggerActivity = triggeralgs::TriggerActivity;
+  using timestamp_t = triggeralgs::timestamp_t;
+
+  TriggerActivityMakerADCSimpleWindowBatch();
+
+  void operator()(const TriggerPrimitive& input_tp, std::vector<TriggerActivity>& output_ta) override;
+
+  void process_batch(const TPBatch& batch, std::vector<TriggerActivity>& output_ta) override;
+
+  void configure(const nlohmann::json& config) override;
+
+  // Whether this CPU can run the AVX2 kernels
+  static bool avx2_supported();
+
+  // Choose the kernels, eg to test each of them. The AVX2 ones are only used
+  // if the CPU supports them. Returns whether they are used
+  bool set_use_avx2(bool use_avx2)
+  {
+    m_use_avx2 = use_avx2 && avx2_supported();
+    return m_use_avx2;
+  }
+  bool get_use_avx2() const { return m_use_avx2; }
+
+private:
+  // Make the TA for the window made of the TPs in inputs, whose ADC sum is adc_integral
+  TriggerActivity construct_ta(std::vector<TriggerPrimitive> inputs,
+                               uint32_t adc_integral) const; // NOLINT(build/unsigned)
+
+  // The TPs currently in the window, in time order, and their ADC sum
+  std::vector<TriggerPrimitive> m_window;
+  uint32_t m_window_adc_integral = 0; // NOLINT(build/unsigned)
+
+  // Scratch space for process_batch, kept to avoid reallocating on each call
+  std::vector<timestamp_t> m_times;
+  std::vector<uint32_t> m_adc_prefix; // NOLINT(build/unsigned)
+  std::vector<TriggerPrimitive> m_next_window;
+
+  // Whether to use the AVX2 kernels. By default, whenever the CPU supports them
+  bool m_use_avx2;
+
+  // Configuration, with the same defaults as triggeralgs
+  timestamp_t m_window_length = 100000;
+  uint32_t m_adc_threshold = 1200000; // NOLINT(build/unsigned)
+};
+
+} // namespace dunedaq::trigger
+
+#endif // TRIGGER_SRC_TRIGGER_TRIGGERACTIVITYMAKERADCSIMPLEWINDOWBATCH_HPP_
@@ -10,9 +10,13 @@
 #define TRIGGER_SRC_TRIGGER_TRIGGERGENERICMAKER_HPP_
 
 #include "trigger/Issues.hpp"
+#include "trigger/LocalConnection.hpp"
 #include "trigger/Set.hpp"
+#include "trigger/SetBufferPool.hpp"
+#include "trigger/TPBatch.hpp"
 #include "trigger/TimeSliceInputBuffer.hpp"
 #include "trigger/TimeSliceOutputBuffer.hpp"
+#include "trigger/triggergenericmakerinfo/InfoNljs.hpp"
 
 #include "appfwk/DAQModule.hpp"
 #include "appfwk/DAQModuleHelper.hpp"
@@ -25,8 +29,11 @@
 #include "utilities/WorkerThread.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace dunedaq::trigger {
@@ -73,8 +80,26 @@ public:
 
   void init(const nlohmann::json& obj) override
   {
-    m_input_queue = get_iom_receiver<IN>(appfwk::connection_inst(obj, "input"));
-    m_output_queue = get_iom_sender<OUT>(appfwk::connection_inst(obj, "output"));
+    m_input_queue = get_input_connection<IN>(appfwk::connection_inst(obj, "input").uid);
+    m_output_queue = get_output_connection<OUT>(appfwk::connection_inst(obj, "output").uid);
+  }
+
+  void get_info(opmonlib::InfoCollector& ci, int /*level*/) override
+  {
+    triggergenericmakerinfo::Info i;
+
+    i.received_count = m_received_count.load();
+    i.sent_count = m_sent_count.load();
+    i.time_slice_reallocations = m_time_slice_reallocations.load();
+    // The TPSet buffer pool is shared by every module in the process, so these are process totals
+    if constexpr (std::is_same_v<IN, Set<triggeralgs::TriggerPrimitive>>) {
+      auto& pool = SetBufferPool<triggeralgs::TriggerPrimitive>::get();
+      i.process_set_buffers_reused = pool.get_reused_count();
+      i.process_set_buffers_new = pool.get_new_count();
+      i.process_set_allocations = pool.get_allocation_count();
+    }
+
+    ci.add(i);
   }
 
 protected:
@@ -97,13 +122,17 @@ protected:
 private:
   dunedaq::utilities::WorkerThread m_thread;
 
-  size_t m_received_count;
-  size_t m_sent_count;
+  using metric_counter_type = decltype(triggergenericmakerinfo::Info::received_count);
+  std::atomic<metric_counter_type> m_received_count{ 0 };
+  std::atomic<metric_counter_type> m_sent_count{ 0 };
+  // Number of times a worker's reused time slice vector had to grow
+  std::atomic<metric_counter_type> m_time_slice_reallocations{ 0 };
 
-  using source_t = dunedaq::iomanager::ReceiverConcept<IN>;
+  // iomanager connections, or local ones if the connection names say so
+  using source_t = InputConnection<IN>;
   std::shared_ptr<source_t> m_input_queue;
 
-  using sink_t = dunedaq::iomanager::SenderConcept<OUT>;
+  using sink_t = OutputConnection<OUT>;
   std::shared_ptr<sink_t> m_output_queue;
 
   std::chrono::milliseconds m_queue_timeout;
@@ -128,6 +157,7 @@ private:
   {
     m_received_count = 0;
     m_sent_count = 0;
+    m_time_slice_reallocations = 0;
     m_thread.start_working_thread(get_name());
   }
 
@@ -146,36 +176,34 @@ private:
     while (running_flag.load()) {
       // While there are items in the input queue, continue draining even if
       // the running_flag is false, but stop _immediately_ when input is empty
-      IN in;
-      while (receive(in)) {
-        worker.process(in);
+      while (std::optional<IN> in = receive()) {
+        worker.process(*in);
       }
     }
     worker.drain();
-    TLOG() << get_name() << ": Exiting do_work() method, received " << m_received_count << " inputs and successfully sent "
-           << m_sent_count << " outputs. ";
+    TLOG() << get_name() << ": Exiting do_work() method, received " << m_received_count.load()
+           << " inputs and successfully sent " << m_sent_count.load() << " outputs. Time slice vector grew "
+           << m_time_slice_reallocations.load() << " times.";
     worker.reset();
   }
 
-  bool receive(IN& in)
+  std::optional<IN> receive()
   {
-    try {
-      in = m_input_queue->receive(m_queue_timeout);
-    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
-      // it is perfectly reasonable that there might be no data in the queue
-      // some fraction of the times that we check, so we just continue on and try again
-      return false;
+    std::optional<IN> in = m_input_queue->try_receive(m_queue_timeout);
+    // it is perfectly reasonable that there might be no data in the queue
+    // some fraction of the times that we check, so an empty optional just
+    // means we continue on and try again
+    if (in.has_value()) {
+      ++m_received_count;
     }
-    ++m_received_count;
-    return true;
+    return in;
   }
 
   bool send(OUT&& out)
   {
-    try {
-      m_output_queue->send(std::move(out), m_queue_timeout);
-    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
-      ers::warning(excpt);
+    if (!m_output_queue->try_send(std::move(out), m_queue_timeout)) {
+      ers::warning(
+        dunedaq::iomanager::TimeoutExpired(ERS_HERE, get_name(), "push to output queue", m_queue_timeout.count()));
       return false;
     }
     ++m_sent_count;
@@ -230,6 +258,8 @@ public:
 
 // Partial specialization for IN = Set<A>, OUT = Set<B> and assumes the MAKER has:
 // operator()(A, std::vector<B>)
+// When A is TriggerPrimitive and the MAKER also implements TPBatchProcessor<B>,
+// each time slice is instead handed over as one column-oriented TPBatch
 template<class A, class B, class MAKER>
 class TriggerGenericWorker<Set<A>, Set<B>, MAKER>
 {
@@ -245,12 +275,24 @@ public: // NOLINT
   TimeSliceInputBuffer<A> m_in_buffer;
   TimeSliceOutputBuffer<B> m_out_buffer;
 
+  // Reused for every slice, so it only allocates when a slice is bigger than any before it
+  std::vector<A> m_time_slice;
+
   daqdataformats::timestamp_t m_prev_start_time = 0;
 
+  // Non-null if the maker can take whole TPBatches. Points into m_parent.m_maker
+  TPBatchProcessor<B>* m_batch_processor = nullptr;
+  TPBatch m_batch;
+
   void reconfigure()
   {
     m_out_buffer.set_window_time(m_parent.m_window_time);
     m_out_buffer.set_buffer_time(m_parent.m_buffer_time);
+    if constexpr (std::is_same_v<A, triggeralgs::TriggerPrimitive>) {
+      m_batch_processor = dynamic_cast<TPBatchProcessor<B>*>(m_parent.m_maker.get());
+      TLOG_DEBUG(2) << m_parent.get_name() << ": algorithm " << m_parent.m_algorithm_name
+                    << (m_batch_processor ? " takes" : " does not take") << " TP batches";
+    }
   }
 
   void reset()
@@ -259,9 +301,43 @@ public: // NOLINT
     m_out_buffer.reset();
   }
 
+  // Wrappers around m_in_buffer that fill m_time_slice, counting each time it has to grow
+  bool buffer_slice(Set<A>&& in, daqdataformats::timestamp_t& start_time, daqdataformats::timestamp_t& end_time)
+  {
+    m_time_slice.clear();
+    const size_t capacity = m_time_slice.capacity();
+    bool complete = m_in_buffer.buffer(std::move(in), m_time_slice, start_time, end_time);
+    if (m_time_slice.capacity() != capacity) {
+      ++m_parent.m_time_slice_reallocations;
+    }
+    return complete;
+  }
+
+  bool flush_slice(daqdataformats::timestamp_t& start_time, daqdataformats::timestamp_t& end_time)
+  {
+    m_time_slice.clear();
+    const size_t capacity = m_time_slice.capacity();
+    bool complete = m_in_buffer.flush(m_time_slice, start_time, end_time);
+    if (m_time_slice.capacity() != capacity) {
+      ++m_parent.m_time_slice_reallocations;
+    }
+    return complete;
+  }
+
   void process_slice(const std::vector<A>& time_slice, std::vector<B>& out_vec)
   {
     // time_slice is a full slice (all Set<A> combined), time ordered, vector of A
+    if constexpr (std::is_same_v<A, triggeralgs::TriggerPrimitive>) {
+      if (m_batch_processor) {
+        m_batch.assign(time_slice);
+        try {
+          m_batch_processor->process_batch(m_batch, out_vec);
+        } catch (...) { // NOLINT
+          ers::fatal(AlgorithmFatalError(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
+        }
+        return;
+      }
+    }
     // call operator for each of the objects in the vector
     for (const A& x : time_slice) {
       try {
@@ -283,12 +359,11 @@ public: // NOLINT
           ers::warning(OutOfOrderSets(ERS_HERE, m_parent.get_name(), m_prev_start_time, in.start_time));
         }
         m_prev_start_time = in.start_time;
-        std::vector<A> time_slice;
         daqdataformats::timestamp_t start_time, end_time;
-        if (!m_in_buffer.buffer(in, time_slice, start_time, end_time)) {
+        if (!buffer_slice(std::move(in), start_time, end_time)) {
           return; // no complete time slice yet (`in` was part of buffered slice)
         }
-        process_slice(time_slice, elems);
+        process_slice(m_time_slice, elems);
       } break;
       case Set<A>::Type::kHeartbeat: {
         // PAR 2022-04-27 We've got a heartbeat for time T, so we know
@@ -298,15 +373,15 @@ public: // NOLINT
         // heartbeat in the output buffer, which will handle it
         // appropriately
 
-        std::vector<A> time_slice;
         daqdataformats::timestamp_t start_time, end_time;
-        if (m_in_buffer.flush(time_slice, start_time, end_time)) {
+        if (flush_slice(start_time, end_time)) {
           if (end_time > in.start_time) {
             // This should never happen, but we check here so we at least get some output if it did
             ers::fatal(OutOfOrderSets(ERS_HERE, m_parent.get_name(), end_time, in.start_time));
           }
-          process_slice(time_slice, elems);
+          process_slice(m_time_slice, elems);
         }
+        SetBufferPool<A>::get().recycle(in);
 
         Set<B> heartbeat;
         heartbeat.type = Set<B>::Type::kHeartbeat;
@@ -373,11 +448,10 @@ public: // NOLINT
   {
     // First, send anything in the input buffer to the algorithm, and add any
     // results to output buffer
-    std::vector<A> time_slice;
     daqdataformats::timestamp_t start_time, end_time;
-    if (m_in_buffer.flush(time_slice, start_time, end_time)) {
+    if (flush_slice(start_time, end_time)) {
       std::vector<B> elems;
-      process_slice(time_slice, elems);
+      process_slice(m_time_slice, elems);
       if (elems.size() > 0) {
         m_out_buffer.buffer(elems);
       }
@@ -425,10 +499,36 @@ public: // NOLINT
 
   TimeSliceInputBuffer<A> m_in_buffer;
 
+  // Reused for every slice, so it only allocates when a slice is bigger than any before it
+  std::vector<A> m_time_slice;
+
   void reconfigure() {}
 
   void reset() {}
 
+  // Wrappers around m_in_buffer that fill m_time_slice, counting each time it has to grow
+  bool buffer_slice(Set<A>&& in, daqdataformats::timestamp_t& start_time, daqdataformats::timestamp_t& end_time)
+  {
+    m_time_slice.clear();
+    const size_t capacity = m_time_slice.capacity();
+    bool complete = m_in_buffer.buffer(std::move(in), m_time_slice, start_time, end_time);
+    if (m_time_slice.capacity() != capacity) {
+      ++m_parent.m_time_slice_reallocations;
+    }
+    return complete;
+  }
+
+  bool flush_slice(daqdataformats::timestamp_t& start_time, daqdataformats::timestamp_t& end_time)
+  {
+    m_time_slice.clear();
+    const size_t capacity = m_time_slice.capacity();
+    bool complete = m_in_buffer.flush(m_time_slice, start_time, end_time);
+    if (m_time_slice.capacity() != capacity) {
+      ++m_parent.m_time_slice_reallocations;
+    }
+    return complete;
+  }
+
   void process_slice(const std::vector<A>& time_slice, std::vector<OUT>& out_vec)
   {
     // time_slice is a full slice (all Set<A> combined), time ordered, vector of A
@@ -449,12 +549,11 @@ public: // NOLINT
     std::vector<OUT> out_vec; // either a whole time slice, heartbeat flushed, or empty
     switch (in.type) {
       case Set<A>::Type::kPayload: {
-        std::vector<A> time_slice;
         daqdataformats::timestamp_t start_time, end_time;
-        if (!m_in_buffer.buffer(in, time_slice, start_time, end_time)) {
+        if (!buffer_slice(std::move(in), start_time, end_time)) {
           return; // no complete time slice yet (`in` was part of buffered slice)
         }
-        process_slice(time_slice, out_vec);
+        process_slice(m_time_slice, out_vec);
       } break;
       case Set<A>::Type::kHeartbeat:
         // TODO BJL May-28-2021 should anything happen with the heartbeat when OUT is not a Set<T>?
@@ -464,15 +563,15 @@ public: // NOLINT
         // we can flush all items in the input buffer, which have
         // times t < T, because the input is time-ordered
         try {
-          std::vector<A> time_slice;
           daqdataformats::timestamp_t start_time, end_time;
-          if (m_in_buffer.flush(time_slice, start_time, end_time)) {
+          if (flush_slice(start_time, end_time)) {
             if (end_time > in.start_time) {
               // This should never happen, but we check here so we at least get some output if it did
               ers::fatal(OutOfOrderSets(ERS_HERE, m_parent.get_name(), end_time, in.start_time));
             }
-            process_slice(time_slice, out_vec);
+            process_slice(m_time_slice, out_vec);
           }
+          SetBufferPool<A>::get().recycle(in);
           m_parent.m_maker->flush(in.end_time, out_vec);
         } catch (...) { // NOLINT TODO Benjamin Land <BenLand100@github.com> May 28-2021 can we restrict the possible
                         // exceptions triggeralgs might raise?
@@ -498,11 +597,10 @@ public: // NOLINT
   {
     // Send anything in the input buffer to the algorithm, and put any results
     // on the output queue
-    std::vector<A> time_slice;
     daqdataformats::timestamp_t start_time, end_time;
-    if (m_in_buffer.flush(time_slice, start_time, end_time)) {
+    if (flush_slice(start_time, end_time)) {
       std::vector<OUT> out_vec;
-      process_slice(time_slice, out_vec);
+      process_slice(m_time_slice, out_vec);
       while (out_vec.size()) {
         if (!m_parent.send(std::move(out_vec.back()))) {
           ers::error(AlgorithmFailedToSend(ERS_HERE, m_parent.get_name(), m_parent.m_algorithm_name));
@@ -0,0 +1,108 @@
+/**
+ * @file convert_TPs_to_binary.cxx Convert TPs from a text file or an HDF5 file
+ * to the binary format that TriggerPrimitiveMaker can memory-map
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#include "CLI/CLI.hpp"
+
+#include "trigger/TPBinaryFile.hpp"
+#include "trigger/TPSetSource.hpp"
+
+#include "detdataformats/trigger/TriggerPrimitive.hpp"
+#include "hdf5libs/HDF5RawDataFile.hpp"
+
+#include <daqdataformats/FragmentHeader.hpp>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using dunedaq::detdataformats::trigger::TriggerPrimitive;
+
+using TPHandler = std::function<void(const TriggerPrimitive*, size_t)>;
+
+// Pass all the TPs in the fragments of an HDF5 file to handle_tps, a fragment at a time, in the order they are stored
+void
+read_hdf5(const std::string& filename, const TPHandler& handle_tps)
+{
+  dunedaq::hdf5libs::HDF5RawDataFile hdf5file(filename);
+  for (auto fragment_path : hdf5file.get_all_fragment_dataset_paths()) {
+    auto frag = hdf5file.get_frag_ptr(fragment_path);
+    size_t payload_size = frag->get_size() - sizeof(dunedaq::daqdataformats::FragmentHeader);
+    if (payload_size % sizeof(TriggerPrimitive) != 0) {
+      std::cerr << "Skipping fragment " << fragment_path << " whose size isn't a whole number of TPs" << std::endl;
+      continue;
+    }
+    const TriggerPrimitive* prim = reinterpret_cast<TriggerPrimitive*>(frag->get_data());
+    handle_tps(prim, payload_size / sizeof(TriggerPrimitive));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  CLI::App app{ "Convert TPs from a text or HDF5 file to the binary format read by TriggerPrimitiveMaker" };
+
+  std::string in_filename;
+  app.add_option("-i,--input", in_filename, "Input file")->required();
+
+  std::string out_filename;
+  app.add_option("-o,--output", out_filename, "Output binary file")->required();
+
+  std::string input_format = "text";
+  app.add_option("-f,--input-format", input_format, "Format of the input file: text or hdf5", true);
+
+  bool sort = false;
+  app.add_flag("-s,--sort", sort, "Sort the TPs by time_start. TriggerPrimitiveMaker skips out-of-order TPs");
+
+  CLI11_PARSE(app, argc, argv);
+
+  if (input_format != "text" && input_format != "hdf5") {
+    std::cerr << "Unknown input format " << input_format << std::endl;
+    return 1;
+  }
+  std::ifstream fin;
+  if (input_format == "text") {
+    fin.open(in_filename);
+    if (!fin) {
+      std::cerr << "Can't open " << in_filename << std::endl;
+      return 1;
+    }
+  }
+
+  // Only sorting needs all the TPs in memory at once. Otherwise they go
+  // straight to the output, so files of any size can be converted
+  dunedaq::trigger::TPBinaryFileWriter writer(out_filename);
+  std::vector<TriggerPrimitive> tps_to_sort;
+  TPHandler handle_tps = [&](const TriggerPrimitive* tps, size_t n_tps) {
+    if (sort) {
+      tps_to_sort.insert(tps_to_sort.end(), tps, tps + n_tps);
+    } else {
+      writer.write(tps, n_tps);
+    }
+  };
+
+  if (input_format == "text") {
+    TriggerPrimitive tp;
+    while (dunedaq::trigger::read_text_tp(fin, tp)) {
+      handle_tps(&tp, 1);
+    }
+  } else {
+    read_hdf5(in_filename, handle_tps);
+  }
+
+  if (sort) {
+    std::stable_sort(tps_to_sort.begin(), tps_to_sort.end(), [](const TriggerPrimitive& a, const TriggerPrimitive& b) {
+      return a.time_start < b.time_start;
+    });
+    writer.write(tps_to_sort.data(), tps_to_sort.size());
+  }
+  writer.close();
+  std::cout << "Wrote " << writer.get_n_tps() << " TPs to " << out_filename << std::endl;
+  return 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file receive_loop_benchmark.cxx Compare idle CPU use and wakeup latency of
+ * a receive loop that detects an empty queue by catching TimeoutExpired with
+ * one that uses try_receive
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "CLI/CLI.hpp"
+
+#include "trigger/TPSet.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "iomanager/Receiver.hpp"
+#include "iomanager/Sender.hpp"
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+
+// CPU time used by the calling thread, in nanoseconds
+inline int64_t
+thread_cpu_ns()
+{
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+inline int64_t
+steady_ns()
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct LoopResult
+{
+  double idle_cpu_fraction{ 0 };
+  std::vector<int64_t> latencies_ns;
+};
+
+// Run the consumer side of the benchmark. The producer stamps each TPSet's
+// seqno with its steady-clock send time, so the consumer can compute the
+// wakeup latency on receipt. Before the first TPSet arrives the queue is
+// idle for idle_time, which is what we measure the CPU use over
+LoopResult
+run_consumer(std::shared_ptr<iomanager::ReceiverConcept<trigger::TPSet>> receiver,
+             bool use_exceptions,
+             std::chrono::milliseconds timeout,
+             std::chrono::milliseconds idle_time,
+             int n_messages)
+{
+  LoopResult result;
+  result.latencies_ns.reserve(n_messages);
+
+  const int64_t idle_end = steady_ns() + std::chrono::nanoseconds(idle_time).count();
+  int64_t idle_cpu_start = thread_cpu_ns();
+  int64_t idle_wall_start = steady_ns();
+  bool idle = true;
+
+  while (static_cast<int>(result.latencies_ns.size()) < n_messages) {
+    std::optional<trigger::TPSet> tpset;
+    if (use_exceptions) {
+      try {
+        tpset = receiver->receive(timeout);
+      } catch (const iomanager::TimeoutExpired&) {
+        // empty queue: try again
+      }
+    } else {
+      tpset = receiver->try_receive(timeout);
+    }
+
+    if (idle && steady_ns() >= idle_end) {
+      result.idle_cpu_fraction = static_cast<double>(thread_cpu_ns() - idle_cpu_start) / (steady_ns() - idle_wall_start);
+      idle = false;
+    }
+
+    if (tpset.has_value()) {
+      result.latencies_ns.push_back(steady_ns() - static_cast<int64_t>(tpset->seqno));
+    }
+  }
+  return result;
+}
+
+int64_t
+percentile(std::vector<int64_t> v, double p)
+{
+  if (v.empty()) {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  size_t i = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+  return v[i];
+}
+
+int
+main(int argc, char** argv)
+{
+  CLI::App app{ "Compare exception-based and try_receive-based receive loops" };
+
+  int timeout_ms = 10;
+  app.add_option("-t,--timeout-ms", timeout_ms, "Receive timeout in the consumer loop", true);
+
+  int idle_ms = 2000;
+  app.add_option("-i,--idle-ms", idle_ms, "Time the consumer spends polling an empty queue", true);
+
+  int n_messages = 200;
+  app.add_option("-n,--n-messages", n_messages, "Number of TPSets to send for the latency measurement", true);
+
+  int interval_ms = 20;
+  app.add_option("-s,--send-interval-ms", interval_ms, "Time between TPSets sent by the producer", true);
+
+  CLI11_PARSE(app, argc, argv);
+
+  iomanager::ConnectionIds_t connections;
+  connections.emplace_back(
+    iomanager::ConnectionId{ "bench_queue", iomanager::ServiceType::kQueue, "trigger::TPSet", "queue://StdDeQueue:1000" });
+  iomanager::IOManager::get()->configure(connections);
+
+  auto sender = dunedaq::get_iom_sender<trigger::TPSet>("bench_queue");
+  auto receiver = dunedaq::get_iom_receiver<trigger::TPSet>("bench_queue");
+
+  for (bool use_exceptions : { true, false }) {
+    LoopResult result;
+    std::thread consumer([&]() {
+      result = run_consumer(receiver,
+                            use_exceptions,
+                            std::chrono::milliseconds(timeout_ms),
+                            std::chrono::milliseconds(idle_ms),
+                            n_messages);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(idle_ms));
+    for (int i = 0; i < n_messages; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+      trigger::TPSet tpset;
+      tpset.seqno = steady_ns();
+      sender->send(std::move(tpset), std::chrono::milliseconds(100));
+    }
+    consumer.join();
+
+    TLOG() << (use_exceptions ? "receive() + catch TimeoutExpired" : "try_receive()") << ": idle CPU "
+           << 100 * result.idle_cpu_fraction << "%, wakeup latency p50 "
+           << 1e-3 * percentile(result.latencies_ns, 0.5) << " us, p99 " << 1e-3 * percentile(result.latencies_ns, 0.99)
+           << " us, max " << 1e-3 * percentile(result.latencies_ns, 1.0) << " us";
+  }
+
+  iomanager::IOManager::get()->reset();
+}
@@ -1,23 +1,39 @@
 /**
- * @file set_serialization_speed.cxx Test the amount of time it takes to serialize a TASet
+ * @file set_serialization_speed.cxx Measure how fast TPSets, TASets and
+ * TCSets serialize and deserialize, and how big they are on the wire
  *
  * This is part of the DUNE DAQ Application Framework, copyright 2020.
  * Licensing/copyright details are in the COPYING file that you should have
  * received with this code.
  */
 
+#include "CLI/CLI.hpp"
+
 #include "logging/Logging.hpp"
 #include "serialization/Serialization.hpp"
 #include "trigger/TASet.hpp"
+#include "trigger/TCSet.hpp"
 #include "trigger/TPSet.hpp"
+#include "trigger/TPSetWireFormat.hpp"
 #include "triggeralgs/TriggerPrimitive.hpp"
 #include "detdataformats/trigger/Types.hpp"
 
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+using namespace dunedaq;
+
 // Return the current steady clock in microseconds
 inline uint64_t // NOLINT(build/unsigned)
 now_us()
@@ -27,67 +43,273 @@ now_us()
   return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
-void
-time_serialization(int tps_per_set)
+struct Options
 {
-  const int N = 100000;
-  int total = 0;
+  size_t n_sets = 100000;
+  size_t inputs_per_object = 10;
+  // Fewer sets are made when they're big, so that each measurement holds at
+  // most this many TPs (each TA or TC counting as one plus its inputs)
+  size_t max_tps = 2000000;
+};
 
-  std::default_random_engine generator;
+// Fill one object of each type with plausible values around time
+void
+fill_object(triggeralgs::TriggerPrimitive& tp, std::default_random_engine& gen, triggeralgs::timestamp_t time, size_t)
+{
   std::uniform_int_distribution<int> uniform(0, 1000);
+  tp.time_start = time;
+  tp.time_peak = time + uniform(gen) / 10;
+  tp.time_over_threshold = uniform(gen);
+  tp.channel = uniform(gen);
+  tp.adc_integral = uniform(gen);
+  tp.adc_peak = uniform(gen);
+  tp.detid = 1;
+  tp.type = triggeralgs::TriggerPrimitive::Type::kTPC;
+  tp.algorithm = triggeralgs::TriggerPrimitive::Algorithm::kTPCDefault;
+  tp.flag = 1;
+}
 
-  std::vector<dunedaq::trigger::TPSet> sets;
-  for (int i = 0; i < N; ++i) {
-    dunedaq::trigger::TPSet set;
+void
+fill_object(triggeralgs::TriggerActivity& ta,
+            std::default_random_engine& gen,
+            triggeralgs::timestamp_t time,
+            size_t inputs_per_object)
+{
+  ta.inputs.resize(inputs_per_object);
+  for (size_t i = 0; i < inputs_per_object; ++i) {
+    fill_object(ta.inputs[i], gen, time + i, 0);
+  }
+  ta.time_start = time;
+  ta.time_end = time + inputs_per_object;
+  ta.time_peak = time;
+  ta.time_activity = time;
+  ta.channel_start = 0;
+  ta.channel_end = 1000;
+  ta.channel_peak = 500;
+  ta.adc_integral = 10000;
+  ta.adc_peak = 1000;
+  ta.detid = 1;
+  ta.type = triggeralgs::TriggerActivity::Type::kTPC;
+  ta.algorithm = triggeralgs::TriggerActivity::Algorithm::kADCSimpleWindow;
+}
+
+void
+fill_object(triggeralgs::TriggerCandidate& tc,
+            std::default_random_engine& gen,
+            triggeralgs::timestamp_t time,
+            size_t inputs_per_object)
+{
+  tc.inputs.resize(inputs_per_object);
+  for (size_t i = 0; i < inputs_per_object; ++i) {
+    // The TAs inside a TC don't carry their TPs, so this only fills the TriggerActivityData part
+    triggeralgs::TriggerActivity ta;
+    fill_object(ta, gen, time + i, 0);
+    tc.inputs[i] = ta;
+  }
+  tc.time_start = time;
+  tc.time_end = time + inputs_per_object;
+  tc.time_candidate = time;
+  tc.detid = 1;
+  tc.type = triggeralgs::TriggerCandidate::Type::kADCSimpleWindow;
+  tc.algorithm = triggeralgs::TriggerCandidate::Algorithm::kADCSimpleWindow;
+}
+
+// How many sets of objects_per_set objects to make: n_sets, or fewer if that would be more than max_tps TPs
+template<class SET>
+size_t
+get_n_sets(const Options& opts, size_t objects_per_set)
+{
+  const size_t tps_per_object = std::is_same_v<SET, trigger::TPSet> ? 1 : 1 + opts.inputs_per_object;
+  const size_t tps_per_set = objects_per_set * tps_per_object;
+  if (tps_per_set == 0) {
+    return opts.n_sets;
+  }
+  return std::max<size_t>(1, std::min(opts.n_sets, opts.max_tps / tps_per_set));
+}
+
+template<class SET>
+std::vector<SET>
+make_sets(const Options& opts, size_t objects_per_set)
+{
+  std::default_random_engine gen;
+  const size_t n_sets = get_n_sets<SET>(opts, objects_per_set);
+  std::vector<SET> sets(n_sets);
+  for (size_t i = 0; i < n_sets; ++i) {
+    SET& set = sets[i];
     set.seqno = i + 1;
+    set.type = SET::Type::kPayload;
     set.start_time = (i + 1) * 5000;
     set.end_time = (i + 2) * 5000 - 1;
-    for (int j = 0; j < tps_per_set; ++j) {
-      triggeralgs::TriggerPrimitive tp;
-      tp.time_start = 1234963454;
-      tp.time_peak = tp.time_start + 10000;
-      tp.time_over_threshold = uniform(generator);
-      tp.channel = uniform(generator);
-      tp.adc_integral = uniform(generator);
-      tp.adc_peak = uniform(generator);
-      tp.detid = 1;
-      tp.type = triggeralgs::TriggerPrimitive::Type::kUnknown;
-      tp.algorithm = triggeralgs::TriggerPrimitive::Algorithm::kTPCDefault;
-      tp.flag = 1;
-
-      set.objects.push_back(tp);
+    set.objects.resize(objects_per_set);
+    for (size_t j = 0; j < objects_per_set; ++j) {
+      fill_object(set.objects[j], gen, set.start_time + j * 5000 / (objects_per_set + 1), opts.inputs_per_object);
     }
-    sets.push_back(set);
   }
+  return sets;
+}
 
+// Run func(i) for every i in [0, n) split over n_threads threads, and return the wall time in seconds
+template<class FUNC>
+double
+time_parallel(size_t n, size_t n_threads, FUNC func)
+{
+  std::vector<std::thread> threads;
+  // The TPSet wire format is per thread, so give the workers this thread's
+  const trigger::TPSetWireFormat format = trigger::get_tpset_wire_format();
   uint64_t start_time = now_us(); // NOLINT(build/unsigned)
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back([=, &func]() {
+      trigger::set_tpset_wire_format(format);
+      for (size_t i = t; i < n; i += n_threads) {
+        func(i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return 1e-6 * (now_us() - start_time);
+}
 
-  for (int i = 0; i < N; ++i) {
-    // NOLINTNEXTLINE(build/unsigned)
-    std::vector<uint8_t> bytes = dunedaq::serialization::serialize(sets[i], dunedaq::serialization::kMsgPack);
-    dunedaq::trigger::TPSet set_recv = dunedaq::serialization::deserialize<dunedaq::trigger::TPSet>(bytes);
-    total += set_recv.seqno;
+template<class SET>
+nlohmann::json
+run_benchmark(const std::vector<SET>& sets, const std::string& mode, size_t n_threads)
+{
+  const size_t n = sets.size();
+  std::vector<std::vector<uint8_t>> encoded(n); // NOLINT(build/unsigned)
+  double seconds = 0;
+
+  if (mode == "serialize" || mode == "roundtrip") {
+    seconds += time_parallel(
+      n, n_threads, [&](size_t i) { encoded[i] = serialization::serialize(sets[i], serialization::kMsgPack); });
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      encoded[i] = serialization::serialize(sets[i], serialization::kMsgPack);
+    }
+  }
+
+  if (mode == "deserialize" || mode == "roundtrip") {
+    std::vector<size_t> n_received(n_threads, 0);
+    seconds += time_parallel(n, n_threads, [&](size_t i) {
+      SET set = serialization::deserialize<SET>(encoded[i]);
+      n_received[i % n_threads] += set.objects.size();
+    });
+  }
+
+  size_t total_bytes = 0;
+  size_t total_objects = 0;
+  for (size_t i = 0; i < n; ++i) {
+    total_bytes += encoded[i].size();
+    total_objects += sets[i].objects.size();
   }
-  uint64_t end_time = now_us(); // NOLINT(build/unsigned)
 
-  double time_taken_s = 1e-6 * (end_time - start_time);
-  double msg_kHz = 1e-3 * N / time_taken_s;
-  double tp_kHz = 1e-3 * tps_per_set * N / time_taken_s;
-  TLOG() << "Sent " << N << " messages in " << time_taken_s << " (" << msg_kHz << " kHz of msgs, " << tp_kHz
-         << " kHz of TPs) " << total;
+  nlohmann::json result;
+  result["mode"] = mode;
+  result["threads"] = n_threads;
+  result["n_sets"] = n;
+  result["objects_per_set"] = n ? total_objects / n : 0;
+  result["seconds"] = seconds;
+  result["sets_per_second"] = n / seconds;
+  result["objects_per_second"] = total_objects / seconds;
+  result["bytes_per_set"] = n ? static_cast<double>(total_bytes) / n : 0.;
+  result["bytes_per_object"] = total_objects ? static_cast<double>(total_bytes) / total_objects : 0.;
+  return result;
+}
+
+template<class SET>
+void
+run_set_type(const std::string& set_type,
+             const std::string& format,
+             const Options& opts,
+             const std::vector<size_t>& sizes,
+             const std::vector<std::string>& modes,
+             const std::vector<size_t>& thread_counts,
+             nlohmann::json& results)
+{
+  for (size_t size : sizes) {
+    std::vector<SET> sets = make_sets<SET>(opts, size);
+    for (const std::string& mode : modes) {
+      for (size_t n_threads : thread_counts) {
+        nlohmann::json result = run_benchmark(sets, mode, n_threads);
+        result["set_type"] = set_type;
+        result["format"] = format;
+        TLOG() << set_type << " " << format << " " << mode << ", " << size << " objects per set, " << n_threads
+               << " threads: " << 1e-3 * result["sets_per_second"].get<double>() << " kHz of sets, "
+               << 1e-3 * result["objects_per_second"].get<double>() << " kHz of objects, "
+               << result["bytes_per_set"].get<double>() << " bytes per set";
+        results.push_back(result);
+      }
+    }
+  }
 }
 
 int
-main()
+main(int argc, char** argv)
 {
-  std::vector<int> n_tps{ 0, 1, 10, 100, 1000 };
-  for (auto n : n_tps) {
-    TLOG() << n << " TPs per set: " << std::flush;
-    time_serialization(n);
+  CLI::App app{ "Benchmark serialization of TPSets, TASets and TCSets" };
+
+  Options opts;
+  app.add_option("-n,--n-sets", opts.n_sets, "Number of sets to process in each measurement", true);
+  app.add_option("--max-tps",
+                 opts.max_tps,
+                 "Make fewer sets if they would hold more than this many TPs, counting TAs and TCs as one plus their inputs",
+                 true);
+  app.add_option("--inputs-per-object", opts.inputs_per_object, "Number of TPs per TA and TAs per TC", true);
+
+  std::vector<std::string> set_types{ "tp", "ta", "tc" };
+  app.add_option("-t,--set-types", set_types, "Set types to measure: tp, ta, tc", true);
+
+  std::vector<size_t> sizes{ 0, 1, 10, 100, 1000 };
+  app.add_option("-s,--sizes", sizes, "Numbers of objects per set", true);
+
+  std::vector<std::string> modes{ "serialize", "deserialize", "roundtrip" };
+  app.add_option("-m,--modes", modes, "What to time: serialize, deserialize, roundtrip", true);
+
+  std::vector<size_t> thread_counts{ 1 };
+  app.add_option("-j,--threads", thread_counts, "Numbers of threads to run each measurement with", true);
+
+  std::vector<std::string> tpset_formats{ "msgpack", "binary", "compressed" };
+  app.add_option("-f,--tpset-formats", tpset_formats, "TPSet wire formats: msgpack, binary, compressed", true);
+
+  std::string json_file;
+  app.add_option("-o,--json", json_file, "Write the results as JSON to this file, or - for stdout");
+
+  CLI11_PARSE(app, argc, argv);
+
+  nlohmann::json results = nlohmann::json::array();
+
+  const std::map<std::string, trigger::TPSetWireFormat> wire_formats{
+    { "msgpack", trigger::TPSetWireFormat::kMsgPack },
+    { "binary", trigger::TPSetWireFormat::kBinary },
+    { "compressed", trigger::TPSetWireFormat::kCompressed },
+  };
+
+  for (const std::string& set_type : set_types) {
+    if (set_type == "tp") {
+      for (const std::string& format : tpset_formats) {
+        auto it = wire_formats.find(format);
+        if (it == wire_formats.end()) {
+          TLOG() << "Unknown TPSet format " << format;
+          return 1;
+        }
+        trigger::set_tpset_wire_format(it->second);
+        run_set_type<trigger::TPSet>("TPSet", format, opts, sizes, modes, thread_counts, results);
+      }
+      trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kMsgPack);
+    } else if (set_type == "ta") {
+      run_set_type<trigger::TASet>("TASet", "msgpack", opts, sizes, modes, thread_counts, results);
+    } else if (set_type == "tc") {
+      run_set_type<trigger::TCSet>("TCSet", "msgpack", opts, sizes, modes, thread_counts, results);
+    } else {
+      TLOG() << "Unknown set type " << set_type;
+      return 1;
+    }
   }
 
-  dunedaq::trigger::TASet taset;
-  // NOLINTNEXTLINE(build/unsigned)
-  std::vector<uint8_t> bytes = dunedaq::serialization::serialize(taset, dunedaq::serialization::kMsgPack);
-  dunedaq::trigger::TASet set_recv = dunedaq::serialization::deserialize<dunedaq::trigger::TASet>(bytes);
+  if (json_file == "-") {
+    std::cout << results.dump(2) << std::endl;
+  } else if (!json_file.empty()) {
+    std::ofstream out(json_file);
+    out << results.dump(2) << std::endl;
+  }
 }
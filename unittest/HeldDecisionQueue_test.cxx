@@ -0,0 +1,131 @@
+/**
+ * @file HeldDecisionQueue_test.cxx  HeldDecisionQueue Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/HeldDecisionQueue.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE HeldDecisionQueue_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <map>
+
+using namespace dunedaq::trigger;
+using triggeralgs::TriggerCandidate;
+using Type = TriggerCandidate::Type;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+const HeldDecisionQueue::clock_type::time_point s_t0{};
+
+TCGroup
+make_group(Type type, triggeralgs::timestamp_t time)
+{
+  TriggerCandidate tc;
+  tc.type = type;
+  tc.time_start = time;
+  tc.time_end = time + 100;
+  tc.time_candidate = time;
+  TCGroup group;
+  group.add(std::move(tc));
+  return group;
+}
+
+// Timing is most important, then supernova bursts. Randoms are never held
+HeldDecisionQueue
+make_queue(size_t depth)
+{
+  std::map<HeldDecisionQueue::type_t, int> priorities{
+    { static_cast<HeldDecisionQueue::type_t>(Type::kTiming), 2 },
+    { static_cast<HeldDecisionQueue::type_t>(Type::kSupernova), 1 },
+  };
+  return HeldDecisionQueue(depth, 100ms, priorities);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(DisabledByDefault)
+{
+  HeldDecisionQueue queue;
+  BOOST_CHECK(queue.hold(make_group(Type::kTiming, 1000), s_t0) == HeldDecisionQueue::Result::kNotHeld);
+  BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Priorities)
+{
+  HeldDecisionQueue queue = make_queue(10);
+  BOOST_CHECK_EQUAL(queue.get_priority(make_group(Type::kRandom, 1000)), 0);
+  BOOST_CHECK_EQUAL(queue.get_priority(make_group(Type::kSupernova, 1000)), 1);
+
+  // A group takes the highest priority of its TCs
+  TCGroup group = make_group(Type::kSupernova, 1000);
+  TriggerCandidate timing = make_group(Type::kTiming, 1050).tcs.front();
+  group.add(std::move(timing));
+  BOOST_CHECK_EQUAL(queue.get_priority(group), 2);
+
+  BOOST_CHECK(queue.hold(make_group(Type::kRandom, 1000), s_t0) == HeldDecisionQueue::Result::kNotHeld);
+  BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(ReleaseOrder)
+{
+  HeldDecisionQueue queue = make_queue(10);
+  BOOST_CHECK(queue.hold(make_group(Type::kSupernova, 1000), s_t0) == HeldDecisionQueue::Result::kHeld);
+  BOOST_CHECK(queue.hold(make_group(Type::kTiming, 2000), s_t0 + 1ms) == HeldDecisionQueue::Result::kHeld);
+  BOOST_CHECK(queue.hold(make_group(Type::kSupernova, 3000), s_t0 + 2ms) == HeldDecisionQueue::Result::kHeld);
+  BOOST_CHECK(queue.hold(make_group(Type::kTiming, 4000), s_t0 + 3ms) == HeldDecisionQueue::Result::kHeld);
+  BOOST_CHECK_EQUAL(queue.size(), 4);
+
+  TCGroup group;
+  for (triggeralgs::timestamp_t expected : { 2000, 4000, 1000, 3000 }) {
+    BOOST_REQUIRE(queue.release(group));
+    BOOST_CHECK_EQUAL(group.time_candidate, expected);
+  }
+  BOOST_CHECK(!queue.release(group));
+}
+
+BOOST_AUTO_TEST_CASE(FullQueue)
+{
+  HeldDecisionQueue queue = make_queue(2);
+  BOOST_CHECK(queue.hold(make_group(Type::kSupernova, 1000), s_t0) == HeldDecisionQueue::Result::kHeld);
+  BOOST_CHECK(queue.hold(make_group(Type::kSupernova, 2000), s_t0 + 1ms) == HeldDecisionQueue::Result::kHeld);
+  // No room, and nothing with a lower priority to make room
+  BOOST_CHECK(queue.hold(make_group(Type::kSupernova, 3000), s_t0 + 2ms) == HeldDecisionQueue::Result::kNotHeld);
+  // Replaces the newest supernova group
+  BOOST_CHECK(queue.hold(make_group(Type::kTiming, 4000), s_t0 + 3ms) ==
+              HeldDecisionQueue::Result::kHeldReplacing);
+  BOOST_CHECK_EQUAL(queue.size(), 2);
+
+  TCGroup group;
+  BOOST_REQUIRE(queue.release(group));
+  BOOST_CHECK_EQUAL(group.time_candidate, 4000);
+  BOOST_REQUIRE(queue.release(group));
+  BOOST_CHECK_EQUAL(group.time_candidate, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(MaxAge)
+{
+  HeldDecisionQueue queue = make_queue(10);
+  queue.hold(make_group(Type::kTiming, 1000), s_t0);
+  queue.hold(make_group(Type::kTiming, 2000), s_t0 + 50ms);
+  BOOST_CHECK_EQUAL(queue.drop_expired(s_t0 + 100ms), 0);
+  BOOST_CHECK_EQUAL(queue.drop_expired(s_t0 + 101ms), 1);
+  BOOST_CHECK_EQUAL(queue.size(), 1);
+
+  TCGroup group;
+  BOOST_REQUIRE(queue.release(group));
+  BOOST_CHECK_EQUAL(group.time_candidate, 2000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
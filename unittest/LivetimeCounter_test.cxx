@@ -0,0 +1,251 @@
+/**
+ * @file LivetimeCounter_test.cxx  LivetimeCounter Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/LivetimeCounter.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE LivetimeCounter_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::trigger;
+using State = LivetimeCounter::State;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+uint64_t
+total_ns(const LivetimeCounter& counter)
+{
+  return counter.get_time_ns(State::kLive) + counter.get_time_ns(State::kDead) +
+         counter.get_time_ns(State::kPaused);
+}
+
+// What LivetimeCounter used to do, for comparison: a mutex, and a map updated on every read
+class MutexLivetimeCounter
+{
+public:
+  explicit MutexLivetimeCounter(State state)
+    : m_state(state)
+    , m_last_state_change_time(now())
+  {}
+
+  void set_state(State state)
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    update_map();
+    m_state = state;
+  }
+
+  uint64_t get_time(State state)
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    update_map();
+    return m_state_times[state];
+  }
+
+private:
+  static uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  void update_map()
+  {
+    auto const current_time = now();
+    m_state_times[m_state] += current_time - m_last_state_change_time;
+    m_last_state_change_time = current_time;
+  }
+
+  std::mutex m_mutex;
+  State m_state;
+  std::map<State, uint64_t> m_state_times;
+  uint64_t m_last_state_change_time;
+};
+
+// Read the counter from n_readers threads while another changes its state
+// as fast as it can, for a fixed time. Returns the reads and state changes
+// per second
+template<class Counter>
+std::pair<double, double>
+run_contention(Counter& counter, size_t n_readers)
+{
+  std::atomic<bool> stop{ false };
+  std::atomic<uint64_t> n_reads{ 0 };
+  uint64_t n_changes = 0;
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < n_readers; ++i) {
+    readers.emplace_back([&]() {
+      uint64_t reads = 0;
+      uint64_t sum = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        sum += counter.get_time(State::kLive);
+        ++reads;
+      }
+      n_reads += reads + (sum == 1 ? 1 : 0); // Use sum so the reads aren't optimized away
+    });
+  }
+  auto const duration = 200ms;
+  auto const start = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() - start < duration) {
+    counter.set_state(n_changes % 2 == 0 ? State::kDead : State::kLive);
+    ++n_changes;
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  double const seconds = std::chrono::duration<double>(duration).count();
+  return { n_reads.load() / seconds, n_changes / seconds };
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Basics)
+{
+  LivetimeCounter counter(State::kPaused);
+  BOOST_CHECK(counter.get_state() == State::kPaused);
+  std::this_thread::sleep_for(20ms);
+  counter.set_state(State::kLive);
+  BOOST_CHECK(counter.get_state() == State::kLive);
+  std::this_thread::sleep_for(10ms);
+
+  BOOST_CHECK_GE(counter.get_time(State::kPaused), 20);
+  BOOST_CHECK_GE(counter.get_time(State::kLive), 10);
+  BOOST_CHECK_EQUAL(counter.get_time(State::kDead), 0);
+
+  // Time in the current state keeps counting without state changes
+  auto const live = counter.get_time_ns(State::kLive);
+  std::this_thread::sleep_for(5ms);
+  BOOST_CHECK_GE(counter.get_time_ns(State::kLive), live + 5'000'000);
+
+  auto const times = counter.get_time_map();
+  BOOST_CHECK_EQUAL(times.size(), 3);
+  BOOST_CHECK_EQUAL(times.at(State::kPaused), counter.get_time(State::kPaused));
+}
+
+BOOST_AUTO_TEST_CASE(SubMillisecondResolution)
+{
+  LivetimeCounter counter(State::kLive);
+  // Many inhibits much shorter than a millisecond still add up
+  for (int i = 0; i < 100; ++i) {
+    counter.set_state(State::kDead);
+    auto const start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < 50us) {
+    }
+    counter.set_state(State::kLive);
+  }
+  BOOST_CHECK_GE(counter.get_time_ns(State::kDead), 100 * 50'000);
+  BOOST_CHECK_GE(counter.get_time(State::kDead), 5);
+}
+
+BOOST_AUTO_TEST_CASE(Episodes)
+{
+  LivetimeCounter counter(State::kLive);
+  // Three short dead episodes and a long one
+  for (auto length : { 1ms, 1ms, 1ms, 20ms }) {
+    counter.set_state(State::kDead);
+    std::this_thread::sleep_for(length);
+    counter.set_state(State::kLive);
+  }
+  // Not a change of state, so not a new episode
+  counter.set_state(State::kLive);
+
+  const LogHistogram& dead = counter.get_episode_histogram(State::kDead);
+  BOOST_CHECK_EQUAL(dead.get_count(), 4);
+  BOOST_CHECK_GE(dead.get_max(), 20000);
+  BOOST_CHECK_GE(dead.get_quantile(0.5), 1000);
+  BOOST_CHECK_LT(dead.get_quantile(0.5), dead.get_max());
+
+  // The live episodes before each dead one have ended. The current one hasn't
+  BOOST_CHECK_EQUAL(counter.get_episode_histogram(State::kLive).get_count(), 4);
+  BOOST_CHECK_EQUAL(counter.get_episode_histogram(State::kPaused).get_count(), 0);
+
+  // The episodes add up to the time in the state
+  BOOST_CHECK_LE(dead.get_sum(), counter.get_time_ns(State::kDead) / 1000);
+  BOOST_CHECK_GE(dead.get_sum() + 4, counter.get_time_ns(State::kDead) / 1000);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentWriters)
+{
+  LivetimeCounter counter(State::kLive);
+  auto const start = std::chrono::steady_clock::now();
+  std::vector<std::thread> writers;
+  for (State state : { State::kLive, State::kDead, State::kPaused }) {
+    writers.emplace_back([&counter, state]() {
+      for (int i = 0; i < 20000; ++i) {
+        counter.set_state(state);
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  // No time is lost or counted twice, however the changes interleave
+  uint64_t const total = total_ns(counter);
+  uint64_t const elapsed =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  BOOST_CHECK_LE(total, elapsed + 1'000'000);
+  BOOST_CHECK_GE(total + 1'000'000, elapsed);
+}
+
+BOOST_AUTO_TEST_CASE(ReadsAreConsistent)
+{
+  LivetimeCounter counter(State::kLive);
+  std::atomic<bool> stop{ false };
+  std::thread writer([&]() {
+    int i = 0;
+    while (!stop.load()) {
+      counter.set_state(++i % 2 == 0 ? State::kDead : State::kLive);
+    }
+  });
+  // The times never go backwards
+  uint64_t last_total = 0;
+  uint64_t last_dead = 0;
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t const dead = counter.get_time_ns(State::kDead);
+    BOOST_REQUIRE_GE(dead, last_dead);
+    last_dead = dead;
+    uint64_t const total = total_ns(counter);
+    BOOST_REQUIRE_GE(total, last_total);
+    last_total = total;
+  }
+  stop = true;
+  writer.join();
+}
+
+BOOST_AUTO_TEST_CASE(ContentionBenchmark)
+{
+  // Not a pass/fail test: shows how readers and the writer get on with each
+  // other, compared to the old mutex-based counter. Run with --log_level=message
+  for (size_t n_readers : { 0, 1, 4 }) {
+    LivetimeCounter counter(State::kLive);
+    MutexLivetimeCounter mutex_counter(State::kLive);
+    auto const [reads, changes] = run_contention(counter, n_readers);
+    auto const [mutex_reads, mutex_changes] = run_contention(mutex_counter, n_readers);
+    BOOST_TEST_MESSAGE(n_readers << " readers: " << reads / 1e6 << " M reads/s, " << changes / 1e6
+                                 << " M state changes/s. With a mutex: " << mutex_reads / 1e6 << " M reads/s, "
+                                 << mutex_changes / 1e6 << " M state changes/s");
+    BOOST_CHECK_GT(changes, 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+/**
+ * @file LivetimeStateTracker_test.cxx  LivetimeStateTracker Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/LivetimeStateTracker.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE LivetimeStateTracker_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <memory>
+
+using namespace dunedaq::trigger;
+using State = LivetimeCounter::State;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(StartsPaused)
+{
+  auto counter = std::make_shared<LivetimeCounter>(State::kLive);
+  LivetimeStateTracker tracker(counter);
+  BOOST_CHECK(counter->get_state() == State::kPaused);
+
+  tracker.set_paused(false);
+  BOOST_CHECK(counter->get_state() == State::kLive);
+}
+
+BOOST_AUTO_TEST_CASE(BusyDuringPause)
+{
+  auto counter = std::make_shared<LivetimeCounter>(State::kPaused);
+  LivetimeStateTracker tracker(counter);
+  tracker.set_paused(false);
+
+  // A busy period that starts while paused doesn't make us dead...
+  tracker.set_paused(true);
+  tracker.set_dfo_busy(true);
+  BOOST_CHECK(counter->get_state() == State::kPaused);
+
+  // ...nor does its end make us live
+  tracker.set_dfo_busy(false);
+  BOOST_CHECK(counter->get_state() == State::kPaused);
+
+  // Resuming while the DFO is still busy makes us dead, until it isn't
+  tracker.set_dfo_busy(true);
+  tracker.set_paused(false);
+  BOOST_CHECK(counter->get_state() == State::kDead);
+  tracker.set_dfo_busy(false);
+  BOOST_CHECK(counter->get_state() == State::kLive);
+}
+
+BOOST_AUTO_TEST_CASE(TokensAndBusy)
+{
+  auto counter = std::make_shared<LivetimeCounter>(State::kPaused);
+  LivetimeStateTracker tracker(counter);
+  tracker.set_paused(false);
+
+  // Out of tokens and busy at once: only live again once both are over
+  tracker.set_triggers_allowed(false);
+  tracker.set_dfo_busy(true);
+  BOOST_CHECK(counter->get_state() == State::kDead);
+  tracker.set_dfo_busy(false);
+  BOOST_CHECK(counter->get_state() == State::kDead);
+  tracker.set_triggers_allowed(true);
+  BOOST_CHECK(counter->get_state() == State::kLive);
+
+  // Pausing while out of tokens is paused, and resuming is dead until a token comes back
+  tracker.set_triggers_allowed(false);
+  tracker.set_paused(true);
+  BOOST_CHECK(counter->get_state() == State::kPaused);
+  tracker.set_paused(false);
+  BOOST_CHECK(counter->get_state() == State::kDead);
+  tracker.set_triggers_allowed(true);
+  BOOST_CHECK(counter->get_state() == State::kLive);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
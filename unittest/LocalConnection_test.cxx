@@ -0,0 +1,114 @@
+/**
+ * @file LocalConnection_test.cxx  LocalConnection class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/LocalConnection.hpp"
+#include "trigger/TPSet.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE LocalConnection_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <optional>
+#include <set>
+#include <thread>
+
+using namespace dunedaq;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(LocalNames)
+{
+  BOOST_CHECK(trigger::is_local_connection("spsc:tpsets"));
+  BOOST_CHECK(!trigger::is_local_connection("tpsets"));
+  BOOST_CHECK(!trigger::is_local_connection("tpsets_spsc:"));
+}
+
+BOOST_AUTO_TEST_CASE(SendAndReceive)
+{
+  auto output = trigger::get_output_connection<trigger::TPSet>("spsc:send_and_receive");
+  auto input = trigger::get_input_connection<trigger::TPSet>("spsc:send_and_receive");
+
+  // An empty poll waits out its timeout, without throwing
+  auto const start = std::chrono::steady_clock::now();
+  BOOST_CHECK(!input->try_receive(10ms).has_value());
+  BOOST_CHECK(std::chrono::steady_clock::now() - start >= 10ms);
+
+  trigger::TPSet tpset;
+  tpset.start_time = 100;
+  tpset.objects.resize(3);
+  BOOST_CHECK(output->try_send(std::move(tpset), 0ms));
+
+  std::optional<trigger::TPSet> received = input->try_receive(0ms);
+  BOOST_REQUIRE(received.has_value());
+  BOOST_CHECK_EQUAL(received->start_time, 100);
+  BOOST_CHECK_EQUAL(received->objects.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(FullConnectionTimesOut)
+{
+  auto output = trigger::get_output_connection<int>("spsc:full");
+  auto input = trigger::get_input_connection<int>("spsc:full");
+
+  for (size_t i = 0; i < trigger::s_local_connection_capacity; ++i) {
+    BOOST_REQUIRE(output->try_send(int(i), 0ms));
+  }
+  BOOST_CHECK(!output->try_send(-1, 1ms));
+
+  // Making room lets the sender carry on
+  BOOST_CHECK(input->try_receive(0ms).has_value());
+  BOOST_CHECK(output->try_send(-1, 0ms));
+}
+
+BOOST_AUTO_TEST_CASE(TypeMismatch)
+{
+  trigger::get_input_connection<int>("spsc:type_mismatch");
+  BOOST_CHECK_THROW(trigger::get_output_connection<trigger::TPSet>("spsc:type_mismatch"),
+                    trigger::LocalConnectionTypeMismatch);
+}
+
+BOOST_AUTO_TEST_CASE(SeveralSenders)
+{
+  // The receiver is set up first, as a module's init() might be
+  auto input = trigger::get_input_connection<int>("spsc:several_senders");
+  auto output1 = trigger::get_output_connection<int>("spsc:several_senders");
+  auto output2 = trigger::get_output_connection<int>("spsc:several_senders");
+
+  const int n = 10000;
+  auto send = [n](std::shared_ptr<trigger::OutputConnection<int>> output, int first) {
+    for (int i = first; i < first + n; ++i) {
+      while (!output->try_send(int(i), 100ms)) {
+      }
+    }
+  };
+  std::thread sender1(send, output1, 0);
+  std::thread sender2(send, output2, n);
+
+  // Each sender's objects arrive in the order it sent them
+  std::set<int> received;
+  int last1 = -1, last2 = n - 1;
+  while (received.size() < 2 * n) {
+    std::optional<int> i = input->try_receive(1000ms);
+    BOOST_REQUIRE(i.has_value());
+    int& last = *i < n ? last1 : last2;
+    BOOST_CHECK_EQUAL(*i, last + 1);
+    last = *i;
+    received.insert(*i);
+  }
+  sender1.join();
+  sender2.join();
+
+  BOOST_CHECK_EQUAL(received.size(), 2 * n);
+  BOOST_CHECK(!input->try_receive(0ms).has_value());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+/**
+ * @file LogHistogram_test.cxx  LogHistogram Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/LogHistogram.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE LogHistogram_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::trigger;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(Bins)
+{
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(0), 0);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(1), 1);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(2), 2);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(3), 2);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(4), 3);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(1023), 10);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(1024), 11);
+  BOOST_CHECK_EQUAL(LogHistogram::get_bin(~LogHistogram::value_type(0)), LogHistogram::s_n_bins - 1);
+
+  for (size_t bin = 1; bin < LogHistogram::s_n_bins - 1; ++bin) {
+    BOOST_CHECK_EQUAL(LogHistogram::get_bin(LogHistogram::get_bin_upper_edge(bin) - 1), bin);
+    BOOST_CHECK_EQUAL(LogHistogram::get_bin(LogHistogram::get_bin_upper_edge(bin)), bin + 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Summary)
+{
+  LogHistogram histogram;
+  BOOST_CHECK_EQUAL(histogram.get_count(), 0);
+  BOOST_CHECK_EQUAL(histogram.get_quantile(0.5), 0);
+  BOOST_CHECK_EQUAL(histogram.get_mean(), 0.);
+
+  for (LogHistogram::value_type value = 1; value <= 100; ++value) {
+    histogram.add(value);
+  }
+  BOOST_CHECK_EQUAL(histogram.get_count(), 100);
+  BOOST_CHECK_EQUAL(histogram.get_sum(), 5050);
+  BOOST_CHECK_EQUAL(histogram.get_max(), 100);
+  BOOST_CHECK_EQUAL(histogram.get_mean(), 50.5);
+  BOOST_CHECK_EQUAL(histogram.get_bin_count(LogHistogram::get_bin(64)), 37); // 64 to 100
+
+  // The quantiles are upper bounds, at most a factor of two out
+  for (double q : { 0.1, 0.5, 0.9, 0.99 }) {
+    double const exact = q * 100;
+    BOOST_CHECK_GE(histogram.get_quantile(q), exact - 1);
+    BOOST_CHECK_LE(histogram.get_quantile(q), 2 * exact);
+  }
+  BOOST_CHECK_EQUAL(histogram.get_quantile(1.), 100);
+
+  histogram.reset();
+  BOOST_CHECK_EQUAL(histogram.get_count(), 0);
+  BOOST_CHECK_EQUAL(histogram.get_max(), 0);
+  BOOST_CHECK_EQUAL(histogram.get_bin_count(LogHistogram::get_bin(64)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentAdds)
+{
+  LogHistogram histogram;
+  const size_t n_threads = 4;
+  const size_t n_adds = 100000;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&histogram, t]() {
+      for (size_t i = 0; i < n_adds; ++i) {
+        histogram.add(t * n_adds + i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(histogram.get_count(), n_threads * n_adds);
+  BOOST_CHECK_EQUAL(histogram.get_max(), n_threads * n_adds - 1);
+  LogHistogram::value_type total = 0;
+  for (size_t bin = 0; bin < LogHistogram::s_n_bins; ++bin) {
+    total += histogram.get_bin_count(bin);
+  }
+  BOOST_CHECK_EQUAL(total, n_threads * n_adds);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+/**
+ * @file ReadoutMap_test.cxx  ReadoutMap Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/Issues.hpp"
+#include "trigger/ReadoutMap.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE ReadoutMap_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <map>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::trigger;
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerCandidate;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+// Two links in each of three regions, of 1000 channels each
+std::vector<daqdataformats::GeoID>
+make_links()
+{
+  std::vector<daqdataformats::GeoID> links;
+  for (uint16_t region = 0; region < 3; ++region) { // NOLINT(build/unsigned)
+    for (uint32_t element = 0; element < 2; ++element) { // NOLINT(build/unsigned)
+      links.emplace_back(daqdataformats::GeoID::SystemType::kTPC, region, element);
+    }
+  }
+  return links;
+}
+
+ReadoutMap
+make_map()
+{
+  std::vector<ReadoutMap::Region> regions = { { 2, 2000, 2999 }, { 0, 0, 999 }, { 1, 1000, 1999 } };
+  ReadoutMap::TypeReadout localized;
+  localized.localized = true;
+  localized.window_before = 100;
+  localized.window_after = 200;
+  ReadoutMap::TypeReadout timing;
+  timing.window_before = 5000;
+  return ReadoutMap(make_links(),
+                    regions,
+                    { { static_cast<ReadoutMap::type_t>(TriggerCandidate::Type::kSupernova), localized },
+                      { static_cast<ReadoutMap::type_t>(TriggerCandidate::Type::kTiming), timing } });
+}
+
+TriggerCandidate
+make_tc(TriggerCandidate::Type type, std::vector<std::pair<uint32_t, uint32_t>> ta_channels) // NOLINT
+{
+  TriggerCandidate tc;
+  tc.type = type;
+  tc.time_start = 10000;
+  tc.time_end = 11000;
+  for (auto [first, last] : ta_channels) {
+    TriggerActivity ta;
+    ta.channel_start = first;
+    ta.channel_end = last;
+    tc.inputs.push_back(ta);
+  }
+  return tc;
+}
+
+std::vector<uint16_t> // NOLINT(build/unsigned)
+regions_of(const std::vector<daqdataformats::ComponentRequest>& components)
+{
+  std::vector<uint16_t> regions; // NOLINT(build/unsigned)
+  for (auto& request : components) {
+    regions.push_back(request.component.region_id);
+  }
+  return regions;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(LocalizedReadsOutItsRegions)
+{
+  ReadoutMap map = make_map();
+  std::vector<daqdataformats::ComponentRequest> components;
+
+  map.fill_components({ make_tc(TriggerCandidate::Type::kSupernova, { { 1500, 1600 } }) }, components);
+  BOOST_CHECK(regions_of(components) == std::vector<uint16_t>({ 1, 1 })); // NOLINT(build/unsigned)
+  BOOST_CHECK_EQUAL(components[0].window_begin, 9900);
+  BOOST_CHECK_EQUAL(components[0].window_end, 11200);
+
+  // A TA across a region boundary, and one in another region
+  map.fill_components({ make_tc(TriggerCandidate::Type::kSupernova, { { 2999, 2999 }, { 900, 1000 } }) }, components);
+  BOOST_CHECK(regions_of(components) == std::vector<uint16_t>({ 0, 0, 1, 1, 2, 2 })); // NOLINT(build/unsigned)
+}
+
+BOOST_AUTO_TEST_CASE(EverythingElseReadsOutAllLinks)
+{
+  ReadoutMap map = make_map();
+  std::vector<daqdataformats::ComponentRequest> components;
+
+  // Not a localized type
+  map.fill_components({ make_tc(TriggerCandidate::Type::kRandom, { { 0, 10 } }) }, components);
+  BOOST_CHECK_EQUAL(components.size(), 6);
+  BOOST_CHECK_EQUAL(components[0].window_begin, 10000);
+  BOOST_CHECK_EQUAL(components[0].window_end, 11000);
+
+  // Localized, but no TAs, or none in a region
+  map.fill_components({ make_tc(TriggerCandidate::Type::kSupernova, {}) }, components);
+  BOOST_CHECK_EQUAL(components.size(), 6);
+  map.fill_components({ make_tc(TriggerCandidate::Type::kSupernova, { { 5000, 5000 } }) }, components);
+  BOOST_CHECK_EQUAL(components.size(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(MergedTCs)
+{
+  ReadoutMap map = make_map();
+  std::vector<daqdataformats::ComponentRequest> components;
+
+  map.fill_components({ make_tc(TriggerCandidate::Type::kSupernova, { { 0, 10 } }),
+                        make_tc(TriggerCandidate::Type::kSupernova, { { 2500, 2510 } }) },
+                      components);
+  BOOST_CHECK(regions_of(components) == std::vector<uint16_t>({ 0, 0, 2, 2 })); // NOLINT(build/unsigned)
+
+  // One that needs every link, with a longer window
+  map.fill_components({ make_tc(TriggerCandidate::Type::kSupernova, { { 0, 10 } }),
+                        make_tc(TriggerCandidate::Type::kTiming, {}) },
+                      components);
+  BOOST_CHECK_EQUAL(components.size(), 6);
+  BOOST_CHECK_EQUAL(components[0].window_begin, 5000);
+  BOOST_CHECK_EQUAL(components[0].window_end, 11200);
+}
+
+BOOST_AUTO_TEST_CASE(BadRegions)
+{
+  BOOST_CHECK_THROW(ReadoutMap(make_links(), { { 0, 0, 1000 }, { 1, 1000, 1999 } }, {}), BadReadoutMap);
+  BOOST_CHECK_THROW(ReadoutMap(make_links(), { { 0, 10, 9 } }, {}), BadReadoutMap);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+/**
+ * @file SPSCRingBuffer_test.cxx  SPSCRingBuffer class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/SPSCRingBuffer.hpp"
+#include "trigger/TPSet.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE SPSCRingBuffer_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(CapacityIsPowerOfTwo)
+{
+  trigger::SPSCRingBuffer<int> rb(10);
+  BOOST_CHECK_EQUAL(rb.capacity(), 16);
+  BOOST_CHECK(rb.empty_approx());
+}
+
+BOOST_AUTO_TEST_CASE(SendAndReceive)
+{
+  trigger::SPSCRingBuffer<int> rb(4);
+
+  BOOST_CHECK(!rb.try_receive().has_value());
+
+  for (int i = 0; i < 4; ++i) {
+    BOOST_CHECK(rb.try_send(int(i)));
+  }
+  // Full
+  BOOST_CHECK(!rb.try_send(4));
+  BOOST_CHECK_EQUAL(rb.size_approx(), 4);
+
+  for (int i = 0; i < 4; ++i) {
+    std::optional<int> item = rb.try_receive();
+    BOOST_REQUIRE(item.has_value());
+    BOOST_CHECK_EQUAL(*item, i);
+  }
+  BOOST_CHECK(!rb.try_receive().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(FailedSendLeavesItem)
+{
+  trigger::SPSCRingBuffer<trigger::TPSet> rb(1);
+  trigger::TPSet first, second;
+  second.objects.resize(3);
+
+  BOOST_CHECK(rb.try_send(std::move(first)));
+  BOOST_CHECK(!rb.try_send(std::move(second)));
+  BOOST_CHECK_EQUAL(second.objects.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(Batches)
+{
+  trigger::SPSCRingBuffer<int> rb(8);
+  std::vector<int> in{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+  // Only the first 8 fit
+  BOOST_CHECK_EQUAL(rb.try_send_batch(in.begin(), in.end()), 8);
+
+  std::vector<int> out;
+  BOOST_CHECK_EQUAL(rb.try_receive_batch(std::back_inserter(out), 5), 5);
+  BOOST_CHECK_EQUAL(rb.try_send_batch(in.begin() + 8, in.end()), 2);
+  BOOST_CHECK_EQUAL(rb.try_receive_batch(std::back_inserter(out), 100), 5);
+  BOOST_CHECK_EQUAL(rb.try_receive_batch(std::back_inserter(out), 100), 0);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(in.begin(), in.end(), out.begin(), out.end());
+}
+
+BOOST_AUTO_TEST_CASE(TwoThreads)
+{
+  const int n_items = 1000000;
+  trigger::SPSCRingBuffer<int> rb(64);
+
+  std::thread producer([&rb]() {
+    for (int i = 0; i < n_items; ++i) {
+      while (!rb.try_send(int(i))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  bool in_order = true;
+  while (expected < n_items) {
+    std::optional<int> item = rb.try_receive();
+    if (!item.has_value()) {
+      std::this_thread::yield();
+      continue;
+    }
+    in_order = in_order && (*item == expected);
+    ++expected;
+  }
+  producer.join();
+
+  BOOST_CHECK(in_order);
+  BOOST_CHECK(rb.empty_approx());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
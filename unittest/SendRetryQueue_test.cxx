@@ -0,0 +1,146 @@
+/**
+ * @file SendRetryQueue_test.cxx  SendRetryQueue Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/SendRetryQueue.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE SendRetryQueue_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace dunedaq::trigger;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+const SendRetryQueue<int>::clock_type::time_point s_t0{};
+
+// A receiver that can be made to refuse everything
+struct Receiver
+{
+  bool accepting = true;
+  std::vector<int> received;
+
+  bool operator()(int& item)
+  {
+    if (accepting) {
+      received.push_back(item);
+    }
+    return accepting;
+  }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(SendsInOrder)
+{
+  SendRetryQueue<int> queue(10, 100ms);
+  Receiver receiver;
+  std::vector<int> dropped;
+  for (int i = 1; i <= 3; ++i) {
+    queue.push(int(i), s_t0);
+  }
+  BOOST_CHECK_EQUAL(queue.flush(receiver, s_t0, dropped), 3);
+  BOOST_CHECK(queue.empty());
+  BOOST_CHECK(receiver.received == std::vector<int>({ 1, 2, 3 }));
+  BOOST_CHECK(dropped.empty());
+  BOOST_CHECK_EQUAL(queue.get_n_failures(), 0);
+  BOOST_CHECK_EQUAL(queue.get_retry_latency().get_count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Retries)
+{
+  SendRetryQueue<int> queue(10, 100ms);
+  Receiver receiver;
+  std::vector<int> dropped;
+
+  receiver.accepting = false;
+  queue.push(1, s_t0);
+  BOOST_CHECK_EQUAL(queue.flush(receiver, s_t0, dropped), 0);
+  // Later items wait behind the first, rather than overtaking it
+  queue.push(2, s_t0 + 5ms);
+  BOOST_CHECK_EQUAL(queue.flush(receiver, s_t0 + 5ms, dropped), 0);
+  BOOST_CHECK_EQUAL(queue.size(), 2);
+  BOOST_CHECK_EQUAL(queue.get_n_failures(), 2);
+
+  receiver.accepting = true;
+  BOOST_CHECK_EQUAL(queue.flush(receiver, s_t0 + 10ms, dropped), 2);
+  BOOST_CHECK(receiver.received == std::vector<int>({ 1, 2 }));
+  BOOST_CHECK(dropped.empty());
+  // Only the first item failed to send
+  BOOST_CHECK_EQUAL(queue.get_retry_latency().get_count(), 1);
+  BOOST_CHECK_EQUAL(queue.get_retry_latency().get_max(), 10000);
+}
+
+BOOST_AUTO_TEST_CASE(MaxRetryTime)
+{
+  SendRetryQueue<int> queue(10, 100ms);
+  Receiver receiver;
+  receiver.accepting = false;
+  std::vector<int> dropped;
+
+  queue.push(1, s_t0);
+  queue.push(2, s_t0 + 50ms);
+  queue.flush(receiver, s_t0, dropped);
+  queue.flush(receiver, s_t0 + 99ms, dropped);
+  BOOST_CHECK(dropped.empty());
+  // The first item gives up, and the second fails too, but has time left
+  queue.flush(receiver, s_t0 + 100ms, dropped);
+  BOOST_CHECK(dropped == std::vector<int>({ 1 }));
+  BOOST_CHECK_EQUAL(queue.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Depth)
+{
+  Receiver receiver;
+  receiver.accepting = false;
+  std::vector<int> dropped;
+
+  // Without a queue, an item that fails is dropped straight away
+  SendRetryQueue<int> no_retries;
+  no_retries.push(1, s_t0);
+  no_retries.flush(receiver, s_t0, dropped);
+  BOOST_CHECK(dropped == std::vector<int>({ 1 }));
+  BOOST_CHECK(no_retries.empty());
+
+  // With too many waiting, the oldest are dropped
+  dropped.clear();
+  SendRetryQueue<int> queue(2, 100ms);
+  for (int i = 1; i <= 4; ++i) {
+    queue.push(int(i), s_t0);
+    queue.flush(receiver, s_t0, dropped);
+  }
+  BOOST_CHECK(dropped == std::vector<int>({ 1, 2 }));
+  BOOST_CHECK_EQUAL(queue.size(), 2);
+
+  queue.drop_all(dropped);
+  BOOST_CHECK(dropped == std::vector<int>({ 1, 2, 3, 4 }));
+  BOOST_CHECK(queue.empty());
+
+  // A deeper queue from now on
+  dropped.clear();
+  queue.configure(3, 100ms);
+  for (int i = 1; i <= 4; ++i) {
+    queue.push(int(i), s_t0);
+    queue.flush(receiver, s_t0, dropped);
+  }
+  BOOST_CHECK(dropped == std::vector<int>({ 1 }));
+  BOOST_CHECK_EQUAL(queue.size(), 3);
+  BOOST_CHECK_GT(queue.get_n_failures(), 0);
+  queue.reset_counts();
+  BOOST_CHECK_EQUAL(queue.get_n_failures(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
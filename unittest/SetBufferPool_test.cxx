@@ -0,0 +1,113 @@
+/**
+ * @file SetBufferPool_test.cxx  SetBufferPool class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/SetBufferPool.hpp"
+#include "trigger/TimeSliceInputBuffer.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE SetBufferPool_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::trigger;
+
+namespace {
+// Each test case uses its own T, so that the process-wide pools don't interfere
+struct Obj
+{
+  dunedaq::daqdataformats::timestamp_t time_start = 0;
+};
+struct OtherObj
+{
+  dunedaq::daqdataformats::timestamp_t time_start = 0;
+};
+struct ManyObj
+{
+  int value = 0;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SetBufferPool_test)
+
+BOOST_AUTO_TEST_CASE(AcquireRelease)
+{
+  auto& pool = SetBufferPool<Obj>::get();
+
+  std::vector<Obj> first = pool.acquire();
+  BOOST_CHECK_EQUAL(pool.get_new_count(), 1);
+  BOOST_CHECK_EQUAL(first.capacity(), 0);
+
+  first.resize(100);
+  const Obj* data = first.data();
+  pool.release(std::move(first));
+
+  // We get the same memory back, emptied
+  std::vector<Obj> second = pool.acquire();
+  BOOST_CHECK_EQUAL(pool.get_reused_count(), 1);
+  BOOST_CHECK_EQUAL(second.size(), 0);
+  BOOST_CHECK_GE(second.capacity(), 100);
+  BOOST_CHECK_EQUAL(second.data(), data);
+
+  // Vectors that never held anything aren't worth keeping
+  pool.release(std::vector<Obj>());
+  std::vector<Obj> third = pool.acquire();
+  BOOST_CHECK_EQUAL(pool.get_new_count(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(InputBufferRecycles)
+{
+  auto& pool = SetBufferPool<OtherObj>::get();
+  std::string name("test"), algorithm("alg");
+  TimeSliceInputBuffer<OtherObj> buffer(name, algorithm);
+
+  std::vector<OtherObj> time_slice;
+  dunedaq::daqdataformats::timestamp_t start_time, end_time;
+  for (int i = 0; i < 2; ++i) {
+    Set<OtherObj> set;
+    set.start_time = 10;
+    set.end_time = 20;
+    set.objects = pool.acquire();
+    set.objects.resize(5);
+    BOOST_CHECK(!buffer.buffer(std::move(set), time_slice, start_time, end_time));
+  }
+  BOOST_REQUIRE(buffer.flush(time_slice, start_time, end_time));
+  BOOST_CHECK_EQUAL(time_slice.size(), 10);
+
+  // Both sets' vectors went back to the pool
+  BOOST_CHECK_GE(pool.acquire().capacity(), 5);
+  BOOST_CHECK_GE(pool.acquire().capacity(), 5);
+  BOOST_CHECK_EQUAL(pool.get_reused_count(), 2);
+  BOOST_CHECK_EQUAL(pool.get_new_count(), 2);
+}
+
+// However many vectors are released, whether they came from the pool or
+// not, it only keeps s_max_free of them
+BOOST_AUTO_TEST_CASE(PoolIsBounded)
+{
+  auto& pool = SetBufferPool<ManyObj>::get();
+  const size_t n_extra = 10;
+  for (size_t i = 0; i < SetBufferPool<ManyObj>::s_max_free + n_extra; ++i) {
+    pool.release(std::vector<ManyObj>(1));
+  }
+
+  std::vector<std::vector<ManyObj>> acquired;
+  for (size_t i = 0; i < SetBufferPool<ManyObj>::s_max_free + n_extra; ++i) {
+    acquired.push_back(pool.acquire());
+  }
+  BOOST_CHECK_EQUAL(pool.get_reused_count(), SetBufferPool<ManyObj>::s_max_free);
+  BOOST_CHECK_EQUAL(pool.get_new_count(), n_extra);
+  BOOST_CHECK_EQUAL(acquired.back().capacity(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,159 @@
+/**
+ * @file TCCoalescer_test.cxx  TCCoalescer Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCCoalescer.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TCCoalescer_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+using namespace dunedaq::trigger;
+using triggeralgs::TriggerCandidate;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+TriggerCandidate
+make_tc(triggeralgs::timestamp_t start,
+        triggeralgs::timestamp_t end,
+        TriggerCandidate::Type type = TriggerCandidate::Type::kUnknown)
+{
+  TriggerCandidate tc;
+  tc.type = type;
+  tc.time_start = start;
+  tc.time_end = end;
+  tc.time_candidate = (start + end) / 2;
+  return tc;
+}
+
+const TCCoalescer::clock_type::time_point s_t0{};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(OverlappingTCsAreMerged)
+{
+  TCCoalescer coalescer(std::chrono::milliseconds(10));
+  TCGroup ready;
+  BOOST_CHECK(!coalescer.add(make_tc(1000, 2000), s_t0, ready));
+  BOOST_CHECK(!coalescer.add(make_tc(1500, 3000), s_t0 + std::chrono::milliseconds(1), ready));
+  // Overlaps the union, though not the first TC
+  BOOST_CHECK(!coalescer.add(make_tc(2500, 2600), s_t0 + std::chrono::milliseconds(2), ready));
+  // Earlier, and touching the start
+  BOOST_CHECK(!coalescer.add(make_tc(500, 1000), s_t0 + std::chrono::milliseconds(3), ready));
+
+  BOOST_CHECK(!coalescer.flush_due(s_t0 + std::chrono::milliseconds(9), ready));
+  BOOST_REQUIRE(coalescer.flush_due(s_t0 + std::chrono::milliseconds(10), ready));
+  BOOST_CHECK_EQUAL(ready.tcs.size(), 4);
+  BOOST_CHECK_EQUAL(ready.window_begin, 500);
+  BOOST_CHECK_EQUAL(ready.window_end, 3000);
+  BOOST_CHECK_EQUAL(ready.time_candidate, 750);
+
+  BOOST_CHECK(!coalescer.flush(ready));
+  BOOST_CHECK(coalescer.get_deadline() == TCCoalescer::clock_type::time_point::max());
+}
+
+BOOST_AUTO_TEST_CASE(DisjointTCEndsTheGroup)
+{
+  TCCoalescer coalescer(std::chrono::milliseconds(10));
+  TCGroup ready;
+  BOOST_CHECK(!coalescer.add(make_tc(1000, 2000), s_t0, ready));
+  BOOST_REQUIRE(coalescer.add(make_tc(2001, 3000), s_t0 + std::chrono::milliseconds(1), ready));
+  BOOST_CHECK_EQUAL(ready.tcs.size(), 1);
+  BOOST_CHECK_EQUAL(ready.window_begin, 1000);
+  BOOST_CHECK_EQUAL(ready.window_end, 2000);
+
+  // The new group is due a window after its own first TC
+  BOOST_CHECK(coalescer.get_deadline() == s_t0 + std::chrono::milliseconds(11));
+  BOOST_REQUIRE(coalescer.flush(ready));
+  BOOST_CHECK_EQUAL(ready.tcs.size(), 1);
+  BOOST_CHECK_EQUAL(ready.window_begin, 2001);
+}
+
+BOOST_AUTO_TEST_CASE(HoldTimeIsNotExtended)
+{
+  TCCoalescer coalescer(std::chrono::milliseconds(10));
+  TCGroup ready;
+  for (int i = 0; i < 20; ++i) {
+    auto now = s_t0 + std::chrono::milliseconds(i);
+    coalescer.add(make_tc(1000 + i, 2000 + i), now, ready);
+    if (coalescer.flush_due(now, ready)) {
+      BOOST_CHECK_EQUAL(i, 10);
+      BOOST_CHECK_EQUAL(ready.tcs.size(), 11);
+      return;
+    }
+  }
+  BOOST_FAIL("The group was never due");
+}
+
+BOOST_AUTO_TEST_CASE(ZeroWindow)
+{
+  TCCoalescer coalescer(std::chrono::microseconds(0));
+  TCGroup ready;
+  BOOST_CHECK(!coalescer.add(make_tc(1000, 2000), s_t0, ready));
+  BOOST_REQUIRE(coalescer.flush_due(s_t0, ready));
+  BOOST_CHECK_EQUAL(ready.tcs.size(), 1);
+}
+
+// The ModuleLevelTrigger takes TCs in batches, and checks for a due group
+// before adding each TC, so TCs that arrive together, but after the window,
+// aren't merged
+BOOST_AUTO_TEST_CASE(ZeroWindowBatch)
+{
+  TCCoalescer coalescer(std::chrono::microseconds(0));
+  TCGroup ready;
+  std::vector<size_t> group_sizes;
+  for (int i = 0; i < 3; ++i) {
+    auto const arrival_time = s_t0 + std::chrono::microseconds(i);
+    if (coalescer.flush_due(arrival_time, ready)) {
+      group_sizes.push_back(ready.tcs.size());
+    }
+    // All overlapping
+    if (coalescer.add(make_tc(1000 + i, 2000 + i), arrival_time, ready)) {
+      group_sizes.push_back(ready.tcs.size());
+    }
+  }
+  if (coalescer.flush_due(s_t0 + std::chrono::microseconds(3), ready)) {
+    group_sizes.push_back(ready.tcs.size());
+  }
+  BOOST_CHECK_EQUAL(group_sizes.size(), 3);
+  for (size_t size : group_sizes) {
+    BOOST_CHECK_EQUAL(size, 1);
+  }
+}
+
+// TCs whose own windows are apart, but whose readout windows overlap once
+// their type's are extended, make one decision
+BOOST_AUTO_TEST_CASE(ExtendedWindowsOverlap)
+{
+  std::map<ReadoutMap::type_t, ReadoutMap::TypeReadout> type_readouts;
+  ReadoutMap::TypeReadout& extended = type_readouts[static_cast<ReadoutMap::type_t>(TriggerCandidate::Type::kRandom)];
+  extended.window_before = 100;
+  extended.window_after = 500;
+  ReadoutMap readout_map({}, {}, type_readouts);
+
+  TCCoalescer coalescer(std::chrono::microseconds(10000), &readout_map);
+  TCGroup ready;
+  BOOST_CHECK(!coalescer.add(make_tc(1000, 2000, TriggerCandidate::Type::kRandom), s_t0, ready));
+  // 2400 is within the first TC's window_after
+  BOOST_CHECK(!coalescer.add(make_tc(2400, 3000), s_t0, ready));
+  // but the second TC's type isn't extended
+  BOOST_REQUIRE(coalescer.add(make_tc(3001, 3100), s_t0, ready));
+  BOOST_CHECK_EQUAL(ready.tcs.size(), 2);
+  BOOST_CHECK_EQUAL(ready.window_begin, 900);
+  BOOST_CHECK_EQUAL(ready.window_end, 3000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+/**
+ * @file TCEventQueue_test.cxx  TCEventQueue Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCEventQueue.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TCEventQueue_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::trigger;
+using triggeralgs::TriggerCandidate;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+TriggerCandidate
+make_tc(triggeralgs::timestamp_t time)
+{
+  TriggerCandidate tc;
+  tc.time_candidate = time;
+  return tc;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TakesTCsInOrder)
+{
+  TCEventQueue queue(10);
+  queue.open();
+  auto const t0 = TCEventQueue::clock_type::now();
+  for (triggeralgs::timestamp_t time = 1; time <= 3; ++time) {
+    BOOST_REQUIRE(queue.push(make_tc(time), t0 + std::chrono::microseconds(time)));
+  }
+
+  std::vector<TCEventQueue::ReceivedTC> tcs;
+  BOOST_CHECK(!queue.wait_and_take(t0 + 1s, tcs, []() { return false; }));
+  BOOST_REQUIRE_EQUAL(tcs.size(), 3);
+  for (size_t i = 0; i < tcs.size(); ++i) {
+    BOOST_CHECK_EQUAL(tcs[i].tc.time_candidate, i + 1);
+    BOOST_CHECK(tcs[i].arrival_time == t0 + std::chrono::microseconds(i + 1));
+  }
+
+  // Nothing left, so this waits for the deadline
+  auto const deadline = TCEventQueue::clock_type::now() + 10ms;
+  BOOST_CHECK(!queue.wait_and_take(deadline, tcs, []() { return false; }));
+  BOOST_CHECK(tcs.empty());
+  BOOST_CHECK(TCEventQueue::clock_type::now() >= deadline);
+}
+
+BOOST_AUTO_TEST_CASE(NotifyWakesTheTaker)
+{
+  TCEventQueue queue(10);
+  queue.open();
+  std::thread notifier([&]() {
+    std::this_thread::sleep_for(10ms);
+    queue.notify();
+  });
+  auto const start = TCEventQueue::clock_type::now();
+  std::vector<TCEventQueue::ReceivedTC> tcs;
+  queue.wait_and_take(start + 10s, tcs, []() { return false; });
+  BOOST_CHECK(TCEventQueue::clock_type::now() - start < 5s);
+  BOOST_CHECK(tcs.empty());
+  notifier.join();
+}
+
+BOOST_AUTO_TEST_CASE(ClosedQueueDropsTCs)
+{
+  TCEventQueue queue(1);
+  BOOST_CHECK(!queue.push(make_tc(1), TCEventQueue::clock_type::now()));
+
+  queue.open();
+  BOOST_REQUIRE(queue.push(make_tc(1), TCEventQueue::clock_type::now()));
+  // The queue is full, so this waits until it is closed
+  std::atomic<bool> pushed{ true };
+  std::thread pusher([&]() { pushed = queue.push(make_tc(2), TCEventQueue::clock_type::now()); });
+  std::this_thread::sleep_for(10ms);
+  queue.close();
+  pusher.join();
+  BOOST_CHECK(!pushed.load());
+
+  // Reopening empties the queue
+  queue.open();
+  std::vector<TCEventQueue::ReceivedTC> tcs;
+  queue.wait_and_take(TCEventQueue::clock_type::now(), tcs, []() { return false; });
+  BOOST_CHECK(tcs.empty());
+}
+
+// The ModuleLevelTrigger's stop sequence, with no tokens left and the
+// callback waiting for room: stop() must free the decision thread from
+// waiting for a token, so that it takes the TCs and the callback can finish
+BOOST_AUTO_TEST_CASE(StopWithTokensExhaustedAndQueueFull)
+{
+  constexpr size_t capacity = 4;
+  constexpr size_t n_tcs = 3 * capacity;
+  TCEventQueue queue(capacity);
+  queue.open();
+  std::atomic<bool> running{ true };
+
+  // The callback, which ends up waiting for room
+  std::atomic<size_t> n_pushed{ 0 };
+  std::thread callback([&]() {
+    for (size_t i = 0; i < n_tcs; ++i) {
+      if (queue.push(make_tc(i), TCEventQueue::clock_type::now())) {
+        ++n_pushed;
+      }
+    }
+  });
+
+  // The decision thread, which tries to make a decision for each TC but never gets a token
+  size_t n_taken = 0;
+  size_t n_without_token = 0;
+  std::thread decisions([&]() {
+    std::vector<TCEventQueue::ReceivedTC> tcs;
+    while (true) {
+      bool const done = queue.wait_and_take(
+        TCEventQueue::clock_type::now() + 1s, tcs, [&]() { return !running.load(); });
+      for (size_t i = 0; i < tcs.size(); ++i) {
+        ++n_taken;
+        if (!queue.wait_unless_stopping([]() { return false; })) {
+          ++n_without_token;
+        }
+      }
+      if (done && tcs.empty()) {
+        break;
+      }
+    }
+  });
+
+  // Let the decision thread block waiting for a token, and the callback fill the queue behind it
+  std::this_thread::sleep_for(50ms);
+  BOOST_CHECK(n_pushed.load() < n_tcs);
+
+  queue.stop();
+  callback.join(); // As the callback is removed
+  queue.close();
+  running.store(false);
+  queue.notify();
+  decisions.join();
+
+  BOOST_CHECK_EQUAL(n_pushed.load(), n_tcs);
+  BOOST_CHECK_EQUAL(n_taken, n_tcs);
+  BOOST_CHECK_EQUAL(n_without_token, n_tcs);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,109 @@
+/**
+ * @file TCTypeLimiter_test.cxx  TCTypeLimiter Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TCTypeLimiter.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TCTypeLimiter_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <map>
+
+using namespace dunedaq::trigger;
+using Type = triggeralgs::TriggerCandidate::Type;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+const TCTypeLimiter::clock_type::time_point s_t0{};
+
+TCTypeLimiter::type_t
+type_value(Type type)
+{
+  return static_cast<TCTypeLimiter::type_t>(type);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(NoLimits)
+{
+  TCTypeLimiter limiter;
+  for (int i = 0; i < 100; ++i) {
+    BOOST_CHECK(limiter.check(Type::kTiming, s_t0) == TCTypeLimiter::Result::kAccepted);
+  }
+  BOOST_CHECK_EQUAL(limiter.get_counts()[type_value(Type::kTiming)].accepted, 100);
+}
+
+BOOST_AUTO_TEST_CASE(Prescale)
+{
+  TCTypeLimiter limiter;
+  TCTypeLimiter::Limits limits;
+  limits.prescale = 10;
+  limiter.set_limits({ { type_value(Type::kRandom), limits } }, s_t0);
+
+  for (int i = 0; i < 100; ++i) {
+    auto result = limiter.check(Type::kRandom, s_t0);
+    BOOST_CHECK(result == (i % 10 == 0 ? TCTypeLimiter::Result::kAccepted : TCTypeLimiter::Result::kPrescaled));
+    // Other types aren't affected
+    BOOST_CHECK(limiter.check(Type::kTiming, s_t0) == TCTypeLimiter::Result::kAccepted);
+  }
+  auto counts = limiter.get_counts();
+  BOOST_CHECK_EQUAL(counts[type_value(Type::kRandom)].accepted, 10);
+  BOOST_CHECK_EQUAL(counts[type_value(Type::kRandom)].prescaled, 90);
+  BOOST_CHECK_EQUAL(counts[type_value(Type::kTiming)].accepted, 100);
+}
+
+BOOST_AUTO_TEST_CASE(RateLimit)
+{
+  TCTypeLimiter limiter;
+  TCTypeLimiter::Limits limits;
+  limits.rate_limit_hz = 10.;
+  limits.rate_limit_burst = 3.;
+  limiter.set_limits({ { type_value(Type::kTiming), limits } }, s_t0);
+
+  // A burst of three, then nothing until the bucket refills
+  for (int i = 0; i < 3; ++i) {
+    BOOST_CHECK(limiter.check(Type::kTiming, s_t0) == TCTypeLimiter::Result::kAccepted);
+  }
+  BOOST_CHECK(limiter.check(Type::kTiming, s_t0) == TCTypeLimiter::Result::kRateLimited);
+  BOOST_CHECK(limiter.check(Type::kTiming, s_t0 + std::chrono::milliseconds(50)) ==
+              TCTypeLimiter::Result::kRateLimited);
+  BOOST_CHECK(limiter.check(Type::kTiming, s_t0 + std::chrono::milliseconds(100)) ==
+              TCTypeLimiter::Result::kAccepted);
+
+  // A steady 100 Hz for 10 s gets through at 10 Hz
+  int accepted = 0;
+  for (int i = 1; i <= 1000; ++i) {
+    auto now = s_t0 + std::chrono::seconds(1) + i * std::chrono::milliseconds(10);
+    accepted += limiter.check(Type::kTiming, now) == TCTypeLimiter::Result::kAccepted;
+  }
+  BOOST_CHECK(accepted >= 100 && accepted <= 103);
+}
+
+BOOST_AUTO_TEST_CASE(ChangeLimits)
+{
+  TCTypeLimiter limiter;
+  TCTypeLimiter::Limits limits;
+  limits.prescale = 1000;
+  limiter.set_limits({ { type_value(Type::kRandom), limits } }, s_t0);
+  limiter.check(Type::kRandom, s_t0);
+  BOOST_CHECK(limiter.check(Type::kRandom, s_t0) == TCTypeLimiter::Result::kPrescaled);
+
+  // Types left out have their limits removed
+  limiter.set_limits({}, s_t0);
+  BOOST_CHECK(limiter.check(Type::kRandom, s_t0) == TCTypeLimiter::Result::kAccepted);
+  BOOST_CHECK_EQUAL(limiter.get_counts()[type_value(Type::kRandom)].accepted, 2);
+
+  limiter.reset_counts();
+  BOOST_CHECK_EQUAL(limiter.get_counts()[type_value(Type::kRandom)].accepted, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
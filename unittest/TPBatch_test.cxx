@@ -0,0 +1,76 @@
+/**
+ * @file TPBatch_test.cxx  TPBatch class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPBatch.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPBatch_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+std::vector<triggeralgs::TriggerPrimitive>
+make_slice(size_t n)
+{
+  std::vector<triggeralgs::TriggerPrimitive> slice(n);
+  for (size_t i = 0; i < n; ++i) {
+    slice[i].time_start = 1000 + 10 * i;
+    slice[i].time_peak = 1005 + 10 * i;
+    slice[i].time_over_threshold = 20;
+    slice[i].channel = 7 * i;
+    slice[i].adc_integral = 100 + i;
+    slice[i].adc_peak = 10 + i;
+    slice[i].detid = 3;
+  }
+  return slice;
+}
+
+BOOST_AUTO_TEST_CASE(Columns)
+{
+  std::vector<triggeralgs::TriggerPrimitive> slice = make_slice(5);
+  trigger::TPBatch batch;
+  BOOST_CHECK(batch.empty());
+
+  batch.assign(slice);
+  BOOST_REQUIRE_EQUAL(batch.size(), slice.size());
+  BOOST_CHECK_EQUAL(batch.tps(), slice.data());
+  for (size_t i = 0; i < slice.size(); ++i) {
+    BOOST_CHECK_EQUAL(batch.time_start[i], slice[i].time_start);
+    BOOST_CHECK_EQUAL(batch.time_peak[i], slice[i].time_peak);
+    BOOST_CHECK_EQUAL(batch.time_over_threshold[i], slice[i].time_over_threshold);
+    BOOST_CHECK_EQUAL(batch.channel[i], slice[i].channel);
+    BOOST_CHECK_EQUAL(batch.adc_integral[i], slice[i].adc_integral);
+    BOOST_CHECK_EQUAL(batch.adc_peak[i], slice[i].adc_peak);
+    BOOST_CHECK_EQUAL(batch.detid[i], slice[i].detid);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RefillKeepsCapacity)
+{
+  std::vector<triggeralgs::TriggerPrimitive> big = make_slice(100);
+  std::vector<triggeralgs::TriggerPrimitive> small = make_slice(3);
+  trigger::TPBatch batch;
+
+  batch.assign(big);
+  const auto* adc_data = batch.adc_integral.data();
+  batch.assign(small);
+  BOOST_CHECK_EQUAL(batch.size(), 3);
+  BOOST_CHECK_EQUAL(batch.adc_integral.data(), adc_data);
+  batch.assign(big);
+  BOOST_CHECK_EQUAL(batch.size(), 100);
+  BOOST_CHECK_EQUAL(batch.adc_integral.data(), adc_data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
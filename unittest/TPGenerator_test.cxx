@@ -0,0 +1,139 @@
+/**
+ * @file TPGenerator_test.cxx  TPGenerator Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPGenerator.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPGenerator_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace dunedaq;
+using detdataformats::trigger::TriggerPrimitive;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+// Windows of 0.1 ms at 50 MHz
+constexpr daqdataformats::timestamp_t s_width = 5000;
+constexpr daqdataformats::timestamp_t s_start = 1'000'000;
+
+trigger::TPGeneratorParams
+make_params()
+{
+  trigger::TPGeneratorParams params;
+  params.n_channels = 1000;
+  params.noise_rate_hz = 100.;
+  params.ar39_rate_hz = 10000.;
+  params.track_rate_hz = 1000.;
+  params.burst_rate_hz = 10.;
+  params.burst_duration = 5'000'000;
+  params.burst_cluster_rate_hz = 10000.;
+  return params;
+}
+
+// Fill n_windows consecutive windows, and return all of their TPs
+std::vector<TriggerPrimitive>
+generate(trigger::TPGenerator& generator, size_t n_windows)
+{
+  std::vector<TriggerPrimitive> all;
+  trigger::TPSet tpset;
+  for (size_t i = 0; i < n_windows; ++i) {
+    daqdataformats::timestamp_t start = s_start + i * s_width;
+    generator.fill(tpset, start, start + s_width);
+    for (size_t j = 0; j < tpset.objects.size(); ++j) {
+      const TriggerPrimitive& tp = tpset.objects[j];
+      BOOST_REQUIRE(tp.time_start >= start);
+      BOOST_REQUIRE(tp.time_start < start + s_width);
+      if (j > 0) {
+        BOOST_REQUIRE(tp.time_start >= tpset.objects[j - 1].time_start);
+      }
+    }
+    all.insert(all.end(), tpset.objects.begin(), tpset.objects.end());
+  }
+  return all;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(WindowsAreSortedAndContiguous)
+{
+  trigger::TPGenerator generator(make_params(), 1);
+  // generate() checks every window
+  BOOST_CHECK(!generate(generator, 1000).empty());
+}
+
+BOOST_AUTO_TEST_CASE(TPsAreSensible)
+{
+  trigger::TPGeneratorParams params = make_params();
+  trigger::TPGenerator generator(params, 2);
+  for (auto& tp : generate(generator, 100)) {
+    BOOST_REQUIRE(tp.channel >= params.first_channel);
+    BOOST_REQUIRE(tp.channel < params.first_channel + params.n_channels);
+    BOOST_REQUIRE(tp.time_over_threshold >= params.min_time_over_threshold);
+    BOOST_REQUIRE(tp.time_over_threshold <= params.max_time_over_threshold);
+    BOOST_REQUIRE(tp.time_peak >= tp.time_start);
+    BOOST_REQUIRE(tp.adc_integral > 0);
+    BOOST_REQUIRE(tp.type == TriggerPrimitive::Type::kTPC);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SameSeedSameTPs)
+{
+  trigger::TPGenerator generator1(make_params(), 3);
+  trigger::TPGenerator generator2(make_params(), 3);
+  trigger::TPGenerator generator3(make_params(), 4);
+  auto tps1 = generate(generator1, 100);
+  auto tps2 = generate(generator2, 100);
+  auto tps3 = generate(generator3, 100);
+  BOOST_REQUIRE_EQUAL(tps1.size(), tps2.size());
+  for (size_t i = 0; i < tps1.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(tps1[i].time_start, tps2[i].time_start);
+    BOOST_REQUIRE_EQUAL(tps1[i].channel, tps2[i].channel);
+    BOOST_REQUIRE_EQUAL(tps1[i].adc_integral, tps2[i].adc_integral);
+  }
+  BOOST_CHECK(tps1.size() != tps3.size() || tps1[0].channel != tps3[0].channel);
+}
+
+BOOST_AUTO_TEST_CASE(MeanRate)
+{
+  trigger::TPGeneratorParams params = make_params();
+  params.burst_rate_hz = 0; // bursts make the count in a short run too variable
+  trigger::TPGenerator generator(params, 5);
+  size_t const n_windows = 10000;
+  double const seconds = n_windows * s_width / params.clock_frequency_hz;
+  double const expected = generator.get_mean_tp_rate() * seconds;
+  double const count = generate(generator, n_windows).size();
+  // Tracks make the count vary by more than Poisson, so allow plenty
+  BOOST_CHECK_CLOSE(count, expected, 5);
+
+  generator.scale_rates(2.);
+  BOOST_CHECK_CLOSE(generator.get_mean_tp_rate(), 2 * expected / seconds, 1e-6);
+  BOOST_CHECK_CLOSE(static_cast<double>(generate(generator, n_windows).size()), 2 * expected, 5);
+}
+
+BOOST_AUTO_TEST_CASE(ReusedTPSetKeepsCapacity)
+{
+  trigger::TPGenerator generator(make_params(), 6);
+  trigger::TPSet tpset;
+  tpset.objects.reserve(10000);
+  const TriggerPrimitive* data = tpset.objects.data();
+  for (size_t i = 0; i < 100; ++i) {
+    generator.fill(tpset, s_start + i * s_width, s_start + (i + 1) * s_width);
+    BOOST_REQUIRE(!tpset.objects.empty());
+  }
+  BOOST_CHECK_EQUAL(tpset.objects.data(), data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
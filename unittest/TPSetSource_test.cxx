@@ -0,0 +1,295 @@
+/**
+ * @file TPSetSource_test.cxx  TPSetSource and TP binary file Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/Issues.hpp"
+#include "trigger/TPBinaryFile.hpp"
+#include "trigger/TPSetSource.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPSetSource_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace dunedaq;
+using detdataformats::trigger::TriggerPrimitive;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+namespace {
+
+// A temporary file that is removed when the test case is done
+struct TempFile
+{
+  explicit TempFile(const std::string& suffix)
+    : name("/tmp/TPSetSource_test_" + std::to_string(::getpid()) + suffix)
+  {}
+  ~TempFile() { std::remove(name.c_str()); }
+  std::string name;
+};
+
+std::vector<TriggerPrimitive>
+make_tps()
+{
+  std::vector<TriggerPrimitive> tps;
+  // TPs spanning a few TPSets, with a gap of empty TPSets in the middle
+  for (detdataformats::trigger::timestamp_t time : { 1000, 1500, 2100, 2200, 2999, 6000, 6001 }) {
+    TriggerPrimitive tp;
+    tp.time_start = time;
+    tp.time_over_threshold = 10;
+    tp.time_peak = time + 5;
+    tp.channel = static_cast<detdataformats::trigger::channel_t>(time % 100);
+    tp.adc_integral = 1234;
+    tp.adc_peak = 56;
+    tp.detid = 3;
+    tp.type = TriggerPrimitive::Type::kTPC;
+    tps.push_back(tp);
+  }
+  return tps;
+}
+
+void
+write_text(const std::string& filename, const std::vector<TriggerPrimitive>& tps)
+{
+  std::ofstream fout(filename);
+  for (auto& tp : tps) {
+    fout << "\t" << tp.time_start << "\t" << tp.time_over_threshold << "\t" << tp.time_peak << "\t" << tp.channel
+         << "\t" << tp.adc_integral << "\t" << tp.adc_peak << "\t" << tp.detid << "\t" << tp.type << std::endl;
+  }
+}
+
+std::vector<trigger::TPSet>
+read_all(trigger::TPSetSource& source)
+{
+  std::vector<trigger::TPSet> tpsets;
+  trigger::TPSet tpset;
+  while (source.next(tpset)) {
+    tpsets.push_back(tpset);
+  }
+  return tpsets;
+}
+
+trigger::TPSetSlicer
+make_slicer()
+{
+  return trigger::TPSetSlicer("test", 1000, 0, 1, 2);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Slicer)
+{
+  trigger::TPSetSlicer slicer = make_slicer();
+  std::vector<trigger::TPSet> tpsets;
+  trigger::TPSet tpset;
+  for (auto& tp : make_tps()) {
+    if (slicer.add(tp, tpset)) {
+      tpsets.push_back(tpset);
+    }
+  }
+  BOOST_REQUIRE(slicer.finish(tpset));
+  tpsets.push_back(tpset);
+  BOOST_CHECK(!slicer.finish(tpset));
+
+  // Empty TPSets are skipped
+  BOOST_REQUIRE_EQUAL(tpsets.size(), 3);
+  BOOST_CHECK_EQUAL(tpsets[0].start_time, 1000);
+  BOOST_CHECK_EQUAL(tpsets[0].end_time, 2000);
+  BOOST_CHECK_EQUAL(tpsets[0].objects.size(), 2);
+  BOOST_CHECK_EQUAL(tpsets[1].start_time, 2000);
+  BOOST_CHECK_EQUAL(tpsets[1].objects.size(), 3);
+  BOOST_CHECK_EQUAL(tpsets[2].start_time, 6000);
+  BOOST_CHECK_EQUAL(tpsets[2].end_time, 7000);
+  BOOST_CHECK_EQUAL(tpsets[2].objects.size(), 2);
+  for (size_t i = 0; i < tpsets.size(); ++i) {
+    BOOST_CHECK_EQUAL(tpsets[i].seqno, i);
+    BOOST_CHECK_EQUAL(tpsets[i].origin.region_id, 1);
+    BOOST_CHECK_EQUAL(tpsets[i].origin.element_id, 2);
+    BOOST_CHECK(tpsets[i].type == trigger::TPSet::Type::kPayload);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BinaryFileRoundTrip)
+{
+  TempFile file(".bin");
+  std::vector<TriggerPrimitive> tps = make_tps();
+  {
+    trigger::TPBinaryFileWriter writer(file.name);
+    writer.write(tps[0]);
+    writer.write(tps.data() + 1, tps.size() - 1);
+  }
+  trigger::TPBinaryFileReader reader(file.name);
+  BOOST_REQUIRE_EQUAL(reader.size(), tps.size());
+  for (size_t i = 0; i < tps.size(); ++i) {
+    BOOST_CHECK_EQUAL(reader.data()[i].time_start, tps[i].time_start);
+    BOOST_CHECK_EQUAL(reader.data()[i].channel, tps[i].channel);
+    BOOST_CHECK_EQUAL(reader.data()[i].adc_integral, tps[i].adc_integral);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BinaryFileBadData)
+{
+  TempFile file(".bin");
+  BOOST_CHECK_THROW(trigger::TPBinaryFileReader reader(file.name), trigger::BadTPBinaryFile);
+
+  write_text(file.name, make_tps());
+  BOOST_CHECK_THROW(trigger::TPBinaryFileReader reader(file.name), trigger::BadTPBinaryFile);
+
+  std::vector<TriggerPrimitive> tps = make_tps();
+  {
+    trigger::TPBinaryFileWriter writer(file.name);
+    writer.write(tps.data(), tps.size());
+  }
+  // Chop the last TP in half
+  std::ifstream fin(file.name, std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+  std::ofstream(file.name, std::ios::binary | std::ios::trunc)
+    .write(contents.data(), contents.size() - sizeof(TriggerPrimitive) / 2);
+  BOOST_CHECK_THROW(trigger::TPBinaryFileReader reader(file.name), trigger::BadTPBinaryFile);
+}
+
+// Both sources give the same TPSets, and start again after rewind()
+BOOST_AUTO_TEST_CASE(TextAndBinarySourcesAgree)
+{
+  TempFile text_file(".txt");
+  TempFile binary_file(".bin");
+  std::vector<TriggerPrimitive> tps = make_tps();
+  write_text(text_file.name, tps);
+  trigger::TPBinaryFileWriter(binary_file.name).write(tps.data(), tps.size());
+
+  trigger::TextFileTPSetSource text_source(text_file.name, make_slicer());
+  trigger::BinaryFileTPSetSource binary_source(binary_file.name, make_slicer());
+
+  BOOST_CHECK_EQUAL(text_source.get_first_start_time(), binary_source.get_first_start_time());
+  BOOST_CHECK_EQUAL(text_source.get_last_start_time(), binary_source.get_last_start_time());
+
+  std::vector<trigger::TPSet> from_text = read_all(text_source);
+  for (int pass = 0; pass < 2; ++pass) {
+    binary_source.rewind(0);
+    std::vector<trigger::TPSet> from_binary = read_all(binary_source);
+    BOOST_REQUIRE_EQUAL(from_text.size(), from_binary.size());
+    for (size_t i = 0; i < from_text.size(); ++i) {
+      BOOST_CHECK_EQUAL(from_text[i].seqno, from_binary[i].seqno);
+      BOOST_CHECK_EQUAL(from_text[i].start_time, from_binary[i].start_time);
+      BOOST_CHECK_EQUAL(from_text[i].end_time, from_binary[i].end_time);
+      BOOST_REQUIRE_EQUAL(from_text[i].objects.size(), from_binary[i].objects.size());
+      for (size_t j = 0; j < from_text[i].objects.size(); ++j) {
+        BOOST_CHECK_EQUAL(from_text[i].objects[j].time_start, from_binary[i].objects[j].time_start);
+        BOOST_CHECK_EQUAL(from_text[i].objects[j].channel, from_binary[i].objects[j].channel);
+      }
+    }
+  }
+}
+
+// The streaming sources give the same TPSets as the text file source
+BOOST_AUTO_TEST_CASE(StreamingSourcesAgree)
+{
+  TempFile text_file(".txt");
+  std::vector<TriggerPrimitive> tps = make_tps();
+  write_text(text_file.name, tps);
+
+  trigger::TextFileTPSetSource text_source(text_file.name, make_slicer());
+  std::vector<trigger::TPSet> from_text = read_all(text_source);
+
+  auto streaming = std::make_unique<trigger::StreamingTextFileTPSetSource>(text_file.name, make_slicer());
+  BOOST_CHECK_EQUAL(text_source.get_first_start_time(), streaming->get_first_start_time());
+  BOOST_CHECK_EQUAL(text_source.get_last_start_time(), streaming->get_last_start_time());
+
+  // A prefetch depth smaller than the stream, so the reader thread has to wait for us
+  trigger::PrefetchingTPSetSource prefetching(std::move(streaming), 2);
+  trigger::TPSet tpset;
+  BOOST_REQUIRE(prefetching.next(tpset));
+  BOOST_CHECK_EQUAL(tpset.start_time, from_text[0].start_time);
+  for (int pass = 0; pass < 2; ++pass) {
+    // rewind in the middle of the stream, and at the end
+    prefetching.rewind(0);
+    std::vector<trigger::TPSet> from_streaming = read_all(prefetching);
+    BOOST_REQUIRE_EQUAL(from_text.size(), from_streaming.size());
+    for (size_t i = 0; i < from_text.size(); ++i) {
+      BOOST_CHECK_EQUAL(from_text[i].start_time, from_streaming[i].start_time);
+      BOOST_REQUIRE_EQUAL(from_text[i].objects.size(), from_streaming[i].objects.size());
+      for (size_t j = 0; j < from_text[i].objects.size(); ++j) {
+        BOOST_CHECK_EQUAL(from_text[i].objects[j].time_start, from_streaming[i].objects[j].time_start);
+      }
+    }
+  }
+}
+
+// The last TPSet is found from the end of a file much bigger than the part we read
+BOOST_AUTO_TEST_CASE(StreamingLastStartTime)
+{
+  TempFile text_file(".txt");
+  std::vector<TriggerPrimitive> tps;
+  for (size_t i = 0; i < 10000; ++i) {
+    TriggerPrimitive tp;
+    tp.time_start = 1000 + 10 * i;
+    tps.push_back(tp);
+  }
+  write_text(text_file.name, tps);
+  trigger::StreamingTextFileTPSetSource source(text_file.name, make_slicer());
+  BOOST_CHECK_EQUAL(source.get_first_start_time(), 1000);
+  BOOST_CHECK_EQUAL(source.get_last_start_time(), 100000);
+}
+
+// rewind() with a time shift shifts everything from then on, and a rewind
+// without one gives the original timestamps back
+BOOST_AUTO_TEST_CASE(TimeShift)
+{
+  TempFile text_file(".txt");
+  TempFile binary_file(".bin");
+  std::vector<TriggerPrimitive> tps = make_tps();
+  write_text(text_file.name, tps);
+  trigger::TPBinaryFileWriter(binary_file.name).write(tps.data(), tps.size());
+
+  std::vector<std::unique_ptr<trigger::TPSetSource>> sources;
+  sources.push_back(std::make_unique<trigger::TextFileTPSetSource>(text_file.name, make_slicer()));
+  sources.push_back(std::make_unique<trigger::StreamingTextFileTPSetSource>(text_file.name, make_slicer()));
+  sources.push_back(std::make_unique<trigger::BinaryFileTPSetSource>(binary_file.name, make_slicer()));
+  sources.push_back(std::make_unique<trigger::PrefetchingTPSetSource>(
+    std::make_unique<trigger::BinaryFileTPSetSource>(binary_file.name, make_slicer()), 2));
+
+  constexpr daqdataformats::timestamp_t shift = 1'000'000;
+  for (auto& source : sources) {
+    std::vector<trigger::TPSet> original = read_all(*source);
+    source->rewind(shift);
+    std::vector<trigger::TPSet> shifted = read_all(*source);
+    source->rewind(0);
+    std::vector<trigger::TPSet> again = read_all(*source);
+
+    BOOST_REQUIRE_EQUAL(original.size(), 3);
+    BOOST_REQUIRE_EQUAL(shifted.size(), original.size());
+    BOOST_REQUIRE_EQUAL(again.size(), original.size());
+    for (size_t i = 0; i < original.size(); ++i) {
+      BOOST_CHECK_EQUAL(shifted[i].start_time, original[i].start_time + shift);
+      BOOST_CHECK_EQUAL(shifted[i].end_time, original[i].end_time + shift);
+      BOOST_CHECK_EQUAL(again[i].start_time, original[i].start_time);
+      BOOST_REQUIRE_EQUAL(shifted[i].objects.size(), original[i].objects.size());
+      for (size_t j = 0; j < original[i].objects.size(); ++j) {
+        BOOST_CHECK_EQUAL(shifted[i].objects[j].time_start, original[i].objects[j].time_start + shift);
+        BOOST_CHECK_EQUAL(shifted[i].objects[j].time_peak, original[i].objects[j].time_peak + shift);
+        BOOST_CHECK_EQUAL(shifted[i].objects[j].channel, original[i].objects[j].channel);
+        BOOST_CHECK_EQUAL(again[i].objects[j].time_start, original[i].objects[j].time_start);
+      }
+    }
+    // The first and last start times are of the unshifted stream
+    BOOST_CHECK_EQUAL(source->get_first_start_time(), original.front().start_time);
+    BOOST_CHECK_EQUAL(source->get_last_start_time(), original.back().start_time);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
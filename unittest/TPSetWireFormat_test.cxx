@@ -0,0 +1,249 @@
+/**
+ * @file TPSetWireFormat_test.cxx  TPSet wire format Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPSet.hpp"
+#include "trigger/TPSetWireFormat.hpp"
+
+#include "serialization/Serialization.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TPSetWireFormat_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+trigger::TPSet
+make_tpset(size_t n_tps)
+{
+  trigger::TPSet tpset;
+  tpset.seqno = 1234;
+  tpset.run_number = 56;
+  tpset.origin = daqdataformats::GeoID(daqdataformats::GeoID::SystemType::kDataSelection, 3, 7);
+  tpset.type = trigger::TPSet::Type::kPayload;
+  tpset.start_time = 1000000;
+  tpset.end_time = 1005000;
+  for (size_t i = 0; i < n_tps; ++i) {
+    detdataformats::trigger::TriggerPrimitive tp;
+    tp.time_start = tpset.start_time + 10 * i;
+    tp.time_peak = tp.time_start + 3;
+    tp.time_over_threshold = 8;
+    tp.channel = 100 + i;
+    tp.adc_integral = 2000 + i;
+    tp.adc_peak = 200;
+    tp.detid = 3;
+    tpset.objects.push_back(tp);
+  }
+  return tpset;
+}
+
+void
+check_same(const trigger::TPSet& a, const trigger::TPSet& b)
+{
+  BOOST_CHECK_EQUAL(a.seqno, b.seqno);
+  BOOST_CHECK_EQUAL(a.run_number, b.run_number);
+  BOOST_CHECK_EQUAL(a.origin, b.origin);
+  BOOST_CHECK_EQUAL(a.type, b.type);
+  BOOST_CHECK_EQUAL(a.start_time, b.start_time);
+  BOOST_CHECK_EQUAL(a.end_time, b.end_time);
+  BOOST_REQUIRE_EQUAL(a.objects.size(), b.objects.size());
+  for (size_t i = 0; i < a.objects.size(); ++i) {
+    BOOST_CHECK_EQUAL(a.objects[i].time_start, b.objects[i].time_start);
+    BOOST_CHECK_EQUAL(a.objects[i].time_peak, b.objects[i].time_peak);
+    BOOST_CHECK_EQUAL(a.objects[i].time_over_threshold, b.objects[i].time_over_threshold);
+    BOOST_CHECK_EQUAL(a.objects[i].channel, b.objects[i].channel);
+    BOOST_CHECK_EQUAL(a.objects[i].adc_integral, b.objects[i].adc_integral);
+    BOOST_CHECK_EQUAL(a.objects[i].adc_peak, b.objects[i].adc_peak);
+    BOOST_CHECK_EQUAL(a.objects[i].detid, b.objects[i].detid);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BinaryRoundTrip)
+{
+  for (size_t n_tps : { 0, 1, 100 }) {
+    trigger::TPSet tpset = make_tpset(n_tps);
+    std::vector<uint8_t> bytes(trigger::tpset_binary_size(tpset));
+    trigger::encode_tpset_binary(tpset, bytes.data());
+
+    trigger::TPSet decoded;
+    trigger::decode_tpset_binary(bytes.data(), bytes.size(), decoded);
+    check_same(tpset, decoded);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BinaryBadData)
+{
+  trigger::TPSet tpset = make_tpset(10);
+  std::vector<uint8_t> bytes(trigger::tpset_binary_size(tpset));
+  trigger::encode_tpset_binary(tpset, bytes.data());
+
+  trigger::TPSet decoded;
+  // Truncated TP array
+  BOOST_CHECK_THROW(trigger::decode_tpset_binary(bytes.data(), bytes.size() - 1, decoded), trigger::BadTPSetWireData);
+  // Truncated header
+  BOOST_CHECK_THROW(trigger::decode_tpset_binary(bytes.data(), 10, decoded), trigger::BadTPSetWireData);
+  // Unknown version
+  std::vector<uint8_t> bad_version(bytes);
+  bad_version[4] = 0xff;
+  BOOST_CHECK_THROW(
+    trigger::decode_tpset_binary(bad_version.data(), bad_version.size(), decoded), trigger::BadTPSetWireData);
+  // Not a binary TPSet at all
+  std::vector<uint8_t> bad_magic(bytes);
+  bad_magic[0] = 0;
+  BOOST_CHECK_THROW(trigger::decode_tpset_binary(bad_magic.data(), bad_magic.size(), decoded),
+                    trigger::BadTPSetWireData);
+}
+
+BOOST_AUTO_TEST_CASE(CompressedRoundTrip)
+{
+  std::vector<uint8_t> bytes;
+  for (size_t n_tps : { 0, 1, 100 }) {
+    trigger::TPSet tpset = make_tpset(n_tps);
+    trigger::encode_tpset_compressed(tpset, bytes);
+    BOOST_TEST_MESSAGE(n_tps << " TPs: " << bytes.size() << " bytes compressed, " << trigger::tpset_binary_size(tpset)
+                             << " bytes binary");
+    if (n_tps > 10) {
+      BOOST_CHECK_LT(bytes.size() * 3, trigger::tpset_binary_size(tpset));
+    }
+
+    trigger::TPSet decoded;
+    trigger::decode_tpset_compressed(bytes.data(), bytes.size(), decoded);
+    check_same(tpset, decoded);
+  }
+}
+
+// Unsorted TPs, extreme values and changes in the rarely-changing fields
+// all survive the trip
+BOOST_AUTO_TEST_CASE(CompressedUnusualTPs)
+{
+  std::mt19937_64 gen(42);
+  trigger::TPSet tpset = make_tpset(0);
+  for (size_t i = 0; i < 1000; ++i) {
+    detdataformats::trigger::TriggerPrimitive tp;
+    tp.time_start = gen();
+    tp.time_peak = gen();
+    tp.time_over_threshold = gen();
+    tp.channel = static_cast<detdataformats::trigger::channel_t>(gen());
+    tp.adc_integral = static_cast<uint32_t>(gen());
+    tp.adc_peak = static_cast<uint16_t>(gen());
+    tp.detid = static_cast<detdataformats::trigger::detid_t>(gen() % 3);
+    tp.flag = static_cast<uint16_t>(gen() % 2);
+    tp.version = static_cast<uint16_t>(gen() % 2);
+    tpset.objects.push_back(tp);
+  }
+  tpset.end_time = 0; // before start_time
+
+  std::vector<uint8_t> bytes;
+  trigger::encode_tpset_compressed(tpset, bytes);
+  trigger::TPSet decoded;
+  trigger::decode_tpset_compressed(bytes.data(), bytes.size(), decoded);
+  check_same(tpset, decoded);
+  for (size_t i = 0; i < tpset.objects.size(); ++i) {
+    BOOST_CHECK_EQUAL(tpset.objects[i].flag, decoded.objects[i].flag);
+    BOOST_CHECK_EQUAL(tpset.objects[i].version, decoded.objects[i].version);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CompressedBadData)
+{
+  trigger::TPSet tpset = make_tpset(10);
+  std::vector<uint8_t> bytes;
+  trigger::encode_tpset_compressed(tpset, bytes);
+
+  trigger::TPSet decoded;
+  BOOST_CHECK_THROW(trigger::decode_tpset_compressed(bytes.data(), bytes.size() - 1, decoded),
+                    trigger::BadTPSetWireData);
+  BOOST_CHECK_THROW(trigger::decode_tpset_compressed(bytes.data(), 3, decoded), trigger::BadTPSetWireData);
+  std::vector<uint8_t> bad_version(bytes);
+  bad_version[4] = 0x7f;
+  BOOST_CHECK_THROW(trigger::decode_tpset_compressed(bad_version.data(), bad_version.size(), decoded),
+                    trigger::BadTPSetWireData);
+
+  // decode_tpset_wire picks the right decoder
+  trigger::decode_tpset_wire(bytes.data(), bytes.size(), decoded);
+  check_same(tpset, decoded);
+}
+
+BOOST_AUTO_TEST_CASE(SerializeInEachFormat)
+{
+  trigger::TPSet tpset = make_tpset(100);
+
+  trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kMsgPack);
+  std::vector<uint8_t> msgpack_bytes = serialization::serialize(tpset, serialization::kMsgPack);
+
+  trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kBinary);
+  std::vector<uint8_t> binary_bytes = serialization::serialize(tpset, serialization::kMsgPack);
+  BOOST_CHECK_LT(binary_bytes.size(), trigger::tpset_binary_size(tpset) + 16);
+
+  trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kCompressed);
+  std::vector<uint8_t> compressed_bytes = serialization::serialize(tpset, serialization::kMsgPack);
+  BOOST_CHECK_LT(compressed_bytes.size(), binary_bytes.size());
+
+  // The receiver recognizes all of them, whatever the local setting
+  for (auto format : { trigger::TPSetWireFormat::kMsgPack,
+                       trigger::TPSetWireFormat::kBinary,
+                       trigger::TPSetWireFormat::kCompressed }) {
+    trigger::set_tpset_wire_format(format);
+    check_same(tpset, serialization::deserialize<trigger::TPSet>(msgpack_bytes));
+    check_same(tpset, serialization::deserialize<trigger::TPSet>(binary_bytes));
+    check_same(tpset, serialization::deserialize<trigger::TPSet>(compressed_bytes));
+  }
+
+  // JSON is unaffected by the setting
+  std::vector<uint8_t> json_bytes = serialization::serialize(tpset, serialization::kJSON);
+  check_same(tpset, serialization::deserialize<trigger::TPSet>(json_bytes));
+
+  trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kMsgPack);
+}
+
+// One module choosing a format doesn't change it for the others' threads
+BOOST_AUTO_TEST_CASE(FormatIsPerThread)
+{
+  trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kBinary);
+  trigger::TPSetWireFormat other_thread_format = trigger::TPSetWireFormat::kBinary;
+  std::thread other([&other_thread_format]() { other_thread_format = trigger::get_tpset_wire_format(); });
+  other.join();
+  BOOST_CHECK(other_thread_format == trigger::TPSetWireFormat::kMsgPack);
+  BOOST_CHECK(trigger::get_tpset_wire_format() == trigger::TPSetWireFormat::kBinary);
+
+  trigger::set_tpset_wire_format(trigger::TPSetWireFormat::kMsgPack);
+}
+
+BOOST_AUTO_TEST_CASE(FormatScope)
+{
+  {
+    trigger::TPSetWireFormatScope scope(trigger::TPSetWireFormat::kCompressed);
+    BOOST_CHECK(trigger::get_tpset_wire_format() == trigger::TPSetWireFormat::kCompressed);
+  }
+  BOOST_CHECK(trigger::get_tpset_wire_format() == trigger::TPSetWireFormat::kMsgPack);
+}
+
+// Stands in for the WireFormat enum that moo generates for each module's schema
+enum class ConfWireFormat : unsigned
+{
+  kMsgPack,
+  kBinary,
+  kCompressed
+};
+
+BOOST_AUTO_TEST_CASE(FormatFromConfiguration)
+{
+  BOOST_CHECK(trigger::to_tpset_wire_format(ConfWireFormat::kMsgPack) == trigger::TPSetWireFormat::kMsgPack);
+  BOOST_CHECK(trigger::to_tpset_wire_format(ConfWireFormat::kBinary) == trigger::TPSetWireFormat::kBinary);
+  BOOST_CHECK(trigger::to_tpset_wire_format(ConfWireFormat::kCompressed) == trigger::TPSetWireFormat::kCompressed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
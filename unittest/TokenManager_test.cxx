@@ -6,7 +6,6 @@
  * received with this code.
  */
 
-#include "trigger/LivetimeCounter.hpp"
 #include "trigger/TokenManager.hpp"
 
 #include "iomanager/IOManager.hpp"
@@ -19,6 +18,7 @@
 
 #include "boost/test/unit_test.hpp"
 
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <memory>
@@ -66,8 +66,9 @@ BOOST_AUTO_TEST_CASE(Basics)
 
   int initial_tokens = 10;
   daqdataformats::run_number_t run_number = 1;
-  auto livetime_counter = std::make_shared<trigger::LivetimeCounter>(trigger::LivetimeCounter::State::kPaused);
-  trigger::TokenManager tm("foo", initial_tokens, run_number, livetime_counter);
+  std::atomic<bool> allowed_in_callback{ true };
+  trigger::TokenManager tm(
+    "foo", initial_tokens, run_number, [&allowed_in_callback](bool allowed) { allowed_in_callback = allowed; });
 
   BOOST_CHECK_EQUAL(tm.get_n_tokens(), initial_tokens);
   BOOST_CHECK_EQUAL(tm.triggers_allowed(), true);
@@ -81,6 +82,7 @@ BOOST_AUTO_TEST_CASE(Basics)
   tm.trigger_sent(initial_tokens);
   BOOST_CHECK_EQUAL(tm.get_n_tokens(), 0);
   BOOST_CHECK_EQUAL(tm.triggers_allowed(), false);
+  BOOST_CHECK_EQUAL(allowed_in_callback.load(), false);
 
   // Send a token and check that triggers become allowed again
   dfmessages::TriggerDecisionToken token;
@@ -92,6 +94,44 @@ BOOST_AUTO_TEST_CASE(Basics)
   std::this_thread::sleep_for(100ms);
   BOOST_CHECK_EQUAL(tm.get_n_tokens(), 1);
   BOOST_CHECK_EQUAL(tm.triggers_allowed(), true);
+  BOOST_CHECK_EQUAL(allowed_in_callback.load(), true);
+}
+
+BOOST_AUTO_TEST_CASE(Latency)
+{
+  using namespace std::chrono_literals;
+
+  int initial_tokens = 3;
+  daqdataformats::run_number_t run_number = 2;
+  trigger::TokenManager tm("foo", initial_tokens, run_number);
+
+  for (dfmessages::trigger_number_t i = 1; i <= 3; ++i) {
+    tm.trigger_sent(i);
+  }
+  BOOST_CHECK_EQUAL(tm.triggers_allowed(), false);
+
+  // A decision that couldn't be sent gives its token straight back, without a latency
+  tm.trigger_not_sent(3);
+  BOOST_CHECK_EQUAL(tm.get_n_tokens(), 1);
+
+  std::this_thread::sleep_for(10ms);
+
+  // Tokens for decision 1, for decision 3, which is no longer in flight, and
+  // for a decision that was never sent. All give back a token, but only the
+  // first is a latency
+  for (dfmessages::trigger_number_t trigger_number : { 1, 3, 100 }) {
+    dfmessages::TriggerDecisionToken token;
+    token.run_number = run_number;
+    token.trigger_number = trigger_number;
+    get_iom_sender<dfmessages::TriggerDecisionToken>("foo_s")->send(std::move(token), std::chrono::milliseconds(10));
+  }
+
+  std::this_thread::sleep_for(100ms);
+  BOOST_CHECK_EQUAL(tm.get_n_tokens(), 4);
+  const trigger::LogHistogram& latency = tm.get_latency_histogram();
+  BOOST_CHECK_EQUAL(latency.get_count(), 1);
+  BOOST_CHECK_GE(latency.get_max(), 10000);
+  BOOST_CHECK_LT(latency.get_max(), 1000000);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
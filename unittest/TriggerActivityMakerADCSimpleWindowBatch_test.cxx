@@ -0,0 +1,189 @@
+/**
+ * @file TriggerActivityMakerADCSimpleWindowBatch_test.cxx  Check that
+ * TriggerActivityMakerADCSimpleWindowBatch gives exactly the same output as
+ * triggeralgs::TriggerActivityMakerADCSimpleWindow
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "trigger/TPBatch.hpp"
+#include "trigger/TriggerActivityMakerADCSimpleWindowBatch.hpp"
+
+#include "triggeralgs/ADCSimpleWindow/TriggerActivityMakerADCSimpleWindow.hpp"
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE TriggerActivityMakerADCSimpleWindowBatch_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <random>
+#include <vector>
+
+using namespace dunedaq;
+
+using triggeralgs::TriggerActivity;
+using triggeralgs::TriggerPrimitive;
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+// A time-ordered stream of TPs with a mix of quiet stretches and dense
+// bursts, so that windows both move along and pass threshold
+std::vector<TriggerPrimitive>
+make_tps(size_t n, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<uint64_t> quiet_gap(0, 20000);
+  std::uniform_int_distribution<uint64_t> burst_gap(0, 200);
+  std::uniform_int_distribution<uint32_t> adc(0, 40000);
+  std::uniform_int_distribution<uint32_t> channel(0, 2559);
+  std::bernoulli_distribution toggle_burst(0.01);
+  std::bernoulli_distribution huge_adc(0.001);
+
+  std::vector<TriggerPrimitive> tps(n);
+  uint64_t time = 1000000;
+  bool burst = false;
+  for (auto& tp : tps) {
+    if (toggle_burst(gen)) {
+      burst = !burst;
+    }
+    time += burst ? burst_gap(gen) : quiet_gap(gen);
+    tp.time_start = time;
+    tp.time_over_threshold = burst_gap(gen);
+    tp.time_peak = time + tp.time_over_threshold / 2;
+    tp.channel = channel(gen);
+    // Occasionally enough to make the uint32_t window sum wrap around
+    tp.adc_integral = huge_adc(gen) ? 0xF0000000 + adc(gen) : adc(gen);
+    tp.adc_peak = tp.adc_integral / 20;
+    tp.detid = 3;
+  }
+  return tps;
+}
+
+void
+check_same(const std::vector<TriggerActivity>& expected, const std::vector<TriggerActivity>& actual)
+{
+  BOOST_REQUIRE_EQUAL(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const TriggerActivity& e = expected[i];
+    const TriggerActivity& a = actual[i];
+    BOOST_CHECK_EQUAL(e.time_start, a.time_start);
+    BOOST_CHECK_EQUAL(e.time_end, a.time_end);
+    BOOST_CHECK_EQUAL(e.time_peak, a.time_peak);
+    BOOST_CHECK_EQUAL(e.time_activity, a.time_activity);
+    BOOST_CHECK_EQUAL(e.channel_start, a.channel_start);
+    BOOST_CHECK_EQUAL(e.channel_end, a.channel_end);
+    BOOST_CHECK_EQUAL(e.channel_peak, a.channel_peak);
+    BOOST_CHECK_EQUAL(e.adc_integral, a.adc_integral);
+    BOOST_CHECK_EQUAL(e.adc_peak, a.adc_peak);
+    BOOST_CHECK_EQUAL(e.detid, a.detid);
+    BOOST_CHECK(e.type == a.type);
+    BOOST_CHECK(e.algorithm == a.algorithm);
+    BOOST_REQUIRE_EQUAL(e.inputs.size(), a.inputs.size());
+    for (size_t j = 0; j < e.inputs.size(); ++j) {
+      BOOST_CHECK_EQUAL(e.inputs[j].time_start, a.inputs[j].time_start);
+      BOOST_CHECK_EQUAL(e.inputs[j].channel, a.inputs[j].channel);
+      BOOST_CHECK_EQUAL(e.inputs[j].adc_integral, a.inputs[j].adc_integral);
+    }
+  }
+}
+
+// Run the triggeralgs algorithm one TP at a time, and the batch algorithm
+// on slices of random length with the chosen kernels, and check the outputs match
+void
+compare(const nlohmann::json& config, unsigned seed, bool use_avx2)
+{
+  std::vector<TriggerPrimitive> tps = make_tps(100000, seed);
+
+  triggeralgs::TriggerActivityMakerADCSimpleWindow reference;
+  reference.configure(config);
+  std::vector<TriggerActivity> expected;
+  for (const auto& tp : tps) {
+    reference(tp, expected);
+  }
+
+  trigger::TriggerActivityMakerADCSimpleWindowBatch batch_maker;
+  batch_maker.configure(config);
+  BOOST_REQUIRE_EQUAL(batch_maker.set_use_avx2(use_avx2), use_avx2);
+  std::vector<TriggerActivity> actual;
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<size_t> slice_size(0, 300);
+  trigger::TPBatch batch;
+  for (size_t first = 0; first < tps.size();) {
+    size_t last = std::min(tps.size(), first + slice_size(gen));
+    std::vector<TriggerPrimitive> slice(tps.begin() + first, tps.begin() + last);
+    batch.assign(slice);
+    batch_maker.process_batch(batch, actual);
+    first = last;
+  }
+
+  BOOST_TEST_MESSAGE("Made " << expected.size() << " TAs" << (use_avx2 ? " with AVX2" : " without AVX2"));
+  BOOST_CHECK(expected.size() > 0);
+  check_same(expected, actual);
+}
+
+// Compare with the plain C++ kernels, and with the AVX2 ones if this CPU has them
+void
+compare_all_kernels(const nlohmann::json& config, unsigned seed)
+{
+  compare(config, seed, false);
+  if (trigger::TriggerActivityMakerADCSimpleWindowBatch::avx2_supported()) {
+    compare(config, seed, true);
+  } else {
+    BOOST_TEST_MESSAGE("No AVX2 on this CPU, so the AVX2 kernels aren't tested");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DefaultConfig)
+{
+  compare_all_kernels(nlohmann::json::object(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(LowThreshold)
+{
+  compare_all_kernels(nlohmann::json{ { "window_length", 50000 }, { "adc_threshold", 200000 } }, 2);
+}
+
+BOOST_AUTO_TEST_CASE(ShortWindow)
+{
+  compare_all_kernels(nlohmann::json{ { "window_length", 1000 }, { "adc_threshold", 30000 } }, 3);
+}
+
+// Per-TP and batch calls can be mixed on one maker
+BOOST_AUTO_TEST_CASE(MixedCalls)
+{
+  nlohmann::json config{ { "window_length", 50000 }, { "adc_threshold", 200000 } };
+  std::vector<TriggerPrimitive> tps = make_tps(20000, 4);
+
+  triggeralgs::TriggerActivityMakerADCSimpleWindow reference;
+  reference.configure(config);
+  std::vector<TriggerActivity> expected;
+  for (const auto& tp : tps) {
+    reference(tp, expected);
+  }
+
+  trigger::TriggerActivityMakerADCSimpleWindowBatch batch_maker;
+  batch_maker.configure(config);
+  std::vector<TriggerActivity> actual;
+  trigger::TPBatch batch;
+  const size_t slice_size = 100;
+  for (size_t first = 0; first < tps.size(); first += slice_size) {
+    size_t last = std::min(tps.size(), first + slice_size);
+    if ((first / slice_size) % 2 == 0) {
+      std::vector<TriggerPrimitive> slice(tps.begin() + first, tps.begin() + last);
+      batch.assign(slice);
+      batch_maker.process_batch(batch, actual);
+    } else {
+      for (size_t i = first; i < last; ++i) {
+        batch_maker(tps[i], actual);
+      }
+    }
+  }
+
+  check_same(expected, actual);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
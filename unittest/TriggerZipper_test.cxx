@@ -24,6 +24,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -159,4 +160,44 @@ BOOST_AUTO_TEST_CASE(ZipperScenario1)
   zip.reset(nullptr);
 }
 
+BOOST_AUTO_TEST_CASE(ZippersConnectedLocally)
+{
+  // Two zippers in one application, joined by a local connection instead of an iomanager queue
+  auto in = trigger::get_output_connection<trigger::TPSet>("spsc:zipper1_input");
+  auto out = trigger::get_input_connection<trigger::TPSet>("spsc:zipper2_output");
+
+  auto zip1 = std::make_unique<trigger::TPZipper>("zl1");
+  zip1->set_input("spsc:zipper1_input");
+  zip1->set_output("spsc:zipper_link");
+  auto zip2 = std::make_unique<trigger::TPZipper>("zl2");
+  zip2->set_input("spsc:zipper_link");
+  zip2->set_output("spsc:zipper2_output");
+
+  nlohmann::json jcfg1 = trigger::TPZipper::cfg_t{ 2, 100, 1, 20 };
+  nlohmann::json jcfg2 = trigger::TPZipper::cfg_t{ 1, 100, 2, 30 };
+  nlohmann::json jempty;
+  zip1->do_configure(jcfg1);
+  zip2->do_configure(jcfg2);
+  zip2->do_start(jempty);
+  zip1->do_start(jempty);
+
+  TPSetSrc s1{ 1 }, s2{ 2 };
+  for (auto tpset : { s1(10), s2(12), s1(11), s2(13), s1(14) }) {
+    BOOST_REQUIRE(in->try_send(std::move(tpset), std::chrono::milliseconds(0)));
+  }
+
+  // Stopping the first zipper flushes everything it has through the second
+  zip1->do_stop(jempty);
+  zip2->do_stop(jempty);
+
+  for (trigger::TPSet::timestamp_t start_time : { 10, 11, 12, 13, 14 }) {
+    std::optional<trigger::TPSet> got = out->try_receive(std::chrono::milliseconds(1000));
+    BOOST_REQUIRE(got.has_value());
+    BOOST_CHECK_EQUAL(got->start_time, start_time);
+    BOOST_CHECK_EQUAL(got->origin.region_id, 2);
+    BOOST_CHECK_EQUAL(got->origin.element_id, 30);
+  }
+  BOOST_CHECK(!out->try_receive(std::chrono::milliseconds(0)).has_value());
+}
+
 BOOST_AUTO_TEST_SUITE_END()